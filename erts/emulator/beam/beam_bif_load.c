@@ -38,8 +38,6 @@ static void delete_code(Process *c_p, ErtsProcLocks c_p_locks, Module* modp);
 static void delete_export_references(Eterm module);
 static int purge_module(int module);
 static int is_native(Eterm* code);
-static int any_heap_ref_ptrs(Eterm* start, Eterm* end, char* mod_start, Uint mod_size);
-static int any_heap_refs(Eterm* start, Eterm* end, char* mod_start, Uint mod_size);
 
 Eterm
 load_module_2(BIF_ALIST_2)
@@ -296,10 +294,9 @@ static Eterm
 check_process_code(Process* rp, Module* modp)
 {
     Eterm* start;
-    char* mod_start;
-    Uint mod_size;
     Eterm* end;
     Eterm* sp;
+    Eterm* literals;
 #ifndef HYBRID /* FIND ME! */
     ErlFunThing* funp;
     int done_gc = 0;
@@ -317,8 +314,6 @@ check_process_code(Process* rp, Module* modp)
      */
     start = modp->old_code;
     end = (Eterm *)((char *)start + modp->old_code_length);
-    mod_start = (char *) start;
-    mod_size = modp->old_code_length;
 
     /*
      * Check if current instruction or continuation pointer points into module.
@@ -396,120 +391,24 @@ check_process_code(Process* rp, Module* modp)
 #endif
 
     /*
-     * See if there are constants inside the module referenced by the process.
+     * See if the process refers to constants of the module. If so, the
+     * process keeps the literal area alive after the code has been purged
+     * (until a fullsweep garbage collection shows that it is no longer
+     * referred to), so the constants need not be copied to its heap.
      */
-    done_gc = 0;
-    for (;;) {
-	ErlMessage* mp;
+    literals = (Eterm *) modp->old_code[MI_LITERALS_START];
+    if (literals != NULL) {
+	char* lit_start = (char *) literals;
+	Uint lit_size = (char *) modp->old_code[MI_LITERALS_END] - lit_start;
 
-	if (any_heap_ref_ptrs(&rp->fvalue, &rp->fvalue+1, mod_start, mod_size)) {
-	    rp->freason = EXC_NULL;
-	    rp->fvalue = NIL;
-	    rp->ftrace = NIL;
-	}
-	if (any_heap_ref_ptrs(rp->stop, rp->hend, mod_start, mod_size)) {
-	    goto need_gc;
-	}
-	if (any_heap_refs(rp->heap, rp->htop, mod_start, mod_size)) {
-	    goto need_gc;
-	}
-
-	if (any_heap_refs(rp->old_heap, rp->old_htop, mod_start, mod_size)) {
-	    goto need_gc;
-	}
-
-	if (rp->dictionary != NULL) {
-	    Eterm* start = rp->dictionary->data;
-	    Eterm* end = start + rp->dictionary->used;
-
-	    if (any_heap_ref_ptrs(start, end, mod_start, mod_size)) {
-		goto need_gc;
-	    }
-	}
-
-	for (mp = rp->msg.first; mp != NULL; mp = mp->next) {
-	    if (any_heap_ref_ptrs(mp->m, mp->m+2, mod_start, mod_size)) {
-		goto need_gc;
-	    }
-	}
-	break;
-
-    need_gc:
-	if (done_gc) {
-	    return am_true;
-	} else {
-	    Eterm* literals;
-	    Uint lit_size;
-
-	    /*
-	     * Try to get rid of constants by by garbage collecting.
-	     * Clear both fvalue and ftrace.
-	     */
-	    rp->freason = EXC_NULL;
-	    rp->fvalue = NIL;
-	    rp->ftrace = NIL;
-	    done_gc = 1;
-	    FLAGS(rp) |= F_NEED_FULLSWEEP;
-	    (void) erts_garbage_collect(rp, 0, rp->arg_reg, rp->arity);
-	    literals = (Eterm *) modp->old_code[MI_LITERALS_START];
-	    lit_size = (Eterm *) modp->old_code[MI_LITERALS_END] - literals;
-	    erts_garbage_collect_literals(rp, literals, lit_size);
+	if (erts_proc_refers_to_area(rp, lit_start, lit_size)) {
+	    erts_add_literal_ref(rp, ERTS_LITERAL_AREA_FROM_START(literals));
 	}
     }
     return am_false;
 #undef INSIDE
 }
 
-#define in_area(ptr,start,nbytes) \
-    ((unsigned long)((char*)(ptr) - (char*)(start)) < (nbytes))
-
-static int
-any_heap_ref_ptrs(Eterm* start, Eterm* end, char* mod_start, Uint mod_size)
-{
-    Eterm* p;
-    Eterm val;
-
-    for (p = start; p < end; p++) {
-	val = *p;
-	switch (primary_tag(val)) {
-	case TAG_PRIMARY_BOXED:
-	case TAG_PRIMARY_LIST:
-	    if (in_area(val, mod_start, mod_size)) {
-		return 1;
-	    }
-	    break;
-	}
-    }
-    return 0;
-}
-
-static int
-any_heap_refs(Eterm* start, Eterm* end, char* mod_start, Uint mod_size)
-{
-    Eterm* p;
-    Eterm val;
-
-    for (p = start; p < end; p++) {
-	val = *p;
-	switch (primary_tag(val)) {
-	case TAG_PRIMARY_BOXED:
-	case TAG_PRIMARY_LIST:
-	    if (in_area(val, mod_start, mod_size)) {
-		return 1;
-	    }
-	    break;
-	case TAG_PRIMARY_HEADER:
-	    if (!header_is_transparent(val)) {
-		Eterm* new_p = p + thing_arityval(val);
-		ASSERT(start <= new_p && new_p < end);
-		p = new_p;
-	    }
-	}
-    }
-    return 0;
-}
-
-#undef in_area
 
 
 static int
@@ -548,6 +447,10 @@ purge_module(int module)
     end = (Eterm *)((char *)code + modp->old_code_length);
     erts_cleanup_funs_on_purge(code, end);
     beam_catches_delmod(modp->old_catches, code, modp->old_code_length);
+    if (code[MI_LITERALS_START] != (Eterm) NULL) {
+	Eterm* literals = (Eterm *) code[MI_LITERALS_START];
+	erts_release_literal_area(ERTS_LITERAL_AREA_FROM_START(literals));
+    }
     erts_free(ERTS_ALC_T_CODE, (void *) code);
     modp->old_code = NULL;
     modp->old_code_length = 0;
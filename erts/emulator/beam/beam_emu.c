@@ -417,6 +417,27 @@ extern int count_instructions;
     }                                                           \
   } while (0)
 
+/*
+ * Check if Nh words of heap are available and if VNh words of binary
+ * data fit in the virtual binary heap; if not, do a garbage collection.
+ * Live is number of active argument registers to be preserved.
+ */
+
+#define TestBinVHeap(VNh, Nh, Live)                             \
+  do {                                                          \
+    unsigned need = (Nh);                                       \
+    if ((E - HTOP < need) ||                                    \
+        (MSO(c_p).overhead + (VNh) > BIN_VHEAP_SZ(c_p))) {      \
+       SWAPOUT;                                                 \
+       reg[0] = r(0);                                           \
+       PROCESS_MAIN_CHK_LOCKS(c_p);                             \
+       FCALLS -= erts_garbage_collect(c_p, need, reg, (Live));  \
+       PROCESS_MAIN_CHK_LOCKS(c_p);                             \
+       r(0) = reg[0];                                           \
+       SWAPIN;                                                  \
+    }                                                           \
+  } while (0)
+
 /*
  * Check if Nh words of heap are available; if not, do a garbage collection.
  * Live is number of active argument registers to be preserved.
@@ -3138,10 +3159,11 @@ void process_main(void)
      }
      if (num_bytes <= ERL_ONHEAP_BIN_LIMIT) {
 	 alloc += heap_bin_size(num_bytes);
+	 TestHeap(alloc, Arg(1));
      } else {
 	 alloc += PROC_BIN_SIZE;
+	 TestBinVHeap(num_bytes/sizeof(Eterm), alloc, Arg(1));
      }
-     TestHeap(alloc, Arg(1));
 
      /* num_bits = Number of bits to build
       * num_bytes = Number of bytes to allocate in the binary
@@ -3204,7 +3226,7 @@ void process_main(void)
 	 pb->val = bptr;
 	 pb->bytes = (byte*) bptr->orig_bytes;
 	 pb->flags = 0;
-	 MSO(c_p).overhead += pb->size / BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+	 MSO(c_p).overhead += pb->size / sizeof(Eterm);
 	 new_binary = make_binary(pb);
 	 goto do_bits_sub_bin;
      }
@@ -3281,7 +3303,8 @@ void process_main(void)
 
 	 erts_bin_offset = 0;
 	 erts_writable_bin = 0;
-	 TestHeap(tmp_arg2 + PROC_BIN_SIZE + ERL_SUB_BIN_SIZE, Arg(1));
+	 TestBinVHeap(tmp_arg1/sizeof(Eterm),
+		      tmp_arg2 + PROC_BIN_SIZE + ERL_SUB_BIN_SIZE, Arg(1));
 
 	 /*
 	  * Allocate the binary struct itself.
@@ -3305,7 +3328,7 @@ void process_main(void)
 	 pb->bytes = (byte*) bptr->orig_bytes;
 	 pb->flags = 0;
 
-	 MSO(c_p).overhead += pb->size / BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+	 MSO(c_p).overhead += pb->size / sizeof(Eterm);
 	 StoreBifResult(2, make_binary(pb));
      }
 
@@ -323,6 +323,7 @@ typedef struct {
     Literal* literals;		/* Array of literals. */
     LiteralPatch* literal_patches; /* Operands that need to be patched. */
     Uint total_literal_size;	/* Total heap size for all literals. */
+    ErtsLiteralArea* literal_area; /* Final location of the literals. */
 
     /*
      * Floating point.
@@ -525,6 +526,7 @@ int allocated_modules;	    /* Number of slots allocated. */
 Range* mid_module = NULL;   /* Cached search start point */
 
 Uint erts_total_code_size;
+erts_smp_atomic_t erts_total_literal_size;
 /**********************************************************************/
 
 
@@ -533,6 +535,7 @@ void init_load(void)
     FloatDef f;
 
     erts_total_code_size = 0;
+    erts_smp_atomic_init(&erts_total_literal_size, 0);
 
     beam_catches_init();
 
@@ -546,6 +549,52 @@ void init_load(void)
     num_loaded_modules = 0;
 }
 
+/*
+ * Make the process p keep the literal area alive. Called when code is
+ * about to be purged while p still refers to its literals.
+ */
+void
+erts_add_literal_ref(Process* p, ErtsLiteralArea* lap)
+{
+    ErtsLiteralRef* ref;
+
+    for (ref = p->literal_refs; ref != NULL; ref = ref->next) {
+	if (ref->area == lap) {
+	    return;
+	}
+    }
+    ref = (ErtsLiteralRef *) erts_alloc(ERTS_ALC_T_LITERAL_REF,
+					sizeof(ErtsLiteralRef));
+    erts_refc_inc(&lap->refc, 2);
+    ref->area = lap;
+    ref->next = p->literal_refs;
+    p->literal_refs = ref;
+}
+
+void
+erts_cleanup_literal_refs(Process* p)
+{
+    ErtsLiteralRef* ref = p->literal_refs;
+
+    while (ref != NULL) {
+	ErtsLiteralRef* next = ref->next;
+	erts_release_literal_area(ref->area);
+	erts_free(ERTS_ALC_T_LITERAL_REF, (void *) ref);
+	ref = next;
+    }
+    p->literal_refs = NULL;
+}
+
+void
+erts_release_literal_area(ErtsLiteralArea* lap)
+{
+    if (erts_refc_dectest(&lap->refc, 0) == 0) {
+	erts_smp_atomic_add(&erts_total_literal_size,
+			    -((long) (lap->size * sizeof(Eterm))));
+	erts_free(ERTS_ALC_T_LITERAL_AREA, (void *) lap);
+    }
+}
+
 static void
 define_file(LoaderState* stp, char* name, int idx)
 {
@@ -698,12 +747,16 @@ bin_load(Process *c_p, ErtsProcLocks c_p_locks,
      */
     rval = 0;
     state.code = NULL;		/* Prevent code from being freed. */
+    state.literal_area = NULL;
     *modp = state.module;
 
  load_error:
     if (state.code != 0) {
 	erts_free(ERTS_ALC_T_CODE, state.code);
     }
+    if (state.literal_area != NULL) {
+	erts_release_literal_area(state.literal_area);
+    }
     if (state.labels != NULL) {
 	erts_free(ERTS_ALC_T_LOADER_TMP, (void *) state.labels);
     }
@@ -771,6 +824,7 @@ init_state(LoaderState* stp)
     stp->literals = 0;
     stp->total_literal_size = 0;
     stp->literal_patches = 0;
+    stp->literal_area = NULL;
     stp->string_patches = 0;
     stp->new_float_instructions = 0;
 }
@@ -3360,8 +3414,7 @@ freeze_code(LoaderState* stp)
      * Calculate the final size of the code.
      */
 
-    size = (stp->ci + stp->total_literal_size) * sizeof(Eterm) +
-	strtab_size + attr_size + compile_size;
+    size = stp->ci * sizeof(Eterm) + strtab_size + attr_size + compile_size;
 
     /*
      * Move the code to its final location.
@@ -3378,16 +3431,29 @@ freeze_code(LoaderState* stp)
 
 
     /*
-     * Place the literal heap directly after the code and fix up all
+     * Place the literal heap in a literal area of its own and fix up all
      * put_literal instructions that refer to it.
      */
-    {
+    if (stp->total_literal_size == 0) {
+	code[MI_LITERALS_START] = (Eterm) NULL;
+	code[MI_LITERALS_END] = (Eterm) NULL;
+    } else {
 	Eterm* ptr;
 	Eterm* low;
 	Eterm* high;
 	LiteralPatch* lp;
-
-	low = code+stp->ci;
+	ErtsLiteralArea* lap;
+
+	lap = (ErtsLiteralArea *)
+	    erts_alloc(ERTS_ALC_T_LITERAL_AREA,
+		       ERTS_LITERAL_AREA_ALLOC_SIZE(stp->total_literal_size));
+	erts_refc_init(&lap->refc, 1);
+	lap->size = stp->total_literal_size;
+	erts_smp_atomic_add(&erts_total_literal_size,
+			    (long) (lap->size * sizeof(Eterm)));
+	stp->literal_area = lap;
+
+	low = lap->start;
 	high = low + stp->total_literal_size;
 	code[MI_LITERALS_START] = (Eterm) low;
 	code[MI_LITERALS_END] = (Eterm) high;
@@ -3435,11 +3501,10 @@ freeze_code(LoaderState* stp)
 	    op_ptr[0] = literal;
 	    lp = lp->next;
 	}
-	stp->ci += stp->total_literal_size;
     }
     
     /*
-     * Place the string table and, optionally, attributes, after the literal heap.
+     * Place the string table and, optionally, attributes, after the code.
      */
 
     sys_memcpy(code+stp->ci, stp->chunks[STR_CHUNK].start, strtab_size);
@@ -5031,6 +5096,8 @@ erts_make_stub_module(Process* p, Eterm Mod, Eterm Beam, Eterm Info)
     code[MI_COMPILE_PTR] = 0;
     code[MI_COMPILE_SIZE_ON_HEAP] = 0;
     code[MI_NUM_BREAKPOINTS] = 0;
+    code[MI_LITERALS_START] = (Eterm) NULL;
+    code[MI_LITERALS_END] = (Eterm) NULL;
     ci = MI_FUNCTIONS + n + 1;
 
     /*
@@ -20,6 +20,7 @@
 #ifndef _BEAM_LOAD_H
 #  define _BEAM_LOAD_H
 
+#include <stddef.h> /* offsetof() */
 #include "beam_opcodes.h"
 #include "erl_process.h"
 
@@ -66,6 +67,36 @@ extern Range* mid_module;
 
 /* Total code size in bytes */
 extern Uint erts_total_code_size;
+
+/*
+ * The literals (constant pool) of a module are kept in an area of their
+ * own. The area is reference counted: the loaded code holds one reference,
+ * and each process still referring to literals when the code is purged
+ * holds one until a fullsweep garbage collection (or exit) shows that it
+ * no longer does. Purging code therefore never copies literals.
+ */
+typedef struct {
+    erts_refc_t refc;
+    Uint size;			/* Size of literals in words. */
+    Eterm start[1];		/* Beginning of the literals. */
+} ErtsLiteralArea;
+
+#define ERTS_LITERAL_AREA_ALLOC_SIZE(N) \
+    (sizeof(ErtsLiteralArea) + sizeof(Eterm)*((N) - 1))
+#define ERTS_LITERAL_AREA_FROM_START(S) \
+    ((ErtsLiteralArea *) (((char *) (S)) - offsetof(ErtsLiteralArea, start)))
+
+typedef struct erts_literal_ref {
+    struct erts_literal_ref* next;
+    ErtsLiteralArea* area;
+} ErtsLiteralRef;
+
+/* Total size of literal areas in bytes */
+extern erts_smp_atomic_t erts_total_literal_size;
+
+void erts_add_literal_ref(Process* p, ErtsLiteralArea* lap);
+void erts_release_literal_area(ErtsLiteralArea* lap);
+
 /*
  * Index into start of code chunks which contains additional information
  * about the loaded module.
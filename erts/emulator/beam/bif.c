@@ -808,6 +808,7 @@ BIF_RETTYPE spawn_opt_1(BIF_ALIST_1)
      */
     so.flags = SPO_USE_ARGS;
     so.min_heap_size = H_MIN_SIZE;
+    so.min_vheap_size = BIN_VH_MIN_SIZE;
     so.priority = PRIORITY_NORMAL;
     so.max_gen_gcs = (Uint16) erts_smp_atomic_read(&erts_max_gen_gcs);
     so.scheduler = 0;
@@ -849,6 +850,15 @@ BIF_RETTYPE spawn_opt_1(BIF_ALIST_1)
 		} else {
 		    so.min_heap_size = erts_next_heap_size(min_heap_size, 0);
 		}
+	    } else if (arg == am_min_bin_vheap_size && is_small(val)) {
+		Sint min_vheap_size = signed_val(val);
+		if (min_vheap_size < 0) {
+		    goto error;
+		} else if (min_vheap_size < H_MIN_SIZE) {
+		    so.min_vheap_size = H_MIN_SIZE;
+		} else {
+		    so.min_vheap_size = erts_next_heap_size(min_vheap_size, 0);
+		}
 	    } else if (arg == am_fullsweep_after && is_small(val)) {
 		Sint max_gen_gcs = signed_val(val);
 		if (max_gen_gcs < 0) {
@@ -3767,6 +3777,46 @@ BIF_RETTYPE system_flag_2(BIF_ALIST_2)
 	}
 	H_MIN_SIZE = erts_next_heap_size(n, 0);
 	BIF_RET(make_small(oval));
+    } else if (BIF_ARG_1 == am_min_bin_vheap_size) {
+	int oval = BIN_VH_MIN_SIZE;
+	if (!is_small(BIF_ARG_2) || (n = signed_val(BIF_ARG_2)) < 0) {
+	    goto error;
+	}
+	BIN_VH_MIN_SIZE = erts_next_heap_size(n, 0);
+	BIF_RET(make_small(oval));
+    } else if (BIF_ARG_1 == am_heap_size_hint) {
+	Eterm* tp;
+	Eterm* mfa;
+	Export* ep;
+	Eterm res;
+	if (!is_tuple_arity(BIF_ARG_2, 2)) {
+	    goto error;
+	}
+	tp = tuple_val(BIF_ARG_2);
+	if (!is_tuple_arity(tp[1], 3)) {
+	    goto error;
+	}
+	mfa = tuple_val(tp[1]);
+	if (!is_atom(mfa[1]) || !is_atom(mfa[2]) || !is_small(mfa[3])
+	    || signed_val(mfa[3]) < 0) {
+	    goto error;
+	}
+	if (tp[2] == am_learned) {
+	    n = -1;
+	} else if (!is_small(tp[2]) || (n = signed_val(tp[2])) < 0) {
+	    goto error;
+	}
+	ep = erts_export_get_or_make_stub(mfa[1], mfa[2], unsigned_val(mfa[3]));
+	res = erts_heap_size_hint_term(BIF_P, ep);
+	if (n < 0) {
+	    ep->heap_hint_fixed = 0;
+	    erts_smp_atomic_set(&ep->heap_hint, 0);
+	} else {
+	    erts_smp_atomic_set(&ep->heap_hint,
+				n ? (long) erts_next_heap_size(n, 0) : 0);
+	    ep->heap_hint_fixed = 1;
+	}
+	BIF_RET(res);
     } else if (BIF_ARG_1 == am_display_items) {
 	int oval = display_items;
 	if (!is_small(BIF_ARG_2) || (n = signed_val(BIF_ARG_2)) < 0) {
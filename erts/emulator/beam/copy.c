@@ -322,8 +322,7 @@ copy_struct(Eterm obj, Uint sz, Eterm** hpp, ErlOffHeap* off_heap)
 		    pb->next = off_heap->mso;
 		    pb->flags = 0;
 		    off_heap->mso = pb;
-		    off_heap->overhead += pb->size /
-		      BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+		    off_heap->overhead += pb->size / sizeof(Eterm);
 		}
 		break;
 	    case SUB_BINARY_SUBTAG:
@@ -372,8 +371,7 @@ copy_struct(Eterm obj, Uint sz, Eterm** hpp, ErlOffHeap* off_heap)
 			to->next = off_heap->mso;
 			to->flags = 0;
 			off_heap->mso = to;
-			off_heap->overhead += to->size /
-			  BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+			off_heap->overhead += to->size / sizeof(Eterm);
 		    }
 		    *argp = make_binary(hbot);
 		    if (extra_bytes != 0) {
@@ -659,8 +657,7 @@ Eterm copy_struct_lazy(Process *from, Eterm orig, Uint offs)
                 erts_refc_inc(&pb->val->refc, 2);
                 pb->next = erts_global_offheap.mso;
                 erts_global_offheap.mso = pb;
-                erts_global_offheap.overhead += pb->size /
-                    BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+                erts_global_offheap.overhead += pb->size / sizeof(Eterm);
                 continue;
             }
 
@@ -785,8 +782,7 @@ Eterm copy_struct_lazy(Process *from, Eterm orig, Uint offs)
                     to_bin->bytes = from_bin->bytes + sub_offset;
                     to_bin->next = erts_global_offheap.mso;
                     erts_global_offheap.mso = to_bin;
-                    erts_global_offheap.overhead += to_bin->size /
-                        BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+                    erts_global_offheap.overhead += to_bin->size / sizeof(Eterm);
 		    res_binary=make_binary(to_bin);
 		    hp += PROC_BIN_SIZE;
                 }
@@ -115,7 +115,7 @@ Export* dmonitor_p_trap = NULL;
 /* forward declarations */
 
 static void clear_dist_entry(DistEntry*);
-static int dsig_send(ErtsDSigData *, Eterm, Eterm, int);
+static int dsig_send(ErtsDSigData *, Eterm, Eterm, Eterm, int);
 static void send_nodes_mon_msgs(Process *, Eterm, Eterm, Eterm, Eterm);
 static void init_nodes_monitors(void);
 
@@ -133,18 +133,18 @@ delete_cache(ErtsAtomCache *cache)
 
 
 static void
-create_cache(DistEntry *dep)
+create_cache(ErtsDistStripe *sp)
 {
     int i;
     ErtsAtomCache *cp;
 
     ERTS_SMP_LC_ASSERT(
-	is_internal_port(dep->cid)
-	&& erts_lc_is_port_locked(&erts_port[internal_port_index(dep->cid)]));
-    ASSERT(!dep->cache);
+	is_internal_port(sp->cid)
+	&& erts_lc_is_port_locked(&erts_port[internal_port_index(sp->cid)]));
+    ASSERT(!sp->cache);
 
-    dep->cache = cp = (ErtsAtomCache*) erts_alloc(ERTS_ALC_T_DCACHE,
-						  sizeof(ErtsAtomCache));
+    sp->cache = cp = (ErtsAtomCache*) erts_alloc(ERTS_ALC_T_DCACHE,
+						 sizeof(ErtsAtomCache));
     erts_smp_atomic_inc(&no_caches);
     for (i = 0; i < sizeof(cp->in_arr)/sizeof(cp->in_arr[0]); i++) {
 	cp->in_arr[i] = THE_NON_VALUE;
@@ -158,19 +158,19 @@ Uint erts_dist_cache_size(void)
 }
 
 static ErtsProcList *
-get_suspended_on_de(DistEntry *dep, Uint32 unset_qflgs)
+get_suspended_on_stripe(ErtsDistStripe *sp, Uint32 unset_qflgs)
 {
-    ERTS_SMP_LC_ASSERT(erts_smp_lc_spinlock_is_locked(&dep->qlock));
-    dep->qflgs &= ~unset_qflgs;
-    if (dep->qflgs & ERTS_DE_QFLG_EXIT) {
+    ERTS_SMP_LC_ASSERT(erts_smp_lc_spinlock_is_locked(&sp->qlock));
+    sp->qflgs &= ~unset_qflgs;
+    if (sp->qflgs & ERTS_DE_QFLG_EXIT) {
 	/* No resume when exit has been scheduled */
 	return NULL;
     }
     else {
 	ErtsProcList *plp;
-	plp = dep->suspended.first;
-	dep->suspended.first = NULL;
-	dep->suspended.last = NULL;
+	plp = sp->suspended.first;
+	sp->suspended.first = NULL;
+	sp->suspended.last = NULL;
 	return plp;
     }
 }
@@ -439,28 +439,28 @@ int erts_do_net_exits(DistEntry *dep, Eterm reason)
 	ErtsMonitor *monitors;
 	Uint32 flags;
 
-	erts_smp_atomic_set(&dep->dist_cmd_scheduled, 1);
+	erts_smp_atomic_set(&dep->primary.dist_cmd_scheduled, 1);
 	erts_smp_de_rwlock(dep);
 
 	ERTS_SMP_LC_ASSERT(is_internal_port(dep->cid)
 			   && erts_lc_is_port_locked(&erts_port[internal_port_index(dep->cid)]));
 
-	if (erts_port_task_is_scheduled(&dep->dist_cmd))
-	    erts_port_task_abort(dep->cid, &dep->dist_cmd);
+	if (erts_port_task_is_scheduled(&dep->primary.dist_cmd))
+	    erts_port_task_abort(dep->cid, &dep->primary.dist_cmd);
 
 	if (dep->status & ERTS_DE_SFLG_EXITING) {
 #ifdef DEBUG
-	    erts_smp_spin_lock(&dep->qlock);
-	    ASSERT(dep->qflgs & ERTS_DE_QFLG_EXIT);
-	    erts_smp_spin_unlock(&dep->qlock);
+	    erts_smp_spin_lock(&dep->primary.qlock);
+	    ASSERT(dep->primary.qflgs & ERTS_DE_QFLG_EXIT);
+	    erts_smp_spin_unlock(&dep->primary.qlock);
 #endif
 	}
 	else {
 	    dep->status |= ERTS_DE_SFLG_EXITING;
-	    erts_smp_spin_lock(&dep->qlock);
-	    ASSERT(!(dep->qflgs & ERTS_DE_QFLG_EXIT));
-	    dep->qflgs |= ERTS_DE_QFLG_EXIT;
-	    erts_smp_spin_unlock(&dep->qlock);
+	    erts_smp_spin_lock(&dep->primary.qlock);
+	    ASSERT(!(dep->primary.qflgs & ERTS_DE_QFLG_EXIT));
+	    dep->primary.qflgs |= ERTS_DE_QFLG_EXIT;
+	    erts_smp_spin_unlock(&dep->primary.qlock);
 	}
 
 	erts_smp_de_links_lock(dep);
@@ -532,6 +532,8 @@ alloc_dist_obuf(Uint size)
     erts_refc_init(&bin->refc, 1);
     bin->orig_size = (long) obuf_size;
     obuf = (ErtsDistOutputBuf *) &bin->orig_bytes[0];
+    obuf->bin_refs = NULL;
+    obuf->frag_of = NULL;
 #ifdef DEBUG
     obuf->dbg_pattern = ERTS_DIST_OUTPUT_BUF_DBG_PATTERN;
     ASSERT(bin == ErtsDistOutputBuf2Binary(obuf));
@@ -544,6 +546,22 @@ free_dist_obuf(ErtsDistOutputBuf *obuf)
 {
     Binary *bin = ErtsDistOutputBuf2Binary(obuf);
     ASSERT(obuf->dbg_pattern == ERTS_DIST_OUTPUT_BUF_DBG_PATTERN);
+    /*
+     * A port may keep the buffer or the binaries that it refers to
+     * after we are done with them, but then it has references of its
+     * own to them.
+     */
+    if (obuf->frag_of
+	&& erts_refc_dectest(&obuf->frag_of->frag_refc, 0) == 0)
+	free_dist_obuf(obuf->frag_of);
+    if (obuf->bin_refs) {
+	ErtsDistBinRefs *refs = obuf->bin_refs;
+	Uint i;
+	for (i = 0; i < refs->no; i++)
+	    if (erts_refc_dectest(&refs->ref[i].bin->refc, 0) == 0)
+		erts_bin_free(refs->ref[i].bin);
+	erts_free(ERTS_ALC_T_DIST_BIN_REFS, (void *) refs);
+    }
     if (erts_refc_dectest(&bin->refc, 0) == 0)
 	erts_bin_free(bin);
 }
@@ -552,7 +570,45 @@ static ERTS_INLINE Sint
 size_obuf(ErtsDistOutputBuf *obuf)
 {
     Binary *bin = ErtsDistOutputBuf2Binary(obuf);
-    return bin->orig_size;
+    return (bin->orig_size
+	    + (obuf->frag_of ? obuf->frag_size : 0)
+	    + (obuf->bin_refs ? obuf->bin_refs->size : 0));
+}
+
+/* The connection that a distribution port is the port of */
+static ERTS_INLINE ErtsDistStripe *
+dist_port_stripe(Port *prt)
+{
+    ASSERT(prt->dist_entry);
+    return prt->dist_stripe ? prt->dist_stripe : &prt->dist_entry->primary;
+}
+
+static void
+free_dist_streams(ErtsDistOutputStream *stream)
+{
+    while (stream) {
+	ErtsDistOutputStream *fstream = stream;
+	ErtsDistOutputBuf *obuf = stream->queue.first;
+	while (obuf) {
+	    ErtsDistOutputBuf *fobuf = obuf;
+	    obuf = obuf->next;
+	    free_dist_obuf(fobuf);
+	}
+	erts_resume_processes(stream->suspended.first);
+	stream = stream->next;
+	erts_free(ERTS_ALC_T_DIST_STREAM, (void *) fstream);
+    }
+}
+
+static void
+free_dist_fragments(ErtsDistFragments *fp)
+{
+    while (fp) {
+	ErtsDistFragments *ffp = fp;
+	fp = fp->next;
+	erts_bin_free(ffp->bin);
+	erts_free(ERTS_ALC_T_DIST_FRAGMENTS, (void *) ffp);
+    }
 }
 
 static void clear_dist_entry(DistEntry *dep)
@@ -561,10 +617,15 @@ static void clear_dist_entry(DistEntry *dep)
     ErtsAtomCache *cache;
     ErtsProcList *suspendees;
     ErtsDistOutputBuf *obuf;
+    ErtsDistOutputStream *streams;
+    ErtsDistFragments *in_fragments;
+    int i;
 
     erts_smp_de_rwlock(dep);
-    cache = dep->cache;
-    dep->cache = NULL;
+    cache = dep->primary.cache;
+    dep->primary.cache = NULL;
+    in_fragments = dep->primary.in_fragments;
+    dep->primary.in_fragments = NULL;
 
 #ifdef DEBUG
     erts_smp_de_links_lock(dep);
@@ -574,30 +635,53 @@ static void clear_dist_entry(DistEntry *dep)
     erts_smp_de_links_unlock(dep);
 #endif
 
-    erts_smp_spin_lock(&dep->qlock);
+    /*
+     * The extra connections clean up after themselves when their
+     * ports exit; they do as soon as they notice that they are no
+     * longer attached.
+     */
+    for (i = 0; i < dep->no_stripes; i++) {
+	ErtsDistStripe *sp = dep->stripes[i];
+	if (sp) {
+	    sp->attached = 0;
+	    erts_schedule_dist_command(NULL, sp);
+	}
+    }
+    if (dep->stripes)
+	erts_free(ERTS_ALC_T_DIST_STRIPES, (void *) dep->stripes);
+    dep->stripes = NULL;
+    dep->no_stripes = 0;
+
+    erts_smp_spin_lock(&dep->primary.qlock);
 
-    if (!dep->out_queue.last)
-	obuf = dep->finalized_out_queue.first;
+    if (!dep->primary.out_queue.last)
+	obuf = dep->primary.finalized_out_queue.first;
     else {
-	dep->out_queue.last->next = dep->finalized_out_queue.first;
-	obuf = dep->out_queue.first;
+	dep->primary.out_queue.last->next
+	    = dep->primary.finalized_out_queue.first;
+	obuf = dep->primary.out_queue.first;
     }
 
-    dep->out_queue.first = NULL;
-    dep->out_queue.last = NULL;
-    dep->finalized_out_queue.first = NULL;
-    dep->finalized_out_queue.last = NULL;
+    dep->primary.out_queue.first = NULL;
+    dep->primary.out_queue.last = NULL;
+    dep->primary.finalized_out_queue.first = NULL;
+    dep->primary.finalized_out_queue.last = NULL;
+    streams = dep->primary.streams;
+    dep->primary.streams = NULL;
     dep->status = 0;
-    suspendees = get_suspended_on_de(dep, ERTS_DE_QFLGS_ALL);
+    suspendees = get_suspended_on_stripe(&dep->primary, ERTS_DE_QFLGS_ALL);
 
-    erts_smp_spin_unlock(&dep->qlock);
-    erts_smp_atomic_set(&dep->dist_cmd_scheduled, 0);
-    dep->send = NULL;
+    erts_smp_spin_unlock(&dep->primary.qlock);
+    erts_smp_atomic_set(&dep->primary.dist_cmd_scheduled, 0);
+    dep->primary.send = NULL;
+    dep->primary.cid = NIL;
     erts_smp_de_rwunlock(dep);
 
     erts_resume_processes(suspendees);
 
     delete_cache(cache);
+    free_dist_streams(streams);
+    free_dist_fragments(in_fragments);
 
     while (obuf) {
 	ErtsDistOutputBuf *fobuf;
@@ -608,13 +692,89 @@ static void clear_dist_entry(DistEntry *dep)
     }
 
     if (obufsize) {
-	erts_smp_spin_lock(&dep->qlock);
-	ASSERT(dep->qsize >= obufsize);
-	dep->qsize -= obufsize;
-	erts_smp_spin_unlock(&dep->qlock);
+	erts_smp_spin_lock(&dep->primary.qlock);
+	ASSERT(dep->primary.qsize >= obufsize);
+	dep->primary.qsize -= obufsize;
+	erts_smp_spin_unlock(&dep->primary.qlock);
     }
 }
 
+/*
+ * An extra connection to a node goes away with its port. The
+ * connection to the node as a whole is taken down; the signals of the
+ * senders that used it cannot be kept in order otherwise.
+ */
+void
+erts_do_dist_stripe_exit(Port *prt)
+{
+    DistEntry *dep = prt->dist_entry;
+    ErtsDistStripe *sp = prt->dist_stripe;
+    ErtsDistOutputBuf *obuf;
+    ErtsProcList *suspendees;
+    int kill = 0;
+    Uint32 connection_id = 0;
+    int i;
+
+    ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(prt));
+    ASSERT(dep && sp);
+
+    erts_smp_de_rwlock(dep);
+    for (i = 0; i < dep->no_stripes && dep->stripes[i] != sp; i++);
+    if (i < dep->no_stripes) {
+	if (sp->attached) {
+	    /* Keep the slot; the others must not change senders */
+	    dep->stripes[i] = NULL;
+	    sp->attached = 0;
+	    kill = 1;
+	    connection_id = dep->connection_id;
+	}
+	else {
+	    /* Prepared for a connection that never got set up */
+	    dep->no_stripes--;
+	    for (; i < dep->no_stripes; i++)
+		dep->stripes[i] = dep->stripes[i + 1];
+	    if (!dep->no_stripes) {
+		erts_free(ERTS_ALC_T_DIST_STRIPES, (void *) dep->stripes);
+		dep->stripes = NULL;
+	    }
+	}
+    }
+    erts_smp_de_rwunlock(dep);
+
+    if (kill)
+	erts_kill_dist_connection(dep, connection_id);
+
+    if (erts_port_task_is_scheduled(&sp->dist_cmd))
+	erts_port_task_abort(prt->id, &sp->dist_cmd);
+
+    erts_smp_spin_lock(&sp->qlock);
+    if (!sp->out_queue.last)
+	obuf = sp->finalized_out_queue.first;
+    else {
+	sp->out_queue.last->next = sp->finalized_out_queue.first;
+	obuf = sp->out_queue.first;
+    }
+    sp->out_queue.first = sp->out_queue.last = NULL;
+    suspendees = get_suspended_on_stripe(sp, ERTS_DE_QFLGS_ALL);
+    erts_smp_spin_unlock(&sp->qlock);
+
+    erts_resume_processes(suspendees);
+
+    delete_cache(sp->cache);
+    free_dist_streams(sp->streams);
+    free_dist_fragments(sp->in_fragments);
+
+    while (obuf) {
+	ErtsDistOutputBuf *fobuf = obuf;
+	obuf = obuf->next;
+	free_dist_obuf(fobuf);
+    }
+
+    erts_smp_spinlock_destroy(&sp->qlock);
+    erts_free(ERTS_ALC_T_DIST_STRIPE, (void *) sp);
+    prt->dist_stripe = NULL;
+}
+
 /*
  * The erts_dsig_send_*() functions implemented below, sends asynchronous
  * distributed signals to other Erlang nodes. Before sending a distributed
@@ -635,7 +795,7 @@ erts_dsig_send_link(ErtsDSigData *dsdp, Eterm local, Eterm remote)
     Eterm ctl_heap[4];
     Eterm ctl = TUPLE3(&ctl_heap[0], make_small(DOP_LINK), local, remote);
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 0);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, local, 0);
 }
 
 int
@@ -644,16 +804,17 @@ erts_dsig_send_unlink(ErtsDSigData *dsdp, Eterm local, Eterm remote)
     Eterm ctl_heap[4];
     Eterm ctl = TUPLE3(&ctl_heap[0], make_small(DOP_UNLINK), local, remote);
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 0);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, local, 0);
 }
 
 
 /* A local process that's beeing monitored by a remote one exits. We send:
    {DOP_MONITOR_P_EXIT, Local pid or name, Remote pid, ref, reason},
-   which is rather sad as only the ref is needed, no pid's... */
+   which is rather sad as only the ref is needed, no pid's... The signal
+   is sent by local, which is the local pid also when watched is a name. */
 int
 erts_dsig_send_m_exit(ErtsDSigData *dsdp, Eterm watcher, Eterm watched, 
-			  Eterm ref, Eterm reason)
+			  Eterm ref, Eterm reason, Eterm local)
 {
     Eterm ctl;
     Eterm ctl_heap[6];
@@ -667,7 +828,7 @@ erts_dsig_send_m_exit(ErtsDSigData *dsdp, Eterm watcher, Eterm watched,
     erts_smp_de_links_unlock(dsdp->dep);
 #endif
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 1);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, local, 1);
 }
 
 /* We want to monitor a process (named or unnamed) on another node, we send:
@@ -684,7 +845,7 @@ erts_dsig_send_monitor(ErtsDSigData *dsdp, Eterm watcher, Eterm watched,
 		 make_small(DOP_MONITOR_P),
 		 watcher, watched, ref);
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 0);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, watcher, 0);
 }
 
 /* A local process monitoring a remote one wants to stop monitoring, either 
@@ -702,7 +863,7 @@ erts_dsig_send_demonitor(ErtsDSigData *dsdp, Eterm watcher,
 		 make_small(DOP_DEMONITOR_P),
 		 watcher, watched, ref);
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, force);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, watcher, force);
 }
 
 int
@@ -724,7 +885,7 @@ erts_dsig_send_msg(ErtsDSigData *dsdp, Eterm remote, Eterm message)
 		     make_small(DOP_SEND_TT), am_Cookie, remote, token);
     else
 	ctl = TUPLE3(&ctl_heap[0], make_small(DOP_SEND), am_Cookie, remote);
-    return dsig_send(dsdp, ctl, message, 0);
+    return dsig_send(dsdp, ctl, message, sender->id, 0);
 }
 
 int
@@ -747,7 +908,7 @@ erts_dsig_send_reg_msg(ErtsDSigData *dsdp, Eterm remote_name, Eterm message)
     else
 	ctl = TUPLE4(&ctl_heap[0], make_small(DOP_REG_SEND),
 		     sender->id, am_Cookie, remote_name);
-    return dsig_send(dsdp, ctl, message, 0);
+    return dsig_send(dsdp, ctl, message, sender->id, 0);
 }
 
 /* local has died, deliver the exit signal to remote */
@@ -767,7 +928,7 @@ erts_dsig_send_exit_tt(ErtsDSigData *dsdp, Eterm local, Eterm remote,
 	ctl = TUPLE4(&ctl_heap[0], make_small(DOP_EXIT), local, remote, reason);
     }
     /* forced, i.e ignore busy */
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 1);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, local, 1);
 }
 
 int
@@ -777,7 +938,7 @@ erts_dsig_send_exit(ErtsDSigData *dsdp, Eterm local, Eterm remote, Eterm reason)
     Eterm ctl = TUPLE4(&ctl_heap[0],
 		       make_small(DOP_EXIT), local, remote, reason);
     /* forced, i.e ignore busy */
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 1);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, local, 1);
 }
 
 int
@@ -787,7 +948,7 @@ erts_dsig_send_exit2(ErtsDSigData *dsdp, Eterm local, Eterm remote, Eterm reason
     Eterm ctl = TUPLE4(&ctl_heap[0],
 		       make_small(DOP_EXIT2), local, remote, reason);
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 0);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE, local, 0);
 }
 
 
@@ -798,7 +959,8 @@ erts_dsig_send_group_leader(ErtsDSigData *dsdp, Eterm leader, Eterm remote)
     Eterm ctl = TUPLE3(&ctl_heap[0],
 		       make_small(DOP_GROUP_LEADER), leader, remote);
 
-    return dsig_send(dsdp, ctl, THE_NON_VALUE, 0);
+    return dsig_send(dsdp, ctl, THE_NON_VALUE,
+		     dsdp->proc ? dsdp->proc->id : leader, 0);
 }
 
 #if defined(PURIFY)
@@ -823,6 +985,122 @@ erts_dsig_send_group_leader(ErtsDSigData *dsdp, Eterm leader, Eterm remote)
 #  define PURIFY_MSG(msg)
 #endif
 
+/*
+ * Signals larger than ERTS_DIST_FRAG_SIZE are sent in fragments of
+ * that size to nodes that can put them together again:
+ *
+ *   VERSION_MAGIC DIST_FRAG_HEADER SequenceId FragmentId DistHeader...
+ *   VERSION_MAGIC DIST_FRAG_CONT SequenceId FragmentId ...
+ *
+ * SequenceId (64 bits) identifies the signal on the connection, and
+ * FragmentId (64 bits) counts down to 1 for the last fragment. The
+ * data of the fragments, put together, is the signal with
+ * VERSION_MAGIC DIST_HEADER removed.
+ */
+#define ERTS_DIST_FRAG_SIZE (64*1024)
+#define ERTS_DIST_FRAG_HDR_SIZE (1+1+8+8)
+
+#define ERTS_DIST_FRAG_DFLAGS (DFLAG_FRAGMENTS | DFLAG_DIST_HDR_ATOM_CACHE)
+
+/* The largest signal put together; erts_net_message() takes an int */
+#define ERTS_DIST_FRAG_MAX_SIZE ((Uint) INT_MAX)
+/* At most this much is allocated before the data has arrived */
+#define ERTS_DIST_FRAG_PREALLOC_SIZE (16*1024*1024)
+
+/*
+ * A fragment of a large signal. The signal is put together in a
+ * binary, and handled when the last fragment has arrived. The binary
+ * is sized from the first fragment, but grows if later fragments are
+ * larger; other implementations need not send equal sized fragments.
+ */
+static int
+net_message_fragment(Port *prt, DistEntry *dep, byte *buf, int len)
+{
+    ErtsDistStripe *sp = dist_port_stripe(prt);
+    ErtsDistFragments *fp, **fpp;
+    Uint64 seq_id, frag_id;
+    int first = buf[1] == DIST_FRAG_HEADER;
+    int res;
+
+    if (len <= ERTS_DIST_FRAG_HDR_SIZE
+	|| !(dep->flags & DFLAG_DIST_HDR_ATOM_CACHE))
+	goto data_error;
+
+    seq_id = ((((Uint64) get_int32(buf + 2)) << 32)
+	      | ((Uint64) get_int32(buf + 6)));
+    frag_id = ((((Uint64) get_int32(buf + 10)) << 32)
+	       | ((Uint64) get_int32(buf + 14)));
+    buf += ERTS_DIST_FRAG_HDR_SIZE;
+    len -= ERTS_DIST_FRAG_HDR_SIZE;
+
+    for (fpp = &sp->in_fragments; *fpp; fpp = &(*fpp)->next)
+	if ((*fpp)->seq_id == seq_id)
+	    break;
+    fp = *fpp;
+
+    if (first) {
+	Uint size;
+	if (fp || frag_id == 0
+	    || frag_id > (ERTS_DIST_FRAG_MAX_SIZE - 2) / len)
+	    goto data_error;
+	size = 2 + (Uint) (len * frag_id);
+	if (size > ERTS_DIST_FRAG_PREALLOC_SIZE)
+	    size = ERTS_DIST_FRAG_PREALLOC_SIZE;
+	fp = erts_alloc(ERTS_ALC_T_DIST_FRAGMENTS, sizeof(ErtsDistFragments));
+	fp->bin = erts_bin_nrml_alloc(size);
+	fp->bin->flags = 0;
+	fp->bin->orig_size = size;
+	erts_refc_init(&fp->bin->refc, 1);
+	fp->bin->orig_bytes[0] = VERSION_MAGIC;
+	fp->bin->orig_bytes[1] = DIST_HEADER;
+	fp->seq_id = seq_id;
+	fp->frag_id = frag_id;
+	fp->size = 2;
+	fp->next = sp->in_fragments;
+	sp->in_fragments = fp;
+	fpp = &sp->in_fragments;
+    }
+    else if (!fp || frag_id != fp->frag_id)
+	goto data_error;
+
+    if (len > fp->bin->orig_size - fp->size) {
+	Uint size;
+	if (len > ERTS_DIST_FRAG_MAX_SIZE - fp->size)
+	    goto data_error;
+	size = 2*fp->bin->orig_size;
+	if (size < fp->size + len)
+	    size = fp->size + len;
+	if (size > ERTS_DIST_FRAG_MAX_SIZE)
+	    size = ERTS_DIST_FRAG_MAX_SIZE;
+	fp->bin = erts_bin_realloc(fp->bin, size);
+	fp->bin->orig_size = size;
+    }
+
+    sys_memcpy((void *) (fp->bin->orig_bytes + fp->size), (void *) buf, len);
+    fp->size += len;
+    if (--fp->frag_id > 0)
+	return 0;
+
+    *fpp = fp->next;
+    /* Binaries decoded from the signal may keep all of it */
+    if (fp->bin->orig_size != fp->size) {
+	fp->bin = erts_bin_realloc(fp->bin, fp->size);
+	fp->bin->orig_size = fp->size;
+    }
+    res = erts_net_message(prt, dep, NULL, 0,
+			   (byte *) fp->bin->orig_bytes, (int) fp->size,
+			   fp->bin);
+    if (erts_refc_dectest(&fp->bin->refc, 0) == 0)
+	erts_bin_free(fp->bin);
+    erts_free(ERTS_ALC_T_DIST_FRAGMENTS, (void *) fp);
+    return res;
+
+ data_error:
+    PURIFY_MSG("data error");
+    erts_do_exit_port(prt, dep->cid, am_killed);
+    return -1;
+}
+
 /*
 ** Input from distribution port.
 **  Input follows the distribution protocol v4.5
@@ -831,13 +1109,17 @@ erts_dsig_send_group_leader(ErtsDSigData *dsdp, Eterm leader, Eterm remote)
 **   the DOP_DATA is stripped by driver_output
 **
 **   assert  hlen == 0 !!!
+**
+**   If bin is non-NULL, buf is in bin, and large binaries in the
+**   message that are most of bin refer to it rather than being copied.
 */
 int erts_net_message(Port *prt,
 		     DistEntry *dep,
 		     byte *hbuf,
 		     int hlen,
 		     byte *buf,
-		     int len)
+		     int len,
+		     Binary *bin)
 {
     ErtsDistExternal ede;
     byte *t;
@@ -859,6 +1141,7 @@ int erts_net_message(Port *prt,
     Eterm token_size;
     ErtsMonitor *mon;
     ErtsLink *lnk;
+    ErtsDistStripe *sp;
     int res;
 #ifdef ERTS_DIST_MSG_DBG
     int orig_len = len;
@@ -883,11 +1166,27 @@ int erts_net_message(Port *prt,
     if (len == 0)  /* HANDLE TICK !!! */
 	return 0;
 
+    sp = dist_port_stripe(prt);
+    if (sp != &dep->primary) {
+	/* Data left on an extra connection of an earlier connection */
+	int attached;
+	erts_smp_de_rlock(dep);
+	attached = sp->attached;
+	erts_smp_de_runlock(dep);
+	if (!attached)
+	    return 0;
+    }
+
 #ifdef ERTS_RAW_DIST_MSG_DBG
     erts_fprintf(stderr, "<< ");
     bw(buf, len);
 #endif
 
+    if (len > 1
+	&& buf[0] == VERSION_MAGIC
+	&& (buf[1] == DIST_FRAG_HEADER || buf[1] == DIST_FRAG_CONT))
+	return net_message_fragment(prt, dep, buf, len);
+
     if (dep->flags & DFLAG_DIST_HDR_ATOM_CACHE)
 	t = buf;
     else {
@@ -901,7 +1200,8 @@ int erts_net_message(Port *prt,
 	goto data_error;
     }
 
-    res = erts_prepare_dist_ext(&ede, t, len, dep, dep->cache);
+    res = erts_prepare_dist_ext(&ede, t, len, dep, sp->cache);
+    ede.bin = bin;
 
     if (res >= 0)
 	res = ctl_len = erts_decode_dist_ext_size(&ede, 0);
@@ -1056,7 +1356,7 @@ int erts_net_message(Port *prt,
 	    code = erts_dsig_prepare(&dsd, dep, NULL, ERTS_DSP_NO_LOCK, 0);
 	    if (code == ERTS_DSIG_PREP_CONNECTED) {
 		code = erts_dsig_send_m_exit(&dsd, watcher, watched, ref,
-					     am_noproc);
+					     am_noproc, watched);
 		ASSERT(code == ERTS_DSIG_SEND_OK);
 	    }
 	}
@@ -1409,17 +1709,103 @@ int erts_net_message(Port *prt,
 
 #define ERTS_DE_BUSY_LIMIT (128*1024)
 
+static Sint
+fragment_dist_obuf(ErtsDistOutputBuf *obuf, ErtsDistOutputQueue *fq)
+{
+    Uint offs = 0;
+    Uint size = obuf->ext_endp - (obuf->extp + 2);
+    Uint64 seq_id = (Uint64) (Uint) obuf; /* Unique while sent */
+    Uint64 frag_id;
+    Sint qsize = 0;
+
+    ASSERT(obuf->extp[0] == VERSION_MAGIC && obuf->extp[1] == DIST_HEADER);
+
+    if (obuf->bin_refs)
+	size += obuf->bin_refs->size;
+    frag_id = (size + ERTS_DIST_FRAG_SIZE - 1) / ERTS_DIST_FRAG_SIZE;
+    erts_refc_init(&obuf->frag_refc, (long) frag_id);
+
+    fq->first = fq->last = NULL;
+    while (frag_id > 0) {
+	ErtsDistOutputBuf *fob = alloc_dist_obuf(ERTS_DIST_FRAG_HDR_SIZE);
+	byte *ep = &fob->data[0];
+	fob->extp = ep;
+	*ep++ = VERSION_MAGIC;
+	*ep++ = fq->first ? DIST_FRAG_CONT : DIST_FRAG_HEADER;
+	put_int32((Uint32) (seq_id >> 32), ep);
+	put_int32((Uint32) seq_id, ep + 4);
+	put_int32((Uint32) (frag_id >> 32), ep + 8);
+	put_int32((Uint32) frag_id, ep + 12);
+	fob->ext_endp = ep + 16;
+	fob->frag_of = obuf;
+	fob->frag_offs = offs;
+	fob->frag_size = size < ERTS_DIST_FRAG_SIZE ? size : ERTS_DIST_FRAG_SIZE;
+	offs += fob->frag_size;
+	size -= fob->frag_size;
+	frag_id--;
+
+	fob->next = NULL;
+	if (fq->last)
+	    fq->last->next = fob;
+	else
+	    fq->first = fob;
+	fq->last = fob;
+	qsize += size_obuf(fob);
+    }
+    ASSERT(size == 0);
+    return qsize; /* The fragments keep obuf */
+}
+
+static ERTS_INLINE ErtsDistOutputStream *
+lookup_dist_stream(ErtsDistStripe *sp, Eterm sender)
+{
+    ErtsDistOutputStream *stream;
+    ERTS_SMP_LC_ASSERT(erts_smp_lc_spinlock_is_locked(&sp->qlock));
+    for (stream = sp->streams; stream; stream = stream->next)
+	if (stream->sender == sender)
+	    return stream;
+    return NULL;
+}
+
+/*
+ * Whether a signal from sender would have to wait: for the
+ * fragmented signals of sender queued before it, if there are any,
+ * and otherwise for the connection.
+ */
+int
+erts_dsig_sender_busy(ErtsDistStripe *sp, Eterm sender)
+{
+    ErtsDistOutputStream *stream;
+    int busy;
+
+    erts_smp_spin_lock(&sp->qlock);
+    stream = lookup_dist_stream(sp, sender);
+    if (stream)
+	busy = stream->size >= ERTS_DE_BUSY_LIMIT;
+    else
+	busy = (sp->qflgs & ERTS_DE_QFLG_BUSY) != 0;
+    erts_smp_spin_unlock(&sp->qlock);
+    return busy;
+}
+
 static int
-dsig_send(ErtsDSigData *dsdp, Eterm ctl, Eterm msg, int force_busy)
+dsig_send(ErtsDSigData *dsdp, Eterm ctl, Eterm msg, Eterm sender,
+	  int force_busy)
 {
     Eterm cid;
     int suspended = 0;
     int resume = 0;
     Uint32 pass_through_size;
     Uint data_size, dhdr_ext_size;
+    Sint obufsize;
     ErtsAtomCacheMap *acmp;
     ErtsDistOutputBuf *obuf;
+    ErtsDistBinRefs no_refs, *refs = NULL;
+    ErtsDistOutputQueue fq;
+    ErtsDistOutputStream *new_stream = NULL;
+    int fragment = 0;
     DistEntry *dep = dsdp->dep;
+    ErtsDistStripe *sp;
     Uint32 flags = dep->flags;
     Process *c_p = dsdp->proc;
 
@@ -1448,89 +1834,196 @@ dsig_send(ErtsDSigData *dsdp, Eterm ctl, Eterm msg, int force_busy)
 	erts_fprintf(stderr, "    MSG: %T\n", msg);
 #endif
 
+    /* Large binaries are counted in no_refs, not in data_size */
+    no_refs.no = 0;
+    no_refs.size = 0;
     data_size = pass_through_size;
     erts_reset_atom_cache_map(acmp);
-    data_size += erts_encode_dist_ext_size(ctl, flags, acmp);
+    data_size += erts_encode_dist_ext_size(ctl, flags, acmp, &no_refs);
     if (is_value(msg))
-	data_size += erts_encode_dist_ext_size(msg, flags, acmp);
+	data_size += erts_encode_dist_ext_size(msg, flags, acmp, &no_refs);
     erts_finalize_atom_cache_map(acmp);
 
     dhdr_ext_size = erts_encode_ext_dist_header_size(acmp);
     data_size += dhdr_ext_size;
 
+    if (data_size + no_refs.size > ERTS_DIST_FRAG_SIZE
+	&& is_internal_pid(sender)
+	&& (flags & ERTS_DIST_FRAG_DFLAGS) == ERTS_DIST_FRAG_DFLAGS) {
+	/*
+	 * Other signals are sent in between the fragments, and they
+	 * update the atom cache as they are sent; hence, no atom cache
+	 * references in this one.
+	 */
+	fragment = 1;
+	erts_reset_atom_cache_map(acmp);
+	acmp = NULL;
+	dhdr_ext_size = 1+1+1;
+	no_refs.no = 0;
+	no_refs.size = 0;
+	data_size = dhdr_ext_size + erts_encode_dist_ext_size(ctl, flags, NULL,
+							      &no_refs);
+	if (is_value(msg))
+	    data_size += erts_encode_dist_ext_size(msg, flags, NULL, &no_refs);
+	new_stream = erts_alloc(ERTS_ALC_T_DIST_STREAM,
+				sizeof(ErtsDistOutputStream));
+    }
+
     obuf = alloc_dist_obuf(data_size);
     obuf->ext_endp = &obuf->data[0] + pass_through_size + dhdr_ext_size;
+    if (no_refs.no) {
+	refs = erts_alloc(ERTS_ALC_T_DIST_BIN_REFS,
+			  (sizeof(ErtsDistBinRefs)
+			   + sizeof(ErtsDistBinRef)*(no_refs.no - 1)));
+	refs->no = 0;
+	refs->size = 0;
+	obuf->bin_refs = refs;
+    }
 
-    /* Encode internal version of dist header */
-    obuf->extp = erts_encode_ext_dist_header_setup(obuf->ext_endp, acmp);
+    if (fragment) {
+	/* Final dist header without atom cache references */
+	obuf->extp = &obuf->data[0];
+	obuf->extp[0] = VERSION_MAGIC;
+	obuf->extp[1] = DIST_HEADER;
+	obuf->extp[2] = 0;
+    }
+    else {
+	/* Encode internal version of dist header */
+	obuf->extp = erts_encode_ext_dist_header_setup(obuf->ext_endp, acmp);
+    }
     /* Encode control message */
-    erts_encode_dist_ext(ctl, &obuf->ext_endp, flags, acmp);
+    erts_encode_dist_ext(ctl, &obuf->ext_endp, flags, acmp, refs);
     if (is_value(msg)) {
 	/* Encode message */
-	erts_encode_dist_ext(msg, &obuf->ext_endp, flags, acmp);
+	erts_encode_dist_ext(msg, &obuf->ext_endp, flags, acmp, refs);
     }
 
+    ASSERT(!refs
+	   || (refs->no == no_refs.no && refs->size == no_refs.size));
     ASSERT(obuf->extp < obuf->ext_endp);
     ASSERT(&obuf->data[0] <= obuf->extp - pass_through_size);
     ASSERT(obuf->ext_endp <= &obuf->data[0] + data_size);
 
     data_size = obuf->ext_endp - obuf->extp;
 
+    obuf->next = NULL;
+    if (fragment)
+	obufsize = fragment_dist_obuf(obuf, &fq);
+    else {
+	obufsize = size_obuf(obuf);
+	fq.first = fq.last = obuf;
+    }
+
     /*
      * Signal encoded; now verify that the connection still exists,
      * and if so enqueue the signal and schedule it for send.
      */
-    obuf->next = NULL;
     erts_smp_de_rlock(dep);
     cid = dep->cid;
+    sp = erts_dist_sender_stripe(dep, sender);
     if (cid != dsdp->cid
 	|| dep->connection_id != dsdp->connection_id
-	|| dep->status & ERTS_DE_SFLG_EXITING) {
+	|| dep->status & ERTS_DE_SFLG_EXITING
+	|| !sp) {
 	/* Not the same connection as when we started; drop message... */
 	erts_smp_de_runlock(dep);
-	free_dist_obuf(obuf);
+	while (fq.first) {
+	    obuf = fq.first;
+	    fq.first = obuf->next;
+	    free_dist_obuf(obuf);
+	}
     }
     else {
 	ErtsProcList *plp = NULL;
-	erts_smp_spin_lock(&dep->qlock);
-	dep->qsize += size_obuf(obuf);
-	if (dep->qsize >= ERTS_DE_BUSY_LIMIT)
-	    dep->qflgs |= ERTS_DE_QFLG_BUSY;
-	if (!force_busy && (dep->qflgs & ERTS_DE_QFLG_BUSY)) {
-	    erts_smp_spin_unlock(&dep->qlock);
+	ErtsDistOutputStream *stream;
+	erts_smp_spin_lock(&sp->qlock);
+	stream = lookup_dist_stream(sp, sender);
+	if (stream || fragment) {
+	    /*
+	     * Enqueue on the stream of the sender, after its
+	     * fragmented signal, and let it alone wait for the
+	     * stream to be sent.
+	     */
+	    if (!stream) {
+		ErtsDistOutputStream **spp = &sp->streams;
+		while (*spp)
+		    spp = &(*spp)->next;
+		stream = *spp = new_stream;
+		new_stream = NULL;
+		stream->next = NULL;
+		stream->sender = sender;
+		stream->size = 0;
+		stream->queue.first = stream->queue.last = NULL;
+		stream->suspended.first = stream->suspended.last = NULL;
+	    }
+	    if (stream->queue.last)
+		stream->queue.last->next = fq.first;
+	    else
+		stream->queue.first = fq.first;
+	    stream->queue.last = fq.last;
+	    stream->size += obufsize;
+	    if (!force_busy && stream->size >= ERTS_DE_BUSY_LIMIT) {
+		erts_smp_spin_unlock(&sp->qlock);
+
+		plp = erts_proclist_create(c_p);
+		plp->next = NULL;
+		erts_suspend(c_p, ERTS_PROC_LOCK_MAIN, NULL);
+		suspended = 1;
+		erts_smp_spin_lock(&sp->qlock);
+
+		stream = lookup_dist_stream(sp, sender);
+		if (!stream || stream->size < ERTS_DE_BUSY_LIMIT)
+		    resume = 1; /* sent while we suspended */
+		else {
+		    if (stream->suspended.last)
+			stream->suspended.last->next = plp;
+		    else
+			stream->suspended.first = plp;
+		    stream->suspended.last = plp;
+		}
+	    }
+	    goto enqueued;
+	}
+
+	sp->qsize += obufsize;
+	if (sp->qsize >= ERTS_DE_BUSY_LIMIT)
+	    sp->qflgs |= ERTS_DE_QFLG_BUSY;
+	if (!force_busy && (sp->qflgs & ERTS_DE_QFLG_BUSY)) {
+	    erts_smp_spin_unlock(&sp->qlock);
 
 	    plp = erts_proclist_create(c_p);
 	    plp->next = NULL;
 	    erts_suspend(c_p, ERTS_PROC_LOCK_MAIN, NULL);
 	    suspended = 1;
-	    erts_smp_spin_lock(&dep->qlock);
+	    erts_smp_spin_lock(&sp->qlock);
 	}
 
-	/* Enqueue obuf on dist entry */
-	if (dep->out_queue.last)
-	    dep->out_queue.last->next = obuf;
+	/* Enqueue obuf on the connection */
+	if (sp->out_queue.last)
+	    sp->out_queue.last->next = obuf;
 	else
-	    dep->out_queue.first = obuf;
-	dep->out_queue.last = obuf;
+	    sp->out_queue.first = obuf;
+	sp->out_queue.last = obuf;
 
 	if (!force_busy) {
-	    if (!(dep->qflgs & ERTS_DE_QFLG_BUSY)) {
+	    if (!(sp->qflgs & ERTS_DE_QFLG_BUSY)) {
 		if (suspended)
 		    resume = 1; /* was busy when we started, but isn't now */
 	    }
 	    else {
-		/* Enqueue suspended process on dist entry */
+		/* Enqueue suspended process on the connection */
 		ASSERT(plp);
-		if (dep->suspended.last)
-		    dep->suspended.last->next = plp;
+		if (sp->suspended.last)
+		    sp->suspended.last->next = plp;
 		else
-		    dep->suspended.first = plp;
-		dep->suspended.last = plp;
+		    sp->suspended.first = plp;
+		sp->suspended.last = plp;
 	    }
 	}
 
-	erts_smp_spin_unlock(&dep->qlock);
-	erts_schedule_dist_command(NULL, dep);
+    enqueued:
+	erts_smp_spin_unlock(&sp->qlock);
+	erts_schedule_dist_command(NULL, sp);
 	erts_smp_de_runlock(dep);
 	
 	if (resume) {
@@ -1544,6 +2037,9 @@ dsig_send(ErtsDSigData *dsdp, Eterm ctl, Eterm msg, int force_busy)
 	}
     }
 
+    if (new_stream)
+	erts_free(ERTS_ALC_T_DIST_STREAM, (void *) new_stream);
+
     if (c_p) {
 	int reds;
 	/* 
@@ -1574,15 +2070,139 @@ dsig_send(ErtsDSigData *dsdp, Eterm ctl, Eterm msg, int force_busy)
 }
 
 
+/*
+ * Add len bytes of the data of obuf, starting offs bytes after start,
+ * to iov and bv. The data is the encoded data with the binaries that
+ * obuf refers to in between. Returns the number of entries added;
+ * at most 2*obuf->bin_refs->no + 1.
+ */
+static int
+dist_obuf_iov(ErtsDistOutputBuf *obuf, byte *start, Uint offs, Uint len,
+	      SysIOVec *iov, ErlDrvBinary **bv)
+{
+    ErlDrvBinary *obin = Binary2ErlDrvBinary(ErtsDistOutputBuf2Binary(obuf));
+    ErtsDistBinRefs *refs = obuf->bin_refs;
+    Uint no_refs = refs ? refs->no : 0;
+    byte *p = start;
+    Uint i = 0;
+    int n = 0;
+
+    while (len > 0) {
+	byte *endp = i < no_refs ? refs->ref[i].ext_pos : obuf->ext_endp;
+	Uint sz = endp - p;
+	if (offs < sz) {
+	    Uint l = sz - offs < len ? sz - offs : len;
+	    iov[n].iov_base = p + offs;
+	    iov[n].iov_len = l;
+	    bv[n] = obin;
+	    n++;
+	    len -= l;
+	    offs = 0;
+	}
+	else
+	    offs -= sz;
+	if (len == 0)
+	    break;
+	ASSERT(i < no_refs);
+	sz = refs->ref[i].size;
+	if (offs < sz) {
+	    Uint l = sz - offs < len ? sz - offs : len;
+	    iov[n].iov_base = refs->ref[i].bytes + offs;
+	    iov[n].iov_len = l;
+	    bv[n] = Binary2ErlDrvBinary(refs->ref[i].bin);
+	    n++;
+	    len -= l;
+	    offs = 0;
+	}
+	else
+	    offs -= sz;
+	p = endp;
+	i++;
+    }
+    return n;
+}
+
+#define ERTS_DIST_SMALL_IOV 16
+
+/*
+ * The data to send of obuf, in iov[1..] and bv[1..]; iov[0] and
+ * bv[0] are left empty. Returns the number of entries, including
+ * iov[0]. If there are more entries than ERTS_DIST_SMALL_IOV, the
+ * arrays are allocated; they are then to be freed by the caller.
+ */
+static int
+dist_port_iov(ErtsDistOutputBuf *obuf, SysIOVec **iovp, ErlDrvBinary ***bvp,
+	      Uint *sizep)
+{
+    ErtsDistOutputBuf *dobuf = obuf->frag_of ? obuf->frag_of : obuf;
+    Uint no_refs = dobuf->bin_refs ? dobuf->bin_refs->no : 0;
+    Uint size = obuf->ext_endp - obuf->extp;
+    SysIOVec *iov = *iovp;
+    ErlDrvBinary **bv = *bvp;
+    int n;
+
+    if (3 + 2*no_refs > ERTS_DIST_SMALL_IOV) {
+	iov = erts_alloc(ERTS_ALC_T_TMP, sizeof(SysIOVec)*(3 + 2*no_refs));
+	bv = erts_alloc(ERTS_ALC_T_TMP, sizeof(ErlDrvBinary *)*(3 + 2*no_refs));
+	*iovp = iov;
+	*bvp = bv;
+    }
+
+    iov[0].iov_base = NULL;
+    iov[0].iov_len = 0;
+    bv[0] = NULL;
+
+    if (obuf->frag_of) {
+	/* The data of the fragment is in the fragmented buffer */
+	iov[1].iov_base = obuf->extp;
+	iov[1].iov_len = size;
+	bv[1] = Binary2ErlDrvBinary(ErtsDistOutputBuf2Binary(obuf));
+	n = 2 + dist_obuf_iov(dobuf, dobuf->extp + 2,
+			      obuf->frag_offs, obuf->frag_size,
+			      &iov[2], &bv[2]);
+	size += obuf->frag_size;
+    }
+    else {
+	if (obuf->bin_refs)
+	    size += obuf->bin_refs->size;
+	n = 1 + dist_obuf_iov(obuf, obuf->extp, 0, size, &iov[1], &bv[1]);
+    }
+    *sizep = size;
+    return n;
+}
+
 static Uint
 dist_port_command(Port *prt, ErtsDistOutputBuf *obuf)
 {
     int fpe_was_unmasked;
     Uint size = obuf->ext_endp - obuf->extp;
+    byte *bufp = obuf->extp;
 
     ERTS_SMP_CHK_NO_PROC_LOCKS;
     ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(prt));
 
+    if (obuf->frag_of || obuf->bin_refs) {
+	/* The driver only takes one buffer */
+	SysIOVec iov_default[ERTS_DIST_SMALL_IOV];
+	ErlDrvBinary *bv_default[ERTS_DIST_SMALL_IOV];
+	SysIOVec *iov = iov_default;
+	ErlDrvBinary **bv = bv_default;
+	byte *p;
+	int i, n;
+
+	n = dist_port_iov(obuf, &iov, &bv, &size);
+	p = bufp = erts_alloc(ERTS_ALC_T_TMP_DIST_BUF, size);
+	for (i = 1; i < n; i++) {
+	    sys_memcpy((void *) p, (void *) iov[i].iov_base, iov[i].iov_len);
+	    p += iov[i].iov_len;
+	}
+	ASSERT(p == bufp + size);
+	if (iov != iov_default) {
+	    erts_free(ERTS_ALC_T_TMP, (void *) iov);
+	    erts_free(ERTS_ALC_T_TMP, (void *) bv);
+	}
+    }
+
     if (size > (Uint) INT_MAX)
 	erl_exit(ERTS_ABORT_EXIT,
 		 "Absurdly large distribution output data buffer "
@@ -1592,9 +2212,11 @@ dist_port_command(Port *prt, ErtsDistOutputBuf *obuf)
     prt->caller = NIL;
     fpe_was_unmasked = erts_block_fpe();
     (*prt->drv_ptr->output)((ErlDrvData) prt->drv_data,
-			    (char*) obuf->extp,
+			    (char*) bufp,
 			    (int) size);
     erts_unblock_fpe(fpe_was_unmasked);
+    if (bufp != obuf->extp)
+	erts_free(ERTS_ALC_T_TMP_DIST_BUF, (void *) bufp);
     return size;
 }
 
@@ -1602,29 +2224,28 @@ static Uint
 dist_port_commandv(Port *prt, ErtsDistOutputBuf *obuf)
 {
     int fpe_was_unmasked;
-    Uint size = obuf->ext_endp - obuf->extp;
-    SysIOVec iov[2];
-    ErlDrvBinary* bv[2];
+    Uint size;
+    SysIOVec iov_default[ERTS_DIST_SMALL_IOV];
+    ErlDrvBinary *bv_default[ERTS_DIST_SMALL_IOV];
+    SysIOVec *iov = iov_default;
+    ErlDrvBinary **bv = bv_default;
     ErlIOVec eiov;
 
     ERTS_SMP_CHK_NO_PROC_LOCKS;
     ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(prt));
 
+    /*
+     * Large binaries are passed to the driver as they are, not
+     * copied into the buffer.
+     */
+    eiov.vsize = dist_port_iov(obuf, &iov, &bv, &size);
+
     if (size > (Uint) INT_MAX)
 	erl_exit(ERTS_ABORT_EXIT,
 		 "Absurdly large distribution output data buffer "
 		 "(%bpu bytes) passed.\n",
 		 size);
 
-    iov[0].iov_base = NULL;
-    iov[0].iov_len = 0;
-    bv[0] = NULL;
-
-    iov[1].iov_base = obuf->extp;
-    iov[1].iov_len = size;
-    bv[1] = Binary2ErlDrvBinary(ErtsDistOutputBuf2Binary(obuf));
-
-    eiov.vsize = 2;
     eiov.size = size;
     eiov.iov = iov;
     eiov.binv = bv;
@@ -1636,6 +2257,10 @@ dist_port_commandv(Port *prt, ErtsDistOutputBuf *obuf)
     (*prt->drv_ptr->outputv)((ErlDrvData) prt->drv_data, &eiov);
     erts_unblock_fpe(fpe_was_unmasked);
 
+    if (iov != iov_default) {
+	erts_free(ERTS_ALC_T_TMP, (void *) iov);
+	erts_free(ERTS_ALC_T_TMP, (void *) bv);
+    }
     return size;
 }
 
@@ -1669,6 +2294,8 @@ erts_dist_command(Port *prt, int reds_limit)
     Sint obufsize = 0;
     ErtsDistOutputQueue oq, foq;
     DistEntry *dep = prt->dist_entry;
+    ErtsDistStripe *sp = dist_port_stripe(prt);
+    int detached;
     Uint (*send)(Port *prt, ErtsDistOutputBuf *obuf);
 
     ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(prt));
@@ -1676,15 +2303,16 @@ erts_dist_command(Port *prt, int reds_limit)
     erts_refc_inc(&dep->refc, 1); /* Otherwise dist_entry might be
 				     removed if port command fails */
 
-    erts_smp_atomic_xchg(&dep->dist_cmd_scheduled, 0);
+    erts_smp_atomic_xchg(&sp->dist_cmd_scheduled, 0);
 
     erts_smp_de_rlock(dep);
     flags = dep->flags;
     status = dep->status;
-    send = dep->send;
+    send = sp->send;
+    detached = sp != &dep->primary && !sp->attached;
     erts_smp_de_runlock(dep);
 
-    if (status & ERTS_DE_SFLG_EXITING) {
+    if ((status & ERTS_DE_SFLG_EXITING) || detached) {
 	erts_do_exit_port(prt, prt->id, am_killed);
 	erts_deref_dist_entry(dep);
 	return reds + ERTS_PORT_REDS_DIST_CMD_EXIT;
@@ -1700,18 +2328,18 @@ erts_dist_command(Port *prt, int reds_limit)
      * a mess.
      */
 
-    erts_smp_spin_lock(&dep->qlock);
-    oq.first = dep->out_queue.first;
-    oq.last = dep->out_queue.last;
-    dep->out_queue.first = NULL;
-    dep->out_queue.last = NULL;
-    qflgs = dep->qflgs;
-    erts_smp_spin_unlock(&dep->qlock);
+    erts_smp_spin_lock(&sp->qlock);
+    oq.first = sp->out_queue.first;
+    oq.last = sp->out_queue.last;
+    sp->out_queue.first = NULL;
+    sp->out_queue.last = NULL;
+    qflgs = sp->qflgs;
+    erts_smp_spin_unlock(&sp->qlock);
 
-    foq.first = dep->finalized_out_queue.first;
-    foq.last = dep->finalized_out_queue.last;
-    dep->finalized_out_queue.first = NULL;
-    dep->finalized_out_queue.last = NULL;
+    foq.first = sp->finalized_out_queue.first;
+    foq.last = sp->finalized_out_queue.last;
+    sp->finalized_out_queue.first = NULL;
+    sp->finalized_out_queue.last = NULL;
 
     if (reds > reds_limit)
 	goto preempted;
@@ -1721,9 +2349,9 @@ erts_dist_command(Port *prt, int reds_limit)
 
     if (prt_busy) {
 	if (!de_busy) {
-	    erts_smp_spin_lock(&dep->qlock);
-	    dep->qflgs |= ERTS_DE_QFLG_BUSY;
-	    erts_smp_spin_unlock(&dep->qlock);
+	    erts_smp_spin_lock(&sp->qlock);
+	    sp->qflgs |= ERTS_DE_QFLG_BUSY;
+	    erts_smp_spin_unlock(&sp->qlock);
 	    de_busy = 1;
 	}
     }
@@ -1745,9 +2373,9 @@ erts_dist_command(Port *prt, int reds_limit)
 	    free_dist_obuf(fob);
 	    preempt = reds > reds_limit || (prt->status & ERTS_PORT_SFLGS_DEAD);
 	    if (prt->status & ERTS_PORT_SFLG_PORT_BUSY) {
-		erts_smp_spin_lock(&dep->qlock);
-		dep->qflgs |= ERTS_DE_QFLG_BUSY;
-		erts_smp_spin_unlock(&dep->qlock);
+		erts_smp_spin_lock(&sp->qlock);
+		sp->qflgs |= ERTS_DE_QFLG_BUSY;
+		erts_smp_spin_unlock(&sp->qlock);
 		de_busy = prt_busy = 1;
 		break;
 	    }
@@ -1768,7 +2396,7 @@ erts_dist_command(Port *prt, int reds_limit)
 	    ASSERT(ob);
 	    do {
 		ob->extp = erts_encode_ext_dist_header_finalize(ob->extp,
-								dep->cache);
+								sp->cache);
 		if (!(flags & DFLAG_DIST_HDR_ATOM_CACHE))
 		    *--ob->extp = PASS_THROUGH; /* Old node; 'pass through'
 						   needed */
@@ -1812,7 +2440,7 @@ erts_dist_command(Port *prt, int reds_limit)
 	    Uint size;
 	    oq.first->extp
 		= erts_encode_ext_dist_header_finalize(oq.first->extp,
-						       dep->cache);
+						       sp->cache);
 	    reds += ERTS_PORT_REDS_DIST_CMD_FINALIZE;
 	    if (!(flags & DFLAG_DIST_HDR_ATOM_CACHE))
 		*--oq.first->extp = PASS_THROUGH; /* Old node; 'pass through'
@@ -1831,9 +2459,9 @@ erts_dist_command(Port *prt, int reds_limit)
 	    free_dist_obuf(fob);
 	    preempt = reds > reds_limit || (prt->status & ERTS_PORT_SFLGS_DEAD);
 	    if (prt->status & ERTS_PORT_SFLG_PORT_BUSY) {
-		erts_smp_spin_lock(&dep->qlock);
-		dep->qflgs |= ERTS_DE_QFLG_BUSY;
-		erts_smp_spin_unlock(&dep->qlock);
+		erts_smp_spin_lock(&sp->qlock);
+		sp->qflgs |= ERTS_DE_QFLG_BUSY;
+		erts_smp_spin_unlock(&sp->qlock);
 		de_busy = prt_busy = 1;
 		if (oq.first && !preempt)
 		    goto finalize_only;
@@ -1854,6 +2482,78 @@ erts_dist_command(Port *prt, int reds_limit)
 	ASSERT(!oq.first);
 	ASSERT(!foq.first && !foq.last);
 
+	/*
+	 * Send from the streams of fragmented signals, one buffer
+	 * at a time from each in turn, while nothing else is
+	 * queued; other signals are not held up behind them.
+	 */
+	while (!preempt && !prt_busy) {
+	    ErtsDistOutputStream *stream, *done_stream = NULL;
+	    ErtsProcList *resumees = NULL;
+	    ErtsDistOutputBuf *sob;
+	    Uint size;
+
+	    erts_smp_spin_lock(&sp->qlock);
+	    stream = sp->streams;
+	    if (!stream || sp->out_queue.first) {
+		erts_smp_spin_unlock(&sp->qlock);
+		if (stream)
+		    erts_schedule_dist_command(prt, NULL);
+		break;
+	    }
+	    sob = stream->queue.first;
+	    stream->queue.first = sob->next;
+	    stream->size -= size_obuf(sob);
+	    sp->streams = stream->next;
+	    if (!stream->queue.first) {
+		done_stream = stream;
+		resumees = stream->suspended.first;
+	    }
+	    else {
+		ErtsDistOutputStream **spp = &sp->streams;
+		while (*spp)
+		    spp = &(*spp)->next;
+		*spp = stream;
+		stream->next = NULL;
+		if (stream->size < ERTS_DE_BUSY_LIMIT) {
+		    resumees = stream->suspended.first;
+		    stream->suspended.first = stream->suspended.last = NULL;
+		}
+	    }
+	    erts_smp_spin_unlock(&sp->qlock);
+
+	    if (done_stream)
+		erts_free(ERTS_ALC_T_DIST_STREAM, (void *) done_stream);
+	    if (resumees) {
+		int resumed = erts_resume_processes(resumees);
+		reds += resumed*ERTS_PORT_REDS_DIST_CMD_RESUMED;
+	    }
+
+	    if (!sob->frag_of) {
+		/* A signal sent after the fragmented one */
+		sob->extp = erts_encode_ext_dist_header_finalize(sob->extp,
+								 sp->cache);
+		reds += ERTS_PORT_REDS_DIST_CMD_FINALIZE;
+	    }
+	    ASSERT(&sob->data[0] <= sob->extp && sob->extp < sob->ext_endp);
+	    size = (*send)(prt, sob);
+#ifdef ERTS_RAW_DIST_MSG_DBG
+	    erts_fprintf(stderr, ">> ");
+	    bw(sob->extp, sob->ext_endp - sob->extp);
+#endif
+	    reds += ERTS_PORT_REDS_DIST_CMD_DATA(size);
+	    free_dist_obuf(sob);
+	    preempt = reds > reds_limit || (prt->status & ERTS_PORT_SFLGS_DEAD);
+	    if (prt->status & ERTS_PORT_SFLG_PORT_BUSY) {
+		erts_smp_spin_lock(&sp->qlock);
+		sp->qflgs |= ERTS_DE_QFLG_BUSY;
+		erts_smp_spin_unlock(&sp->qlock);
+		de_busy = prt_busy = 1;
+	    }
+	    else if (preempt && !(prt->status & ERTS_PORT_SFLGS_DEAD))
+		erts_schedule_dist_command(prt, NULL);
+	}
+
 	/*
 	 * Everything that was buffered when we started have now been
 	 * written to the port. If port isn't busy but dist entry is
@@ -1861,22 +2561,22 @@ erts_dist_command(Port *prt, int reds_limit)
 	 * dist entry in a non-busy state and resume suspended
 	 * processes.
 	 */
-	erts_smp_spin_lock(&dep->qlock);
-	ASSERT(dep->qsize >= obufsize);
-	dep->qsize -= obufsize;
+	erts_smp_spin_lock(&sp->qlock);
+	ASSERT(sp->qsize >= obufsize);
+	sp->qsize -= obufsize;
 	obufsize = 0;
-	if (de_busy && !prt_busy && dep->qsize < ERTS_DE_BUSY_LIMIT) {
+	if (de_busy && !prt_busy && sp->qsize < ERTS_DE_BUSY_LIMIT) {
 	    ErtsProcList *suspendees;
 	    int resumed;
-	    suspendees = get_suspended_on_de(dep, ERTS_DE_QFLG_BUSY);
-	    erts_smp_spin_unlock(&dep->qlock);
+	    suspendees = get_suspended_on_stripe(sp, ERTS_DE_QFLG_BUSY);
+	    erts_smp_spin_unlock(&sp->qlock);
 
 	    resumed = erts_resume_processes(suspendees);
 	    reds += resumed*ERTS_PORT_REDS_DIST_CMD_RESUMED;
 	    de_busy = 0;
 	}
 	else
-	    erts_smp_spin_unlock(&dep->qlock);
+	    erts_smp_spin_unlock(&sp->qlock);
     }
 
     ASSERT(!oq.first && !oq.last);
@@ -1885,20 +2585,20 @@ erts_dist_command(Port *prt, int reds_limit)
 
     if (obufsize != 0) {
 	ASSERT(obufsize > 0);
-	erts_smp_spin_lock(&dep->qlock);
-	ASSERT(dep->qsize >= obufsize);
-	dep->qsize -= obufsize;
-	erts_smp_spin_unlock(&dep->qlock);
+	erts_smp_spin_lock(&sp->qlock);
+	ASSERT(sp->qsize >= obufsize);
+	sp->qsize -= obufsize;
+	erts_smp_spin_unlock(&sp->qlock);
     }
 
     ASSERT(foq.first || !foq.last);
     ASSERT(!foq.first || foq.last);
-    ASSERT(!dep->finalized_out_queue.first);
-    ASSERT(!dep->finalized_out_queue.last);
+    ASSERT(!sp->finalized_out_queue.first);
+    ASSERT(!sp->finalized_out_queue.last);
 
     if (foq.first) {
-	dep->finalized_out_queue.first = foq.first;
-	dep->finalized_out_queue.last = foq.last;
+	sp->finalized_out_queue.first = foq.first;
+	sp->finalized_out_queue.last = foq.last;
     }
 
      /* Avoid wrapping reduction counter... */
@@ -1938,9 +2638,9 @@ erts_dist_command(Port *prt, int reds_limit)
 	foq.last = NULL;
 
 #ifdef DEBUG
-	erts_smp_spin_lock(&dep->qlock);
-	ASSERT(dep->qsize == obufsize);
-	erts_smp_spin_unlock(&dep->qlock);
+	erts_smp_spin_lock(&sp->qlock);
+	ASSERT(sp->qsize == obufsize);
+	erts_smp_spin_unlock(&sp->qlock);
 #endif
     }
     else {
@@ -1949,14 +2649,14 @@ erts_dist_command(Port *prt, int reds_limit)
 	     * Unhandle buffers need to be put back first
 	     * in out_queue.
 	     */
-	    erts_smp_spin_lock(&dep->qlock);
-	    dep->qsize -= obufsize;
+	    erts_smp_spin_lock(&sp->qlock);
+	    sp->qsize -= obufsize;
 	    obufsize = 0;
-	    oq.last->next = dep->out_queue.first;
-	    dep->out_queue.first = oq.first;
-	    if (!dep->out_queue.last)
-		dep->out_queue.last = oq.last;
-	    erts_smp_spin_unlock(&dep->qlock);
+	    oq.last->next = sp->out_queue.first;
+	    sp->out_queue.first = oq.first;
+	    if (!sp->out_queue.last)
+		sp->out_queue.last = oq.last;
+	    erts_smp_spin_unlock(&sp->qlock);
 	}
 
 	erts_schedule_dist_command(prt, NULL);
@@ -1980,12 +2680,12 @@ erts_kill_dist_connection(DistEntry *dep, Uint32 connection_id)
 
 	dep->status |= ERTS_DE_SFLG_EXITING;
 
-	erts_smp_spin_lock(&dep->qlock);
-	ASSERT(!(dep->qflgs & ERTS_DE_QFLG_EXIT));
-	dep->qflgs |= ERTS_DE_QFLG_EXIT;
-	erts_smp_spin_unlock(&dep->qlock);
+	erts_smp_spin_lock(&dep->primary.qlock);
+	ASSERT(!(dep->primary.qflgs & ERTS_DE_QFLG_EXIT));
+	dep->primary.qflgs |= ERTS_DE_QFLG_EXIT;
+	erts_smp_spin_unlock(&dep->primary.qlock);
 
-	erts_schedule_dist_command(NULL, dep);
+	erts_schedule_dist_command(NULL, &dep->primary);
     }
     erts_smp_de_rwunlock(dep);
 }
@@ -2259,13 +2959,131 @@ BIF_RETTYPE setnode_2(BIF_ALIST_2)
     BIF_ERROR(BIF_P, BADARG);
 }
 
+/*
+ * Make the port of an extra connection a distribution port of dep
+ * that is not yet attached; setnode_3 attaches the stripes when it
+ * installs the connection handler. Returns 0 if it couldn't.
+ */
+static int
+prepare_dist_stripe(Process *c_p, DistEntry *dep, Eterm id, Uint flags)
+{
+    ErtsDistStripe *sp;
+    Port *pp;
+    int res = 0;
+
+    pp = erts_id2port(id, c_p, ERTS_PROC_LOCK_MAIN);
+    if (!pp)
+	return 0;
+
+    if (pp->status & ERTS_PORT_SFLG_EXITING)
+	goto done;
+
+    if (pp->dist_entry) {
+	/* Prepared already if we yielded */
+	res = pp->dist_entry == dep && pp->dist_stripe;
+	goto done;
+    }
+
+    ASSERT(pp->drv_ptr->outputv || pp->drv_ptr->output);
+
+    sp = (ErtsDistStripe *) erts_alloc(ERTS_ALC_T_DIST_STRIPE,
+				       sizeof(ErtsDistStripe));
+    erts_init_dist_stripe(sp, make_small((Uint) atom_val(dep->sysname)));
+    sp->cid = id;
+    sp->send = (pp->drv_ptr->outputv
+		? dist_port_commandv
+		: dist_port_command);
+    if (flags & DFLAG_DIST_HDR_ATOM_CACHE)
+	create_cache(sp);
+
+    erts_smp_de_rwlock(dep);
+    if (is_nil(dep->cid) && !(dep->status & ERTS_DE_SFLG_EXITING)) {
+	if (dep->stripes)
+	    dep->stripes = (ErtsDistStripe **)
+		erts_realloc(ERTS_ALC_T_DIST_STRIPES,
+			     (void *) dep->stripes,
+			     sizeof(ErtsDistStripe *)*(dep->no_stripes + 1));
+	else
+	    dep->stripes = (ErtsDistStripe **)
+		erts_alloc(ERTS_ALC_T_DIST_STRIPES, sizeof(ErtsDistStripe *));
+	dep->stripes[dep->no_stripes++] = sp;
+	res = 1;
+    }
+    erts_smp_de_rwunlock(dep);
+
+    if (!res) {
+	delete_cache(sp->cache);
+	erts_smp_spinlock_destroy(&sp->qlock);
+	erts_free(ERTS_ALC_T_DIST_STRIPE, (void *) sp);
+	goto done;
+    }
+
+    erts_refc_inc(&dep->refc, 2);
+    pp->dist_entry = dep;
+    pp->dist_stripe = sp;
+    erts_port_status_bor_set(pp, ERTS_PORT_SFLG_DISTRIBUTION);
+
+ done:
+    erts_smp_port_unlock(pp);
+    return res;
+}
+
+/*
+ * Attach the prepared extra connections of the ports in the list
+ * stripe_ports, in that order. Stripes prepared for earlier attempts
+ * are dropped; their ports clean up when they exit.
+ */
+static int
+attach_dist_stripes(DistEntry *dep, Eterm stripe_ports, int no_stripes)
+{
+    ErtsDistStripe **stripes;
+    Eterm list;
+    int i, j;
+
+    ERTS_SMP_LC_ASSERT(erts_lc_rwmtx_is_rwlocked(&dep->rwmtx));
+
+    if (!no_stripes)
+	return 1;
+
+    stripes = (ErtsDistStripe **)
+	erts_alloc(ERTS_ALC_T_DIST_STRIPES,
+		   sizeof(ErtsDistStripe *)*no_stripes);
+    for (i = 0, list = stripe_ports; i < no_stripes; i++) {
+	Eterm *cons = list_val(list);
+	for (j = 0; j < dep->no_stripes; j++)
+	    if (dep->stripes[j] && dep->stripes[j]->cid == CAR(cons))
+		break;
+	if (j < dep->no_stripes) {
+	    int k;
+	    for (k = 0; k < i; k++)
+		if (stripes[k] == dep->stripes[j])
+		    j = dep->no_stripes; /* Same port twice */
+	}
+	if (j == dep->no_stripes) {
+	    erts_free(ERTS_ALC_T_DIST_STRIPES, (void *) stripes);
+	    return 0;
+	}
+	stripes[i] = dep->stripes[j];
+	list = CDR(cons);
+    }
+
+    for (i = 0; i < no_stripes; i++)
+	stripes[i]->attached = 1;
+    erts_free(ERTS_ALC_T_DIST_STRIPES, (void *) dep->stripes);
+    dep->stripes = stripes;
+    dep->no_stripes = no_stripes;
+    return 1;
+}
+
 /**********************************************************************
  ** Allocate a dist entry, set node name install the connection handler
  ** setnode_3({name@host, Creation}, Cid, {Type, Version, Initial, IC, OC})
+ ** setnode_3({name@host, Creation}, Cid, {Type, Version, IC, OC, Stripes})
  ** Type = flag field, where the flags are specified in dist.h
  ** Version = distribution version, >= 1
  ** IC = in_cookie (ignored)
  ** OC = out_cookie (ignored)
+ ** Stripes = ports of extra connections to the node (DFLAG_STRIPES)
  **
  ** Note that in distribution protocols above 1, the Initial parameter
  ** is always NIL and the cookies are always the atom '', cookies are not
@@ -2280,6 +3098,8 @@ BIF_RETTYPE setnode_3(BIF_ALIST_3)
     Uint flags;
     unsigned long version;
     Eterm ic, oc;
+    Eterm stripe_ports = NIL;
+    Sint no_stripes = 0;
     Eterm *tp;
     DistEntry *dep = NULL;
     Port *pp = NULL;
@@ -2300,17 +3120,30 @@ BIF_RETTYPE setnode_3(BIF_ALIST_3)
     if (!is_tuple(BIF_ARG_3))
 	goto badarg;
     tp = tuple_val(BIF_ARG_3);
-    if (*tp++ != make_arityval(4))
+    if (*tp != make_arityval(4) && *tp != make_arityval(5))
 	goto badarg;
-    if (!is_small(*tp))
+    if (*tp++ == make_arityval(5)) {
+	Eterm list;
+	stripe_ports = tp[4];
+	no_stripes = list_length(stripe_ports);
+	if (no_stripes < 0)
+	    goto badarg;
+	for (list = stripe_ports; is_list(list); list = CDR(list_val(list)))
+	    if (is_not_internal_port(CAR(list_val(list)))
+		|| CAR(list_val(list)) == BIF_ARG_2)
+		goto badarg;
+    }
+    /* DFLAG_STRIPES does not fit in a small on 32-bit machines */
+    if (!term_to_Uint(*tp++, &flags))
 	goto badarg;
-    flags = unsigned_val(*tp++);
     if (!is_small(*tp) || (version = unsigned_val(*tp)) == 0)
 	goto badarg;
     ic = *(++tp);
     oc = *(++tp);
     if (!is_atom(ic) || !is_atom(oc))
 	goto badarg;
+    if (no_stripes && !(flags & DFLAG_STRIPES))
+	goto badarg;
 
     /* DFLAG_EXTENDED_REFERENCES is compulsory from R9 and forward */
     if (!(DFLAG_EXTENDED_REFERENCES & flags)) {
@@ -2337,6 +3170,18 @@ BIF_RETTYPE setnode_3(BIF_ALIST_3)
     else if (!dep)
 	goto system_limit; /* Should never happen!!! */
 
+    if (no_stripes) {
+	/*
+	 * Ports are locked before the dist entry, so the stripes are
+	 * prepared before anything else. If the dist entry is busy
+	 * we find out below.
+	 */
+	Eterm list;
+	for (list = stripe_ports; is_list(list); list = CDR(list_val(list)))
+	    if (!prepare_dist_stripe(BIF_P, dep, CAR(list_val(list)), flags))
+		break;
+    }
+
     pp = erts_id2port(BIF_ARG_2, BIF_P, ERTS_PROC_LOCK_MAIN);
     erts_smp_de_rwlock(dep);
 
@@ -2351,13 +3196,13 @@ BIF_RETTYPE setnode_3(BIF_ALIST_3)
 	ErtsProcList *plp = erts_proclist_create(BIF_P);
 	plp->next = NULL;
 	erts_suspend(BIF_P, ERTS_PROC_LOCK_MAIN, NULL);
-	erts_smp_spin_lock(&dep->qlock);
-	if (dep->suspended.last)
-	    dep->suspended.last->next = plp;
+	erts_smp_spin_lock(&dep->primary.qlock);
+	if (dep->primary.suspended.last)
+	    dep->primary.suspended.last->next = plp;
 	else
-	    dep->suspended.first = plp;
-	dep->suspended.last = plp;
-	erts_smp_spin_unlock(&dep->qlock);
+	    dep->primary.suspended.first = plp;
+	dep->primary.suspended.last = plp;
+	erts_smp_spin_unlock(&dep->primary.qlock);
 	goto yield;
     }
 
@@ -2366,6 +3211,9 @@ BIF_RETTYPE setnode_3(BIF_ALIST_3)
     if (pp->dist_entry || is_not_nil(dep->cid))
 	goto badarg;
 
+    if (!attach_dist_stripes(dep, stripe_ports, (int) no_stripes))
+	goto badarg;
+
     erts_port_status_bor_set(pp, ERTS_PORT_SFLG_DISTRIBUTION);
 
     pp->dist_entry = dep;
@@ -2376,24 +3224,25 @@ BIF_RETTYPE setnode_3(BIF_ALIST_3)
     ASSERT(pp->drv_ptr->outputv || pp->drv_ptr->output);
 
 #if 1
-    dep->send = (pp->drv_ptr->outputv
+    dep->primary.send = (pp->drv_ptr->outputv
 		 ? dist_port_commandv
 		 : dist_port_command);
 #else
-    dep->send = dist_port_command;
+    dep->primary.send = dist_port_command;
 #endif
-    ASSERT(dep->send);
+    ASSERT(dep->primary.send);
+    dep->primary.cid = BIF_ARG_2;
 
 #ifdef DEBUG
-    erts_smp_spin_lock(&dep->qlock);
-    ASSERT(dep->qsize == 0);
-    erts_smp_spin_unlock(&dep->qlock);
+    erts_smp_spin_lock(&dep->primary.qlock);
+    ASSERT(dep->primary.qsize == 0);
+    erts_smp_spin_unlock(&dep->primary.qlock);
 #endif
 
     erts_set_dist_entry_connected(dep, BIF_ARG_2, flags);
 
     if (flags & DFLAG_DIST_HDR_ATOM_CACHE)
-	create_cache(dep);
+	create_cache(&dep->primary);
 
     erts_smp_de_rwunlock(dep);
     dep = NULL; /* inc of refc transferred to port (dist_entry field) */
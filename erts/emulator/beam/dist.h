@@ -38,6 +38,8 @@
 #define DFLAG_UNICODE_IO          0x1000
 #define DFLAG_DIST_HDR_ATOM_CACHE 0x2000
 #define DFLAG_SMALL_ATOM_TAGS     0x4000
+#define DFLAG_FRAGMENTS           0x800000
+#define DFLAG_STRIPES             0x80000000
 
 /* All flags that should be enabled when term_to_binary/1 is used. */
 #define TERM_TO_BINARY_DFLAGS (DFLAG_EXTENDED_REFERENCES	\
@@ -101,6 +103,7 @@ typedef struct {
 
 
 extern int erts_is_alive;
+extern int erts_dsig_sender_busy(ErtsDistStripe *, Eterm);
 
 /*
  * erts_dsig_prepare() prepares a send of a distributed signal.
@@ -127,10 +130,30 @@ ERTS_GLB_INLINE int erts_dsig_prepare(ErtsDSigData *,
 				      int);
 
 ERTS_GLB_INLINE
-void erts_schedule_dist_command(Port *, DistEntry *);
+void erts_schedule_dist_command(Port *, ErtsDistStripe *);
+ERTS_GLB_INLINE
+ErtsDistStripe *erts_dist_sender_stripe(DistEntry *, Eterm);
 
 #if ERTS_GLB_INLINE_INCL_FUNC_DEF
 
+/*
+ * The connection that the signals of a sender go over; NULL if it
+ * is gone (and the connection to the node about to go down).
+ */
+ERTS_GLB_INLINE ErtsDistStripe *
+erts_dist_sender_stripe(DistEntry *dep, Eterm sender)
+{
+    Uint ix;
+
+    ERTS_SMP_LC_ASSERT(erts_lc_rwmtx_is_rlocked(&dep->rwmtx)
+		       || erts_lc_rwmtx_is_rwlocked(&dep->rwmtx));
+
+    if (!dep->no_stripes || !is_internal_pid(sender))
+	return &dep->primary;
+    ix = internal_pid_number(sender) % (dep->no_stripes + 1);
+    return ix == 0 ? &dep->primary : dep->stripes[ix - 1];
+}
+
 ERTS_GLB_INLINE int 
 erts_dsig_prepare(ErtsDSigData *dsdp,
 		  DistEntry *dep,
@@ -152,13 +175,12 @@ erts_dsig_prepare(ErtsDSigData *dsdp,
 	goto fail;
     }
     if (no_suspend) {
-	failure = ERTS_DSIG_PREP_CONNECTED;
-	erts_smp_spin_lock(&dep->qlock);
-	if (dep->qflgs & ERTS_DE_QFLG_BUSY)
+	ErtsDistStripe *sp = erts_dist_sender_stripe(dep,
+						     proc ? proc->id : NIL);
+	if (sp && erts_dsig_sender_busy(sp, proc ? proc->id : NIL)) {
 	    failure = ERTS_DSIG_PREP_WOULD_SUSPEND;
-	erts_smp_spin_unlock(&dep->qlock);
-	if (failure == ERTS_DSIG_PREP_WOULD_SUSPEND)
 	    goto fail;
+	}
     }
     dsdp->proc = proc;
     dsdp->dep = dep;
@@ -179,9 +201,9 @@ erts_dsig_prepare(ErtsDSigData *dsdp,
 }
 
 ERTS_GLB_INLINE
-void erts_schedule_dist_command(Port *prt, DistEntry *dist_entry)
+void erts_schedule_dist_command(Port *prt, ErtsDistStripe *stripe)
 {
-    DistEntry *dep;
+    ErtsDistStripe *sp;
     Eterm id;
 
     if (prt) {
@@ -189,22 +211,22 @@ void erts_schedule_dist_command(Port *prt, DistEntry *dist_entry)
 	ASSERT((erts_port_status_get(prt) & ERTS_PORT_SFLGS_DEAD) == 0);
 	ASSERT(prt->dist_entry);
 
-	dep = prt->dist_entry;
+	sp = (prt->dist_stripe
+	      ? prt->dist_stripe
+	      : &prt->dist_entry->primary);
 	id = prt->id;
     }
     else {
-	ASSERT(dist_entry);
-	ERTS_SMP_LC_ASSERT(erts_lc_rwmtx_is_rlocked(&dist_entry->rwmtx)
-			   || erts_lc_rwmtx_is_rwlocked(&dist_entry->rwmtx));
-	ASSERT(is_internal_port(dist_entry->cid));
+	ASSERT(stripe);
+	ASSERT(is_internal_port(stripe->cid));
 
- 	dep = dist_entry;
-	id = dep->cid;
+ 	sp = stripe;
+	id = sp->cid;
     }
 
-    if (!erts_smp_atomic_xchg(&dep->dist_cmd_scheduled, 1)) {
+    if (!erts_smp_atomic_xchg(&sp->dist_cmd_scheduled, 1)) {
 	(void) erts_port_task_schedule(id,
-				       &dep->dist_cmd,
+				       &sp->dist_cmd,
 				       ERTS_PORT_TASK_DIST_CMD,
 				       (ErlDrvEvent) -1,
 				       NULL);
@@ -279,7 +301,8 @@ extern int erts_dsig_send_exit(ErtsDSigData *, Eterm, Eterm, Eterm);
 extern int erts_dsig_send_exit2(ErtsDSigData *, Eterm, Eterm, Eterm);
 extern int erts_dsig_send_demonitor(ErtsDSigData *, Eterm, Eterm, Eterm, int);
 extern int erts_dsig_send_monitor(ErtsDSigData *, Eterm, Eterm, Eterm);
-extern int erts_dsig_send_m_exit(ErtsDSigData *, Eterm, Eterm, Eterm, Eterm);
+extern int erts_dsig_send_m_exit(ErtsDSigData *, Eterm, Eterm, Eterm, Eterm,
+				 Eterm);
 
 extern int erts_dist_command(Port *prt, int reds);
 extern void erts_dist_port_not_busy(Port *prt);
@@ -884,6 +884,24 @@ get_kb_value(char *param_end, char** argv, int* ip)
 	return ((Uint) tmp)*1024;
 }
 
+static Uint
+get_mb_value(char *param_end, char** argv, int* ip)
+{
+    Sint tmp;
+    Uint max = ((~((Uint) 0))/(1024*1024)) + 1;
+    char *rest;
+    char *param = argv[*ip]+1;
+    char *value = get_value(param_end, argv, ip);
+    errno = 0;
+    tmp = (Sint) strtol(value, &rest, 10);
+    if (errno != 0 || rest == value || tmp < 0 || max < ((Uint) tmp))
+	bad_value(param, param_end, value);
+    if (max == (Uint) tmp)
+	return ~((Uint) 0);
+    else
+	return ((Uint) tmp)*1024*1024;
+}
+
 static Uint
 get_amount_value(char *param_end, char** argv, int* ip)
 {
@@ -1134,6 +1152,18 @@ handle_args(int *argc, char **argv, erts_alc_hndl_args_init_t *init)
 #endif
 			    get_amount_value(argv[i]+6, argv, &i);
 		    }
+		    else if (has_prefix("scs", argv[i]+3)) {
+#if HAVE_ERTS_MSEG
+			init->mseg.scs =
+#endif
+			    get_mb_value(argv[i]+6, argv, &i);
+		    }
+		    else if (has_prefix("sco", argv[i]+3)) {
+#if HAVE_ERTS_MSEG
+			init->mseg.sco =
+#endif
+			    get_bool_value(argv[i]+6, argv, &i);
+		    }
 		    else {
 			bad_param(param, param+2);
 		    }
@@ -1839,6 +1869,7 @@ erts_memory(int *print_to_p, void *print_to_arg, void *proc, Eterm earg)
 	size.code += efi.used;
 	size.code += allocated_modules*sizeof(Range);
 	size.code += erts_total_code_size;
+	size.code += erts_smp_atomic_read(&erts_total_literal_size);
     }
 
     if (want.ets) {
@@ -2003,7 +2034,8 @@ erts_allocated_areas(int *print_to_p, void *print_to_arg, void *proc)
 
     values[i].arity = 2;
     values[i].name = "loaded_code";
-    values[i].ui[0] = erts_total_code_size;
+    values[i].ui[0] = (erts_total_code_size
+			+ erts_smp_atomic_read(&erts_total_literal_size));
     i++;
 
     values[i].arity = 2;
@@ -25,32 +25,49 @@
 #include "global.h"
 #include "erl_threads.h"
 
-typedef struct _erl_async {
+struct _erl_async {
     struct _erl_async* next;
     struct _erl_async* prev;
+    struct _erl_async* knext;  /* Next job with the same key */
+    struct _erl_async* ktail;  /* Last job with the same key (first job only) */
+    struct _erl_async* hnext;  /* Key hash chain (first job only) */
     DE_Handle*         hndl;   /* The DE_Handle is needed when port is gone */
     Eterm              port;
     long               async_id;
+    int                keyed;
+    unsigned int       key;
+    SysTimeval         queued;
     void*              async_data;
     ErlDrvPDL          pdl;
     void (*async_invoke)(void*);
     void (*async_free)(void*);
-} ErlAsync;
+};
+
+/*
+ * All async threads take jobs from one shared queue, so a thread
+ * blocked in a slow job does not hold up jobs that any other thread
+ * could run. Jobs scheduled with a key are run in order, one at a
+ * time, per key value: only the first job of a key is in the queue,
+ * the others wait in the key's chain until it has finished and are
+ * then queued one by one. The first job of each key, queued or
+ * running, is found in the keys hash table.
+ */
+
+#define ASYNC_KEY_HASH_SIZE 256
 
 typedef struct {
     erts_mtx_t mtx;
     erts_cnd_t cv;
-    erts_tid_t thr;
-    int   len;
-#ifndef ERTS_SMP
-    int   hndl;
-#endif
-    ErlAsync* head;
-    ErlAsync* tail;
-#ifdef ERTS_ENABLE_LOCK_CHECK
-    int no;
-#endif
-} AsyncQueue;
+    int   len;			/* Jobs not yet started */
+    ErlAsync* head;		/* Newest job in queue */
+    ErlAsync* tail;		/* Next job to run */
+    ErlAsync* keys[ASYNC_KEY_HASH_SIZE];
+    /* Statistics */
+    int   max_len;
+    Uint  jobs;
+    Uint  total_wait;		/* Micro seconds between queued and started */
+    Uint  max_wait;
+} AsyncPool;
 
 static erts_smp_spinlock_t async_id_lock;
 static long async_id = 0;
@@ -77,15 +94,18 @@ static void async_detach(DE_Handle* dh)
 
 #ifdef USE_THREADS
 
-static AsyncQueue* async_q;
+static AsyncPool async_pool;
+static erts_tid_t* async_thr;
+#ifndef ERTS_SMP
+static int async_hndl;
+#endif
 
 static void* async_main(void*);
-static void async_add(ErlAsync*, AsyncQueue*);
+static void async_add(ErlAsync*);
 
 int init_async(int hndl)
 {
     erts_thr_opts_t thr_opts = ERTS_THR_OPTS_DEFAULT_INITER;
-    AsyncQueue* q;
     int i;
 
     thr_opts.detached = 0;
@@ -94,31 +114,30 @@ int init_async(int hndl)
 #ifndef ERTS_SMP
     erts_mtx_init(&async_ready_mtx, "async_ready");
     async_ready_list = NULL;
+    async_hndl = hndl;
 #endif
 
     async_id = 0;
     erts_smp_spinlock_init(&async_id_lock, "async_id");
 
-    async_q = q = (AsyncQueue*)
-	(erts_async_max_threads
-	 ? erts_alloc(ERTS_ALC_T_ASYNC_Q,
-		      erts_async_max_threads * sizeof(AsyncQueue))
-	 : NULL);
-    for (i = 0; i < erts_async_max_threads; i++) {
-	q->head = NULL;
-	q->tail = NULL;
-	q->len = 0;
-#ifndef ERTS_SMP
-	q->hndl = hndl;
-#endif
-#ifdef ERTS_ENABLE_LOCK_CHECK
-	q->no = i;
-#endif
-	erts_mtx_init(&q->mtx, "asyncq");
-	erts_cnd_init(&q->cv);
-	erts_thr_create(&q->thr, async_main, (void*)q, &thr_opts);
-	q++;
-    }
+    async_pool.len = 0;
+    async_pool.head = NULL;
+    async_pool.tail = NULL;
+    for (i = 0; i < ASYNC_KEY_HASH_SIZE; i++)
+	async_pool.keys[i] = NULL;
+    async_pool.max_len = 0;
+    async_pool.jobs = 0;
+    async_pool.total_wait = 0;
+    async_pool.max_wait = 0;
+    erts_mtx_init(&async_pool.mtx, "asyncq");
+    erts_cnd_init(&async_pool.cv);
+
+    async_thr = (erts_async_max_threads
+		 ? erts_alloc(ERTS_ALC_T_ASYNC_Q,
+			      erts_async_max_threads * sizeof(erts_tid_t))
+		 : NULL);
+    for (i = 0; i < erts_async_max_threads; i++)
+	erts_thr_create(&async_thr[i], async_main, (void*) (long) i, &thr_opts);
     return 0;
 }
 
@@ -127,29 +146,42 @@ int exit_async()
 {
     int i;
 
-    /* terminate threads */
+    /* terminate threads; each of them takes one of these and exits */
     for (i = 0; i < erts_async_max_threads; i++) {
 	ErlAsync* a = (ErlAsync*) erts_alloc(ERTS_ALC_T_ASYNC,
 					     sizeof(ErlAsync));
 	a->port = NIL;
-	async_add(a, &async_q[i]);
+	a->async_id = 0;
+	a->keyed = 0;
+	async_add(a);
     }
 
-    for (i = 0; i < erts_async_max_threads; i++) {
-	erts_thr_join(async_q[i].thr, NULL);
-	erts_mtx_destroy(&async_q[i].mtx);
-	erts_cnd_destroy(&async_q[i].cv);
-    }
+    for (i = 0; i < erts_async_max_threads; i++)
+	erts_thr_join(async_thr[i], NULL);
+    erts_mtx_destroy(&async_pool.mtx);
+    erts_cnd_destroy(&async_pool.cv);
 #ifndef ERTS_SMP
     erts_mtx_destroy(&async_ready_mtx);
 #endif
-    if (async_q)
-	erts_free(ERTS_ALC_T_ASYNC_Q, (void *) async_q);
+    if (async_thr)
+	erts_free(ERTS_ALC_T_ASYNC_Q, (void *) async_thr);
     return 0;
 }
 
+/* Put a job first in line (at head) of the queue. Pool lock held. */
+static ERTS_INLINE void async_enqueue(ErlAsync* a)
+{
+    a->prev = NULL;
+    a->next = async_pool.head;
+    if (async_pool.head)
+	async_pool.head->prev = a;
+    else
+	async_pool.tail = a;
+    async_pool.head = a;
+    erts_cnd_signal(&async_pool.cv);
+}
 
-static void async_add(ErlAsync* a, AsyncQueue* q)
+static void async_add(ErlAsync* a)
 {
     /* XXX:PaN Is this still necessary when ports lock drivers? */
     if (is_internal_port(a->port)) {
@@ -158,96 +190,297 @@ static void async_add(ErlAsync* a, AsyncQueue* q)
 	driver_lock_driver(internal_port_index(a->port));
     }
 
-    erts_mtx_lock(&q->mtx);
-
-    if (q->len == 0) {
-	q->head = a;
-	q->tail = a;
-	q->len = 1;
-	erts_cnd_signal(&q->cv);
-    }
-    else { /* no need to signal (since the worker is working) */
-	a->next = q->head;
-	q->head->prev = a;
-	q->head = a;
-	q->len++;
+    a->next = NULL;
+    a->prev = NULL;
+    a->knext = NULL;
+    sys_gettimeofday(&a->queued);
+
+    erts_mtx_lock(&async_pool.mtx);
+
+    if (++async_pool.len > async_pool.max_len)
+	async_pool.max_len = async_pool.len;
+
+    if (a->keyed) {
+	ErlAsync** kpp = &async_pool.keys[a->key % ASYNC_KEY_HASH_SIZE];
+	ErlAsync* first;
+
+	for (first = *kpp; first; first = first->hnext)
+	    if (first->key == a->key)
+		break;
+	if (first) { /* wait for the earlier jobs with this key */
+	    first->ktail->knext = a;
+	    first->ktail = a;
+	    erts_mtx_unlock(&async_pool.mtx);
+	    return;
+	}
+	a->ktail = a;
+	a->hnext = *kpp;
+	*kpp = a;
     }
-    erts_mtx_unlock(&q->mtx);
+    async_enqueue(a);
+
+    erts_mtx_unlock(&async_pool.mtx);
 }
 
-static ErlAsync* async_get(AsyncQueue* q)
+static ErlAsync* async_get(void)
 {
     ErlAsync* a;
+    SysTimeval now;
+    Sint wait;
 
-    erts_mtx_lock(&q->mtx);
-    while((a = q->tail) == NULL) {
-	erts_cnd_wait(&q->cv, &q->mtx);
+    erts_mtx_lock(&async_pool.mtx);
+    while((a = async_pool.tail) == NULL) {
+	erts_cnd_wait(&async_pool.cv, &async_pool.mtx);
     }
-#ifdef ERTS_SMP
-    ASSERT(a && q->tail == a);
-#endif
-    if (q->head == q->tail) {
-	q->head = q->tail = NULL;
-	q->len = 0;
+    if (async_pool.head == async_pool.tail) {
+	async_pool.head = async_pool.tail = NULL;
     }
     else {
-	q->tail->prev->next = NULL;
-	q->tail = q->tail->prev;
-	q->len--;
+	async_pool.tail->prev->next = NULL;
+	async_pool.tail = async_pool.tail->prev;
     }
-    erts_mtx_unlock(&q->mtx);
+    async_pool.len--;
+
+    sys_gettimeofday(&now);
+    wait = ((Sint) (now.tv_sec - a->queued.tv_sec))*1000000
+	+ (now.tv_usec - a->queued.tv_usec);
+    if (wait < 0)
+	wait = 0;
+    async_pool.jobs++;
+    async_pool.total_wait += (Uint) wait;
+    if ((Uint) wait > async_pool.max_wait)
+	async_pool.max_wait = (Uint) wait;
+
+    erts_mtx_unlock(&async_pool.mtx);
     return a;
 }
 
+/*
+ * A keyed job has been run; let the next job with the same key
+ * (if any) take its place as first job of the key, and queue it to
+ * be run next.
+ */
+static void async_done(ErlAsync* a)
+{
+    ErlAsync** kpp;
+    ErlAsync* next;
+
+    if (!a->keyed)
+	return;
+
+    erts_mtx_lock(&async_pool.mtx);
+    kpp = &async_pool.keys[a->key % ASYNC_KEY_HASH_SIZE];
+    while (*kpp != a)
+	kpp = &(*kpp)->hnext;
+    next = a->knext;
+    if (next) {
+	next->ktail = a->ktail;
+	next->hnext = a->hnext;
+	*kpp = next;
+	/* Run it next; it has waited since it was scheduled */
+	next->next = NULL;
+	next->prev = async_pool.tail;
+	if (async_pool.tail)
+	    async_pool.tail->next = next;
+	else
+	    async_pool.head = next;
+	async_pool.tail = next;
+	erts_cnd_signal(&async_pool.cv);
+    }
+    else
+	*kpp = a->hnext;
+    erts_mtx_unlock(&async_pool.mtx);
+}
+
 
 static int async_del(long id)
 {
+    ErlAsync* a;
+    ErlAsync* first;
     int i;
-    /* scan all queue for an entry with async_id == 'id' */
 
-    for (i = 0; i < erts_async_max_threads; i++) {
-	ErlAsync* a;
-	erts_mtx_lock(&async_q[i].mtx);
-	
-	a = async_q[i].head;
-	while(a != NULL) {
-	    if (a->async_id == id) {
+    erts_mtx_lock(&async_pool.mtx);
+
+    /* jobs first in line of their key (or without key) */
+    for (a = async_pool.head; a != NULL; a = a->next) {
+	if (a->async_id == id) {
+	    ErlAsync* next = a->keyed ? a->knext : NULL;
+	    if (a->keyed) {
+		ErlAsync** kpp = &async_pool.keys[a->key % ASYNC_KEY_HASH_SIZE];
+		while (*kpp != a)
+		    kpp = &(*kpp)->hnext;
+		if (next) {
+		    next->ktail = a->ktail;
+		    next->hnext = a->hnext;
+		    *kpp = next;
+		}
+		else
+		    *kpp = a->hnext;
+	    }
+	    if (next) { /* takes the place of the cancelled job */
+		next->prev = a->prev;
+		next->next = a->next;
+		if (a->prev != NULL)
+		    a->prev->next = next;
+		else
+		    async_pool.head = next;
+		if (a->next != NULL)
+		    a->next->prev = next;
+		else
+		    async_pool.tail = next;
+	    }
+	    else {
 		if (a->prev != NULL)
 		    a->prev->next = a->next;
 		else
-		    async_q[i].head = a->next;
+		    async_pool.head = a->next;
 		if (a->next != NULL)
 		    a->next->prev = a->prev;
 		else
-		    async_q[i].tail = a->prev;
-		async_q[i].len--;
-		erts_mtx_unlock(&async_q[i].mtx);
-		if (a->async_free != NULL)
-		    a->async_free(a->async_data);
-		async_detach(a->hndl);
-		erts_free(ERTS_ALC_T_ASYNC, a);
-		return 1;
+		    async_pool.tail = a->prev;
+	    }
+	    goto found;
+	}
+    }
+
+    /* jobs waiting for earlier jobs with the same key */
+    for (i = 0; i < ASYNC_KEY_HASH_SIZE; i++) {
+	for (first = async_pool.keys[i]; first; first = first->hnext) {
+	    ErlAsync* prev = first;
+	    for (a = first->knext; a != NULL; prev = a, a = a->knext) {
+		if (a->async_id == id) {
+		    prev->knext = a->knext;
+		    if (first->ktail == a)
+			first->ktail = prev;
+		    goto found;
+		}
 	    }
 	}
-	erts_mtx_unlock(&async_q[i].mtx);
     }
+
+    erts_mtx_unlock(&async_pool.mtx);
     return 0;
+
+ found:
+    async_pool.len--;
+    erts_mtx_unlock(&async_pool.mtx);
+    if (a->async_free != NULL)
+	a->async_free(a->async_data);
+    async_detach(a->hndl);
+    erts_free(ERTS_ALC_T_ASYNC, a);
+    return 1;
 }
 
-static void* async_main(void* arg)
+#ifdef ERTS_SMP
+
+/*
+ * Put a finished job in the async queue of its port, and schedule an
+ * async port task to deliver it unless one is already pending. The
+ * port lock is not needed, so the async thread never waits for a
+ * port that is busy on a scheduler.
+ */
+static void async_post(ErlAsync* a)
+{
+    Eterm id = a->port;
+    Port *p = &erts_port[internal_port_index(id)];
+    int schedule;
+
+    erts_smp_port_state_lock(p);
+    if (ERTS_INVALID_PORT_OPT(p, id, ERTS_PORT_SFLGS_INVALID_DRIVER_LOOKUP)) {
+	erts_smp_port_state_unlock(p);
+	if (a->async_free)
+	    (*a->async_free)(a->async_data);
+	async_done(a);
+	erts_free(ERTS_ALC_T_ASYNC, (void *) a);
+	return;
+    }
+    a->next = NULL;
+    schedule = !p->async_first;
+    if (schedule)
+	p->async_first = a;
+    else
+	p->async_last->next = a;
+    p->async_last = a;
+    erts_smp_port_state_unlock(p);
+
+    /*
+     * If the port dies before the task is executed, the queue is
+     * freed by terminate_port().
+     */
+    if (schedule)
+	(void) erts_port_task_schedule(id, NULL, ERTS_PORT_TASK_ASYNC,
+				       (ErlDrvEvent) -1, NULL);
+}
+
+/*
+ * Deliver the finished jobs queued to the port, in the order they
+ * finished. Called from the async port task with the port locked.
+ * Returns the number of jobs delivered.
+ */
+int erts_async_deliver(Port *p)
+{
+    ErlAsync *a, *next;
+    int n = 0;
+
+    ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(p));
+
+    erts_smp_port_state_lock(p);
+    a = p->async_first;
+    p->async_first = p->async_last = NULL;
+    erts_smp_port_state_unlock(p);
+
+    for (; a; a = next) {
+	next = a->next;
+	if (!(p->status & ERTS_PORT_SFLGS_INVALID_DRIVER_LOOKUP)) {
+	    if (async_ready(p, a->async_data)) {
+		if (a->async_free)
+		    (*a->async_free)(a->async_data);
+	    }
+	    async_detach(a->hndl);
+	    n++;
+	}
+	else if (a->async_free)
+	    (*a->async_free)(a->async_data);
+	/* the next job with this key may run when this one is delivered */
+	async_done(a);
+	erts_free(ERTS_ALC_T_ASYNC, (void *) a);
+    }
+    return n;
+}
+
+/* Drop finished jobs of a terminated port */
+void erts_async_free_ready(Port *p)
 {
-    AsyncQueue* q = (AsyncQueue*) arg;
+    ErlAsync *a, *next;
+
+    erts_smp_port_state_lock(p);
+    a = p->async_first;
+    p->async_first = p->async_last = NULL;
+    erts_smp_port_state_unlock(p);
+
+    for (; a; a = next) {
+	next = a->next;
+	if (a->async_free)
+	    (*a->async_free)(a->async_data);
+	async_done(a);
+	erts_free(ERTS_ALC_T_ASYNC, (void *) a);
+    }
+}
 
+#endif /* ERTS_SMP */
+
+static void* async_main(void* arg)
+{
 #ifdef ERTS_ENABLE_LOCK_CHECK
     {
 	char buf[27];
-	erts_snprintf(&buf[0], 27, "async %d", q->no);
+	erts_snprintf(&buf[0], 27, "async %d", (int) (long) arg);
 	erts_lc_set_thread_name(&buf[0]);
     }
 #endif
 
     while(1) {
-	ErlAsync* a = async_get(q);
+	ErlAsync* a = async_get();
 
 	if (a->port == NIL) { /* TIME TO DIE SIGNAL */
 	    erts_free(ERTS_ALC_T_ASYNC, (void *) a);
@@ -257,39 +490,17 @@ static void* async_main(void* arg)
 	    (*a->async_invoke)(a->async_data);
 	    /* Major problem if the code for async_invoke
 	       or async_free is removed during a blocking operation */
-#ifdef ERTS_SMP
-	    {
-		Port *p;
-		p = erts_id2port_sflgs(a->port,
-				       NULL,
-				       0,
-				       ERTS_PORT_SFLGS_INVALID_DRIVER_LOOKUP);
-		if (!p) {
-		    if (a->async_free)
-			(*a->async_free)(a->async_data);
-		}
-		else {
-		    if (async_ready(p, a->async_data)) {
-			if (a->async_free)
-			    (*a->async_free)(a->async_data);
-		    }
-		    async_detach(a->hndl);
-		    erts_port_release(p);
-		}
-		if (a->pdl) {
-		    driver_pdl_dec_refc(a->pdl);
-		}
-		erts_free(ERTS_ALC_T_ASYNC, (void *) a);
-	    }
-#else
 	    if (a->pdl) {
 		driver_pdl_dec_refc(a->pdl);
 	    }
+#ifdef ERTS_SMP
+	    async_post(a);
+#else
 	    erts_mtx_lock(&async_ready_mtx);
 	    a->next = async_ready_list;
 	    async_ready_list = a;
 	    erts_mtx_unlock(&async_ready_mtx);
-	    sys_async_ready(q->hndl);
+	    sys_async_ready(async_hndl);
 #endif
 	}
     }
@@ -332,6 +543,9 @@ int check_async_ready(void)
 	    async_detach(a->hndl);
 	    erts_port_release(p);
 	}
+#ifdef USE_THREADS
+	async_done(a);
+#endif
 	erts_free(ERTS_ALC_T_ASYNC, (void *) a);
 	a = a_next;
     }
@@ -350,7 +564,8 @@ int check_async_ready(void)
 **  N  handle value (used with async_cancel)
 **  arguments:
 **      ix             driver index 
-**      key            pointer to secedule queue (NULL means round robin)
+**      key            pointer to key; jobs with the same key value are run
+**                     in sequence (NULL means no ordering)
 **      async_invoke   function to run in thread
 **      async_data     data to pass to invoke function
 **      async_free     function for relase async_data in case of failure
@@ -362,8 +577,6 @@ long driver_async(ErlDrvPort ix, unsigned int* key,
     ErlAsync* a = (ErlAsync*) erts_alloc(ERTS_ALC_T_ASYNC, sizeof(ErlAsync));
     Port* prt = erts_drvport2port(ix);
     long id;
-    unsigned int qix;
-
 
     if (!prt)
 	return -1;
@@ -388,14 +601,11 @@ long driver_async(ErlDrvPort ix, unsigned int* key,
 
     a->async_id = id;
 
-    if (key == NULL) {
-	qix = (erts_async_max_threads > 0)
-	    ? (id % erts_async_max_threads) : 0;
-    }
+    if (key == NULL)
+	a->keyed = 0;
     else {
-	qix = (erts_async_max_threads > 0) ? 
-	    (*key % erts_async_max_threads) : 0;
-	*key = qix;
+	a->keyed = 1;
+	a->key = *key;
     }
 #ifdef USE_THREADS
     if (erts_async_max_threads > 0) {
@@ -403,7 +613,7 @@ long driver_async(ErlDrvPort ix, unsigned int* key,
 	    driver_pdl_inc_refc(prt->port_data_lock);
 	    a->pdl = prt->port_data_lock;
 	}
-	async_add(a, &async_q[qix]);
+	async_add(a);
 	return id;
     }
 #endif
@@ -428,7 +638,40 @@ int driver_async_cancel(unsigned int id)
     return 0;
 }
 
+/*
+ * Queue length and wait time (from driver_async() until a thread
+ * starts the job) statistics for the async thread pool, as
+ * [{queue_length, N}, {max_queue_length, N}, {jobs, N},
+ *  {total_wait_time, MicroSecs}, {max_wait_time, MicroSecs}]
+ */
+Eterm erts_async_statistics(Process *p)
+{
+    Eterm tags[5];
+    Uint values[5];
+    Uint sz;
+    Uint *hp;
+
+    tags[0] = am_atom_put("queue_length", 12);
+    tags[1] = am_atom_put("max_queue_length", 16);
+    tags[2] = am_atom_put("jobs", 4);
+    tags[3] = am_atom_put("total_wait_time", 15);
+    tags[4] = am_atom_put("max_wait_time", 13);
+#ifdef USE_THREADS
+    if (erts_async_max_threads > 0) {
+	erts_mtx_lock(&async_pool.mtx);
+	values[0] = (Uint) async_pool.len;
+	values[1] = (Uint) async_pool.max_len;
+	values[2] = async_pool.jobs;
+	values[3] = async_pool.total_wait;
+	values[4] = async_pool.max_wait;
+	erts_mtx_unlock(&async_pool.mtx);
+    }
+    else
+#endif
+	values[0] = values[1] = values[2] = values[3] = values[4] = 0;
 
-
-
-
+    sz = 0;
+    (void) erts_bld_atom_uint_2tup_list(NULL, &sz, 5, tags, values);
+    hp = HAlloc(p, sz);
+    return erts_bld_atom_uint_2tup_list(&hp, NULL, 5, tags, values);
+}
@@ -1423,7 +1423,7 @@ process_info_aux(Process *BIF_P,
         DECL_AM(minor_gcs);
         Eterm t;
 
-	hp = HAlloc(BIF_P, 3+2+3+2+3);
+	hp = HAlloc(BIF_P, 3+2+3+2+3+2+3);
 	t = TUPLE2(hp, AM_minor_gcs, make_small(GEN_GCS(rp)));
 	hp += 3;
 	res = CONS(hp, t, NIL);
@@ -1432,6 +1432,10 @@ process_info_aux(Process *BIF_P,
 	hp += 3;
 	res = CONS(hp, t, res);
 	hp += 2;
+	t = TUPLE2(hp, am_min_bin_vheap_size, make_small(MIN_VHEAP_SIZE(rp)));
+	hp += 3;
+	res = CONS(hp, t, res);
+	hp += 2;
 	break;
     }
 
@@ -1623,6 +1627,18 @@ info_1_tuple(Process* BIF_P,	/* Pointer to current process. */
 	    goto badarg;
     } else if (sel == am_allocator && arity == 2) {
 	return erts_allocator_info_term(BIF_P, *tp, 0);
+    } else if (sel == am_heap_size_hint && arity == 2) {
+	Eterm* mfa;
+	if (!is_tuple_arity(*tp, 3))
+	    goto badarg;
+	mfa = tuple_val(*tp);
+	if (!is_atom(mfa[1]) || !is_atom(mfa[2]) || !is_small(mfa[3])
+	    || signed_val(mfa[3]) < 0)
+	    goto badarg;
+	return erts_heap_size_hint_term(BIF_P,
+					erts_find_export_entry(mfa[1],
+							       mfa[2],
+							       unsigned_val(mfa[3])));
     } else if (ERTS_IS_ATOM_STR("internal_cpu_topology", sel) && arity == 2) {
 	return erts_get_cpu_topology_term(BIF_P, *tp);
     } else if (ERTS_IS_ATOM_STR("cpu_topology", sel) && arity == 2) {
@@ -2444,6 +2460,8 @@ BIF_RETTYPE system_info_1(BIF_ALIST_1)
 	BIF_RET(erts_sched_stat_term(BIF_P, 0));
     } else if (ERTS_IS_ATOM_STR("total_scheduling_statistics", BIF_ARG_1)) {
 	BIF_RET(erts_sched_stat_term(BIF_P, 1));
+    } else if (ERTS_IS_ATOM_STR("thread_pool_statistics", BIF_ARG_1)) {
+	BIF_RET(erts_async_statistics(BIF_P));
     }
 
     BIF_ERROR(BIF_P, BADARG);
@@ -3322,7 +3340,7 @@ BIF_RETTYPE erts_debug_set_internal_state_2(BIF_ALIST_2)
 		BIF_RET(am_false);
 	    }
 	    else {
-		MSO(rp).overhead += HEAP_SIZE(rp); /* Force GC */
+		FORCE_GC(rp);
 		if (BIF_P != rp)
 		    erts_smp_proc_unlock(rp, ERTS_PROC_LOCK_MAIN);
 		BIF_RET(am_true);
@@ -123,6 +123,18 @@ BIF_RETTYPE port_command_2(BIF_ALIST_2)
     BIF_RETTYPE res;
     Port *p;
 
+#ifdef ERTS_SMP
+    /* With port parallelism the command is only enqueued on the port */
+    if (erts_port_parallelism
+	&& is_internal_port(BIF_ARG_1)
+	&& !IS_TRACED_FL(BIF_P, F_TRACE_SCHED_PROCS)
+	&& !erts_system_profile_flags.runnable_procs
+	&& !erts_system_profile_flags.runnable_ports
+	&& erts_port_enqueue_command(BIF_P->id, BIF_ARG_1, BIF_ARG_2) == 0) {
+	BIF_RET(am_true);
+    }
+#endif
+
     /* Trace sched out before lock check wait */    
     if (IS_TRACED_FL(BIF_P, F_TRACE_SCHED_PROCS)) {
 	trace_virtual_sched(BIF_P, am_out);
@@ -273,8 +285,6 @@ BIF_RETTYPE port_call_3(BIF_ALIST_3)
     if (!term_to_Uint(BIF_ARG_2, &op)) {
 	goto error;
     }
-    p->caller = BIF_P->id;
-    
     /* Lock taken, virtual schedule of port */
     if (IS_TRACED_FL(p, F_TRACE_SCHED_PORTS)) {
     	trace_sched_ports_where(p, am_in, am_call);
@@ -296,6 +306,12 @@ BIF_RETTYPE port_call_3(BIF_ALIST_3)
 		 __FILE__, __LINE__, endp - (bytes + size));
     }
     erts_smp_proc_unlock(BIF_P, ERTS_PROC_LOCK_MAIN);
+    ERTS_SMP_PORT_FLUSH_COMMANDS(p);
+    if (ERTS_SMP_PORT_FLUSH_KILLED(p)) {
+	erts_smp_proc_lock(BIF_P, ERTS_PROC_LOCK_MAIN);
+	goto error;
+    }
+    p->caller = BIF_P->id;
     prc  = (char *) port_resp;
     fpe_was_unmasked = erts_block_fpe();
     ret = drv->call((ErlDrvData)p->drv_data, 
@@ -453,6 +469,7 @@ BIF_RETTYPE port_close_1(BIF_ALIST_1)
 	erts_smp_proc_lock(BIF_P, ERTS_PROC_LOCK_MAIN);
 	BIF_ERROR(BIF_P, BADARG);
     }
+    ERTS_SMP_PORT_FLUSH_COMMANDS(p);
     erts_do_exit_port(p, p->connected, am_normal);
     /* if !ERTS_SMP: since we terminate port with reason normal 
        we SHOULD never get an exit signal ourselves
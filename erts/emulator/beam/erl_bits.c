@@ -1344,7 +1344,7 @@ erts_bs_append(Process* c_p, Eterm* reg, Uint live, Eterm build_size_term,
 	pb->val = bptr;
 	pb->bytes = (byte*) bptr->orig_bytes;
 	pb->flags = PB_IS_WRITABLE | PB_ACTIVE_WRITER;
-	MSO(c_p).overhead += pb->size / BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+	MSO(c_p).overhead += pb->size / sizeof(Eterm);
 
 	/*
 	 * Now allocate the sub binary and set its size to include the
@@ -1515,7 +1515,7 @@ erts_bs_init_writable(Process* p, Eterm sz)
     pb->val = bptr;
     pb->bytes = (byte*) bptr->orig_bytes;
     pb->flags = PB_IS_WRITABLE | PB_ACTIVE_WRITER;
-    MSO(p).overhead += pb->size / BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+    MSO(p).overhead += pb->size / sizeof(Eterm);
     
     /*
      * Now allocate the sub binary.
@@ -386,6 +386,9 @@ EXTERN int  get_port_flags(ErlDrvPort port);
 EXTERN ErlDrvBinary* driver_alloc_binary(int size);
 EXTERN ErlDrvBinary* driver_realloc_binary(ErlDrvBinary *bin, int size);
 EXTERN void driver_free_binary(ErlDrvBinary *bin);
+EXTERN ErlDrvBinary* driver_alloc_extern_binary(char *data, ErlDrvUInt size,
+						void (*release)(char *,
+								ErlDrvUInt));
 
 /* Referenc count on driver binaries */
 EXTERN long driver_binary_get_refc(ErlDrvBinary *dbp);
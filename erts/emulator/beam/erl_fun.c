@@ -301,6 +301,7 @@ fun_alloc(ErlFunEntry* template)
     obj->old_index = template->old_index;
     obj->module = template->module;
     erts_refc_init(&obj->refc, -1);
+    erts_smp_atomic_init(&obj->heap_hint, 0);
     obj->address = unloaded_fun;
 #ifdef HIPE
     obj->native_address = NULL;
@@ -43,6 +43,8 @@ typedef struct erl_fun_entry {
     Eterm module;		/* Tagged atom for module. */
     erts_refc_t refc;		/* Reference count: One for code + one for each
 				   fun object in each process. */
+    erts_smp_atomic_t heap_hint; /* Predicted heap size (in words) of
+				   processes spawned to run this fun. */
 } ErlFunEntry;
 
 /*
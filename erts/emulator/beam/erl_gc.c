@@ -40,6 +40,11 @@
 #define ERTS_INACT_WR_PB_LEAVE_LIMIT 10
 #define ERTS_INACT_WR_PB_LEAVE_PERCENTAGE 10
 
+#if defined(USE_THREADS) && defined(ETHR_HAVE_NATIVE_ATOMICS) \
+    && ERTS_SIZEOF_ETERM == SIZEOF_LONG
+#  define ERTS_PAR_GC
+#endif
+
 /*
  * Returns number of elements in an array.
  */
@@ -102,12 +107,10 @@ static int minor_collection(Process* p, int need, Eterm* objv, int nobj, Uint *r
 static void do_minor(Process *p, int new_sz, Eterm* objv, int nobj);
 static Eterm* sweep_rootset(Rootset *rootset, Eterm* htop, char* src, Uint src_size);
 static Eterm* sweep_one_area(Eterm* n_hp, Eterm* n_htop, char* src, Uint src_size);
-static Eterm* sweep_one_heap(Eterm* heap_ptr, Eterm* heap_end, Eterm* htop,
-			     char* src, Uint src_size);
 static Eterm* collect_heap_frags(Process* p, Eterm* heap,
 				 Eterm* htop, Eterm* objv, int nobj);
-static Uint adjust_after_fullsweep(Process *p, int size_before,
-				   int need, Eterm *objv, int nobj);
+static Uint adjust_after_fullsweep(Process *p, int size_before, int need,
+				   Uint holes, Eterm *objv, int nobj);
 static void shrink_new_heap(Process *p, Uint new_sz, Eterm *objv, int nobj);
 static void grow_new_heap(Process *p, Uint new_sz, Eterm* objv, int nobj);
 static void sweep_proc_bins(Process *p, int fullsweep);
@@ -119,6 +122,15 @@ static void offset_rootset(Process *p, Sint offs, char* area, Uint area_size,
 			   Eterm* objv, int nobj);
 static void offset_off_heap(Process* p, Sint offs, char* area, Uint area_size);
 static void offset_mqueue(Process *p, Sint offs, char* area, Uint area_size);
+#ifdef ERTS_PAR_GC
+static void init_par_gc(void);
+static int par_gc_begin(Uint sz);
+static void par_gc_end(void);
+static Uint par_gc_slack(Uint sz);
+static Eterm* par_gc_sweep(Eterm* n_heap, Eterm* n_htop, Eterm* limit,
+			   Roots* roots, int n, char* src, Uint src_size,
+			   char* oh, Uint oh_size, Uint* holes);
+#endif
 
 #ifdef HARDDEBUG
 static void disallow_heap_frag_ref_in_heap(Process* p);
@@ -136,6 +148,7 @@ static Sint heap_sizes[MAX_HEAP_SIZES];	/* Suitable heap sizes. */
 static int num_heap_sizes;	/* Number of heap sizes. */
 
 Uint erts_test_long_gc_sleep; /* Only used for testing... */
+int erts_no_gc_threads;		/* Helper threads for parallel fullsweeps */
 
 /*
  * Initialize GC global data.
@@ -174,6 +187,12 @@ erts_init_gc(void)
 	}
     }
     num_heap_sizes = i;
+
+#ifdef ERTS_PAR_GC
+    init_par_gc();
+#else
+    erts_no_gc_threads = 0;
+#endif
 }
 
 /*
@@ -223,6 +242,26 @@ next_heap_size(Process* p, Uint size, Uint offset)
     return size < p->min_heap_size ? p->min_heap_size : size;
 }
 
+/*
+ * Return the next virtual binary heap size given the amount of binary
+ * data (vheap) that survived a GC. The size grows quickly when live
+ * data exceeds it, and shrinks slowly (but never below the minimum of
+ * the process) when most of it turns out to be garbage.
+ */
+static ERTS_INLINE Uint
+next_vheap_size(Process* p, Uint vheap, Uint vheap_sz)
+{
+    if (vheap > vheap_sz) {
+	vheap_sz = 2*vheap;
+	if (vheap_sz < vheap)
+	    vheap_sz = ~((Uint) 0);
+    }
+    else if (vheap < vheap_sz/2) {
+	vheap_sz = vheap_sz*3/4;
+    }
+    return vheap_sz < MIN_VHEAP_SIZE(p) ? MIN_VHEAP_SIZE(p) : vheap_sz;
+}
+
 Eterm
 erts_heap_sizes(Process* p)
 {
@@ -364,7 +403,8 @@ erts_garbage_collect(Process* p, int need, Eterm* objv, int nobj)
     ERTS_CHK_OFFHEAP(p);
 
     ErtsGcQuickSanityCheck(p);
-    if (GEN_GCS(p) >= MAX_GEN_GCS(p)) {
+    if (GEN_GCS(p) >= MAX_GEN_GCS(p)
+	|| BIN_OLD_VHEAP(p) > BIN_OLD_VHEAP_SZ(p)) {
         FLAGS(p) |= F_NEED_FULLSWEEP;
     }
 
@@ -421,8 +461,6 @@ erts_garbage_collect(Process* p, int need, Eterm* objv, int nobj)
     reclaimed += reclaimed_now;
     erts_smp_spin_unlock(&info_lck);
 
-    MSO(p).overhead = 0;
-
 #ifdef CHECK_FOR_HOLES
     /*
      * We intentionally do not rescan the areas copied by the GC.
@@ -502,9 +540,7 @@ erts_garbage_collect_hibernate(Process* p)
 
     cleanup_rootset(&rootset);
 
-    if (MSO(p).mso) {
-        sweep_proc_bins(p, 1);
-    }
+    sweep_proc_bins(p, 1);
     if (MSO(p).funs) {
         sweep_proc_funs(p, 1);
     }
@@ -536,7 +572,6 @@ erts_garbage_collect_hibernate(Process* p)
     if (heap_size == 0) {
 	heap_size = 1; /* We want a heap... */
     }
-    MSO(p).overhead = 0;
 
     /*
      * Move the heap to its final destination.
@@ -590,131 +625,129 @@ erts_garbage_collect_hibernate(Process* p)
 }
 
 
-void
-erts_garbage_collect_literals(Process* p, Eterm* literals, Uint lit_size)
+/*
+ * Check for references into area from the terms in [start, end).
+ */
+static int
+any_ptr_refs(Eterm* start, Eterm* end, char* area, Uint area_size)
 {
-    Uint byte_lit_size = sizeof(Eterm)*lit_size;
-    Uint old_heap_size;
-    Eterm* temp_lit;
-    Sint offs;
-    Rootset rootset;            /* Rootset for GC (stack, dictionary, etc). */
-    Roots* roots;
-    char* area;
-    Uint area_size;
-    Eterm* old_htop;
-    int n;
+    Eterm* p;
+    Eterm val;
 
-    /*
-     * Set GC state.
-     */
-    erts_smp_proc_lock(p, ERTS_PROC_LOCK_STATUS);
-    p->gcstatus = p->status;
-    p->status = P_GARBING;
-    erts_smp_proc_unlock(p, ERTS_PROC_LOCK_STATUS);
-    erts_smp_locked_activity_begin(ERTS_ACTIVITY_GC);
+    for (p = start; p < end; p++) {
+	val = *p;
+	switch (primary_tag(val)) {
+	case TAG_PRIMARY_BOXED:
+	case TAG_PRIMARY_LIST:
+	    if (in_area(ptr_val(val), area, area_size)) {
+		return 1;
+	    }
+	    break;
+	}
+    }
+    return 0;
+}
 
-    /*
-     * We assume that the caller has already done a major collection
-     * (which has discarded the old heap), so that we don't have to cope
-     * with pointer to literals on the old heap. We will now allocate
-     * an old heap to contain the literals.
-     */
-    
-    ASSERT(p->old_heap == 0);	/* Must NOT have an old heap yet. */
-    old_heap_size = erts_next_heap_size(lit_size, 0);
-    p->old_heap = p->old_htop = (Eterm*) ERTS_HEAP_ALLOC(ERTS_ALC_T_OLD_HEAP,
-							 sizeof(Eterm)*old_heap_size);
-    p->old_hend = p->old_heap + old_heap_size;
+/*
+ * Same as above, but [start, end) is a heap, so the contents of things
+ * (such as binaries) must be skipped.
+ */
+static int
+any_heap_refs(Eterm* start, Eterm* end, char* area, Uint area_size)
+{
+    Eterm* p;
+    Eterm val;
 
-    /*
-     * We soon want to garbage collect the literals. But since a GC is
-     * destructive (MOVED markers are written), we must copy the literals
-     * to a temporary area and change all references to literals.
-     */
-    temp_lit = (Eterm *) erts_alloc(ERTS_ALC_T_TMP, byte_lit_size);
-    sys_memcpy(temp_lit, literals, byte_lit_size);
-    offs = temp_lit - literals;
-    offset_heap(temp_lit, lit_size, offs, (char *) literals, byte_lit_size);
-    offset_heap(p->heap, p->htop - p->heap, offs, (char *) literals, byte_lit_size);
-    offset_rootset(p, offs, (char *) literals, byte_lit_size, p->arg_reg, p->arity);
+    for (p = start; p < end; p++) {
+	val = *p;
+	switch (primary_tag(val)) {
+	case TAG_PRIMARY_BOXED:
+	case TAG_PRIMARY_LIST:
+	    if (in_area(ptr_val(val), area, area_size)) {
+		return 1;
+	    }
+	    break;
+	case TAG_PRIMARY_HEADER:
+	    if (!header_is_transparent(val)) {
+		p += thing_arityval(val);
+	    }
+	    break;
+	}
+    }
+    return 0;
+}
 
-    /*
-     * Now the literals are placed in memory that is safe to write into,
-     * so now we GC the literals into the old heap. First we go through the
-     * rootset.
-     */
+static int
+refers_to_area(Process* p, Eterm* objv, int nobj, char* area, Uint area_size)
+{
+    Rootset rootset;
+    Roots* roots;
+    ErlHeapFragment* bp;
+    int found = 0;
+    int n;
 
-    area = (char *) temp_lit;
-    area_size = byte_lit_size;
-    n = setup_rootset(p, p->arg_reg, p->arity, &rootset);
+    n = setup_rootset(p, objv, nobj, &rootset);
     roots = rootset.roots;
-    old_htop = p->old_htop;
     while (n--) {
-        Eterm* g_ptr = roots->v;
-        Uint g_sz = roots->sz;
-	Eterm* ptr;
-	Eterm val;
-
-	roots++;
-
-        while (g_sz--) {
-            Eterm gval = *g_ptr;
-
-            switch (primary_tag(gval)) {
-	    case TAG_PRIMARY_BOXED:
-		ptr = boxed_val(gval);
-		val = *ptr;
-                if (IS_MOVED(val)) {
-		    ASSERT(is_boxed(val));
-                    *g_ptr++ = val;
-		} else if (in_area(ptr, area, area_size)) {
-                    MOVE_BOXED(ptr,val,old_htop,g_ptr++);
-		} else {
-		    g_ptr++;
-		}
-		break;
-	    case TAG_PRIMARY_LIST:
-                ptr = list_val(gval);
-                val = *ptr;
-                if (is_non_value(val)) { /* Moved */
-                    *g_ptr++ = ptr[1];
-		} else if (in_area(ptr, area, area_size)) {
-                    MOVE_CONS(ptr,val,old_htop,g_ptr++);
-                } else {
-		    g_ptr++;
-		}
-		break;
-	    default:
-                g_ptr++;
-		break;
-	    }
+	if (any_ptr_refs(roots->v, roots->v + roots->sz, area, area_size)) {
+	    found = 1;
+	    break;
 	}
+	roots++;
     }
-    ASSERT(p->old_htop <= old_htop && old_htop <= p->old_hend);
     cleanup_rootset(&rootset);
+    if (found) {
+	return 1;
+    }
+    if (any_heap_refs(HEAP_START(p), HEAP_TOP(p), area, area_size)) {
+	return 1;
+    }
+    if (OLD_HEAP(p) != NULL
+	&& any_heap_refs(OLD_HEAP(p), OLD_HTOP(p), area, area_size)) {
+	return 1;
+    }
+    for (bp = MBUF(p); bp != NULL; bp = bp->next) {
+	if (any_heap_refs(bp->mem, bp->mem + bp->size, area, area_size)) {
+	    return 1;
+	}
+    }
+    return 0;
+}
 
-    /*
-     * Now all references in the rootset to the literals have been updated.
-     * Now we'll have to go through all heaps updating all other references.
-     */
+/*
+ * Check whether anything in the process (the rootset, the heaps and
+ * the heap fragments) refers to the given area, such as the literals
+ * of a module being purged. The process must not be running.
+ */
+int
+erts_proc_refers_to_area(Process* p, char* area, Uint area_size)
+{
+    return refers_to_area(p, p->arg_reg, p->arity, area, area_size);
+}
 
-    old_htop = sweep_one_heap(p->heap, p->htop, old_htop, area, area_size);
-    old_htop = sweep_one_area(p->old_heap, old_htop, area, area_size);
-    ASSERT(p->old_htop <= old_htop && old_htop <= p->old_hend);
-    p->old_htop = old_htop;
+/*
+ * Release the literal areas of purged code that the process no longer
+ * refers to. Called after a fullsweep, when no garbage remains that could
+ * still point into them.
+ */
+static void
+drop_literal_refs(Process* p, Eterm* objv, int nobj)
+{
+    ErtsLiteralRef** prevp = &p->literal_refs;
+    ErtsLiteralRef* ref;
 
-    /*
-     * We no longer need this temporary area.
-     */
-    erts_free(ERTS_ALC_T_TMP, (void *) temp_lit);
+    while ((ref = *prevp) != NULL) {
+	ErtsLiteralArea* lap = ref->area;
 
-    /*
-     * Restore status.
-     */
-    erts_smp_proc_lock(p, ERTS_PROC_LOCK_STATUS);
-    p->status = p->gcstatus;
-    erts_smp_proc_unlock(p, ERTS_PROC_LOCK_STATUS);
-    erts_smp_locked_activity_end(ERTS_ACTIVITY_GC);
+	if (refers_to_area(p, objv, nobj, (char *) lap->start,
+			   lap->size * sizeof(Eterm))) {
+	    prevp = &ref->next;
+	} else {
+	    *prevp = ref->next;
+	    erts_release_literal_area(lap);
+	    erts_free(ERTS_ALC_T_LITERAL_REF, (void *) ref);
+	}
+    }
 }
 
 static int
@@ -1037,9 +1070,7 @@ do_minor(Process *p, int new_sz, Eterm* objv, int nobj)
     OLD_HTOP(p) = old_htop;
     HIGH_WATER(p) = (HEAP_START(p) != HIGH_WATER(p)) ? n_heap : n_htop;
 
-    if (MSO(p).mso) {
-        sweep_proc_bins(p, 0);
-    }
+    sweep_proc_bins(p, 0);
 
     if (MSO(p).funs) {
         sweep_proc_funs(p, 0);
@@ -1094,8 +1125,12 @@ major_collection(Process* p, int need, Eterm* objv, int nobj, Uint *recl)
     Uint oh_size = (char *) OLD_HTOP(p) - oh;
     int n;
     Uint new_sz;
+    Uint holes = 0;
     Uint fragments = MBUF_SIZE(p) + combined_message_size(p);
     ErlMessage *msgp;
+#ifdef ERTS_PAR_GC
+    int par_gc;
+#endif
 
     size_before = fragments + (HEAP_TOP(p) - HEAP_START(p));
 
@@ -1122,6 +1157,17 @@ major_collection(Process* p, int need, Eterm* objv, int nobj, Uint *recl)
     if (new_sz == HEAP_SIZE(p) && FLAGS(p) & F_HEAP_GROW) {
         new_sz = next_heap_size(p, HEAP_SIZE(p), 1);
     }
+
+#ifdef ERTS_PAR_GC
+    /*
+     * Large heaps are collected in parallel if helper threads are
+     * available. Parallel copying leaves some unused space behind.
+     */
+    par_gc = par_gc_begin(size_before + oh_size/sizeof(Eterm));
+    if (par_gc) {
+	new_sz = next_heap_size(p, new_sz + par_gc_slack(new_sz), 0);
+    }
+#endif
     FLAGS(p) &= ~(F_HEAP_GROW|F_NEED_FULLSWEEP);
     n_htop = n_heap = (Eterm *) ERTS_HEAP_ALLOC(ERTS_ALC_T_HEAP,
 						sizeof(Eterm)*new_sz);
@@ -1142,6 +1188,14 @@ major_collection(Process* p, int need, Eterm* objv, int nobj, Uint *recl)
     n = setup_rootset(p, objv, nobj, &rootset);
     n_htop = fullsweep_nstack(p, n_htop);
     roots = rootset.roots;
+#ifdef ERTS_PAR_GC
+    if (par_gc) {
+	n_htop = par_gc_sweep(n_heap, n_htop,
+			      n_heap + new_sz - STACK_SZ_ON_HEAP(p),
+			      roots, n, src, src_size, oh, oh_size, &holes);
+	n = 0;
+    }
+#endif
     while (n--) {
 	Eterm* g_ptr = roots->v;
 	Eterm g_sz = roots->sz;
@@ -1198,6 +1252,11 @@ major_collection(Process* p, int need, Eterm* objv, int nobj, Uint *recl)
      * until all is copied.
      */
 
+#ifdef ERTS_PAR_GC
+    if (par_gc) {
+	par_gc_end();
+    } else
+#endif
     if (oh_size == 0) {
 	n_htop = sweep_one_area(n_heap, n_htop, src, src_size);
     } else {
@@ -1267,9 +1326,7 @@ major_collection(Process* p, int need, Eterm* objv, int nobj, Uint *recl)
 	}
     }
 
-    if (MSO(p).mso) {
-	sweep_proc_bins(p, 1);
-    }
+    sweep_proc_bins(p, 1);
     if (MSO(p).funs) {
 	sweep_proc_funs(p, 1);
     }
@@ -1311,25 +1368,580 @@ major_collection(Process* p, int need, Eterm* objv, int nobj, Uint *recl)
 	}
     }
 
-    *recl += adjust_after_fullsweep(p, size_before, need, objv, nobj);
+    *recl += adjust_after_fullsweep(p, size_before, need, holes, objv, nobj);
 
 #ifdef HARDDEBUG
     disallow_heap_frag_ref_in_heap(p);
 #endif
     remove_message_buffers(p);
 
+    if (p->literal_refs != NULL) {
+	drop_literal_refs(p, objv, nobj);
+    }
+
     ErtsGcQuickSanityCheck(p);
     return 1;			/* We are done. */
 }
 
+#ifdef ERTS_PAR_GC
+
+/*
+ * Parallel fullsweep.
+ *
+ * A major collection of a large heap can be shared with a pool of
+ * helper threads (see the +hpgc flag). The scheduler doing the
+ * collection copies the rootset, and then all threads evacuate
+ * objects reachable from the to-space until no unscanned objects
+ * remain.
+ *
+ * Each thread copies objects into a private block of the to-space,
+ * grabbed from the new heap by atomically bumping a shared top. Blocks
+ * that fill up while they still contain unscanned objects are put in
+ * a shared work queue, where idle threads pick them up. The unused
+ * tail of a block is filled with a dummy bignum header, like a heap
+ * hole, so that the new heap can still be walked.
+ *
+ * An object is claimed by atomically replacing its header (or the car
+ * of a cons cell) with ERTS_PAR_GC_BUSY. The thread that succeeds
+ * copies the object and then stores the forwarding pointer, exactly
+ * as the sequential collector does. Threads that find an object busy
+ * wait for the forwarding pointer to appear.
+ */
+
+#define ERTS_PAR_GC_BLOCK_SZ	4096	/* Words */
+#define ERTS_PAR_GC_LARGE_SZ	(ERTS_PAR_GC_BLOCK_SZ/8)
+#define ERTS_PAR_GC_SHARE_SZ	512	/* Min words to split when idle */
+#define ERTS_PAR_GC_MIN_SZ	(1024*1024) /* Min words to collect */
+
+/* Neither a header nor a forwarding pointer; never a valid term. */
+#define ERTS_PAR_GC_BUSY	((Eterm) TAG_PRIMARY_LIST)
+
+#define ERTS_PAR_GC_WORD(P)	((erts_atomic_t *) (void *) (P))
+
+typedef struct {
+    Eterm* start;
+    Eterm* end;
+} ErtsParGcRegion;
+
+typedef struct {
+    Eterm* top;			/* Next free word in the copy block */
+    Eterm* end;			/* End of the copy block */
+    Eterm* unscanned;		/* First unscanned object in copy block */
+} ErtsParGcThr;
+
+typedef struct {
+    char* src;
+    Uint src_size;
+    char* oh;
+    Uint oh_size;
+    Eterm* limit;		/* End of the to-space */
+    erts_atomic_t top;		/* Start of the unallocated to-space */
+    int no_thr;			/* Number of participating threads */
+    erts_atomic_t active;	/* Number of threads not idle */
+    erts_atomic_t holes;	/* Words of filler left in the to-space */
+    erts_mtx_t q_mtx;
+    erts_atomic_t q_len;
+    ErtsParGcRegion* q;
+    Uint q_size;
+} ErtsParGc;
+
+static ErtsParGc par_gc;
+static ErtsParGcThr* par_gc_thr; /* Slot 0 belongs to the scheduler */
+static erts_mtx_t par_gc_mtx;	/* Held during a parallel collection */
+static erts_mtx_t par_gc_pool_mtx;
+static erts_cnd_t par_gc_pool_cnd;
+static erts_cnd_t par_gc_done_cnd;
+static Uint par_gc_generation;
+static int par_gc_done;
+
+static void
+par_gc_push(Eterm* start, Eterm* end)
+{
+    erts_mtx_lock(&par_gc.q_mtx);
+    if (erts_atomic_read(&par_gc.q_len) >= (long) par_gc.q_size) {
+	erl_exit(ERTS_ABORT_EXIT, "%s:%d: parallel gc work queue overflow\n",
+		 __FILE__, __LINE__);
+    }
+    par_gc.q[erts_atomic_read(&par_gc.q_len)].start = start;
+    par_gc.q[erts_atomic_read(&par_gc.q_len)].end = end;
+    erts_atomic_inc(&par_gc.q_len);
+    erts_mtx_unlock(&par_gc.q_mtx);
+}
+
+static int
+par_gc_pop(Eterm** start, Eterm** end)
+{
+    int res = 0;
+    long len;
+
+    if (erts_atomic_read(&par_gc.q_len) == 0)
+	return 0;
+    erts_mtx_lock(&par_gc.q_mtx);
+    len = erts_atomic_read(&par_gc.q_len);
+    if (len > 0) {
+	*start = par_gc.q[len-1].start;
+	*end = par_gc.q[len-1].end;
+	erts_atomic_dec(&par_gc.q_len);
+	res = 1;
+    }
+    erts_mtx_unlock(&par_gc.q_mtx);
+    return res;
+}
+
+static ERTS_INLINE void
+par_gc_fill(Eterm* hp, Eterm* end)
+{
+    if (hp < end) {
+	*hp = make_pos_bignum_header(end - hp - 1);
+	erts_atomic_add(&par_gc.holes, (long) (end - hp));
+    }
+}
+
+/*
+ * Back off while waiting for another thread. Spin with a growing
+ * number of pauses at first, then sleep so that a helper thread
+ * does not take a whole core from the threads doing the work.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  define ERTS_PAR_GC_PAUSE() __asm__ __volatile__("rep;nop" : : : "memory")
+#else
+#  define ERTS_PAR_GC_PAUSE()
+#endif
+
+#define ERTS_PAR_GC_SPIN_SHIFT	10	/* Max 1024 pauses per round */
+#define ERTS_PAR_GC_SPIN_ROUNDS	20	/* Rounds before sleeping */
+
+static ERTS_INLINE void
+par_gc_backoff(int* rounds)
+{
+    if (*rounds < ERTS_PAR_GC_SPIN_ROUNDS) {
+	int i = 1 << (*rounds < ERTS_PAR_GC_SPIN_SHIFT
+		      ? *rounds : ERTS_PAR_GC_SPIN_SHIFT);
+	while (i--) {
+	    ERTS_PAR_GC_PAUSE();
+	}
+	(*rounds)++;
+    } else {
+	erts_milli_sleep(1);
+    }
+}
+
+static Eterm*
+par_gc_get_space(Uint sz)
+{
+    Eterm* top = (Eterm *) erts_atomic_addtest(&par_gc.top,
+					       (long) (sz*sizeof(Eterm)));
+    if (top > par_gc.limit) {
+	erl_exit(ERTS_ABORT_EXIT, "%s:%d: parallel gc out of to-space\n",
+		 __FILE__, __LINE__);
+    }
+    return top - sz;
+}
+
+/*
+ * Allocate space for an object of sz words. Large objects get a block
+ * of their own, which the caller must push once the object is copied.
+ */
+static ERTS_INLINE Eterm*
+par_gc_alloc(ErtsParGcThr* t, Uint sz)
+{
+    Eterm* hp;
+
+    if (sz > ERTS_PAR_GC_LARGE_SZ) {
+	return par_gc_get_space(sz);
+    }
+    if (t->top + sz > t->end) {
+	if (t->unscanned < t->top) {
+	    par_gc_push(t->unscanned, t->top);
+	}
+	par_gc_fill(t->top, t->end);
+	t->top = t->unscanned = par_gc_get_space(ERTS_PAR_GC_BLOCK_SZ);
+	t->end = t->top + ERTS_PAR_GC_BLOCK_SZ;
+    }
+    hp = t->top;
+    t->top += sz;
+    return hp;
+}
+
+static void
+par_gc_move_boxed(ErtsParGcThr* t, Eterm* ptr, Eterm* orig)
+{
+    Eterm hdr;
+    Eterm gval;
+    Eterm* hp;
+    Uint sz;
+    int rounds = 0;
+
+    for (;;) {
+	hdr = (Eterm) erts_atomic_read(ERTS_PAR_GC_WORD(ptr));
+	if (hdr == ERTS_PAR_GC_BUSY) {
+	    par_gc_backoff(&rounds);
+	    continue;
+	}
+	if (IS_MOVED(hdr)) {
+	    *orig = hdr;
+	    return;
+	}
+	if ((Eterm) erts_atomic_cmpxchg(ERTS_PAR_GC_WORD(ptr),
+					(long) ERTS_PAR_GC_BUSY,
+					(long) hdr) == hdr) {
+	    break;
+	}
+    }
+
+    sz = header_arity(hdr);
+    switch (hdr & _HEADER_SUBTAG_MASK) {
+    case SUB_BINARY_SUBTAG: sz++; break;
+    case FUN_SUBTAG: sz += ((ErlFunThing*)ptr)->num_free+1; break;
+    }
+    hp = par_gc_alloc(t, sz+1);
+    hp[0] = hdr;
+    sys_memcpy((void *) (hp+1), (void *) (ptr+1), sz*sizeof(Eterm));
+    gval = make_boxed(hp);
+    *orig = gval;
+    erts_atomic_xchg(ERTS_PAR_GC_WORD(ptr), (long) gval);
+    if (sz+1 > ERTS_PAR_GC_LARGE_SZ) {
+	par_gc_push(hp, hp+sz+1);
+    }
+}
+
+static void
+par_gc_move_cons(ErtsParGcThr* t, Eterm* ptr, Eterm* orig)
+{
+    Eterm car;
+    Eterm gval;
+    Eterm* hp;
+    int rounds = 0;
+
+    for (;;) {
+	car = (Eterm) erts_atomic_read(ERTS_PAR_GC_WORD(ptr));
+	if (car == ERTS_PAR_GC_BUSY) {
+	    par_gc_backoff(&rounds);
+	    continue;
+	}
+	if (is_non_value(car)) {
+	    *orig = (Eterm) erts_atomic_read(ERTS_PAR_GC_WORD(ptr+1));
+	    return;
+	}
+	if ((Eterm) erts_atomic_cmpxchg(ERTS_PAR_GC_WORD(ptr),
+					(long) ERTS_PAR_GC_BUSY,
+					(long) car) == car) {
+	    break;
+	}
+    }
+
+    hp = par_gc_alloc(t, 2);
+    hp[0] = car;
+    hp[1] = ptr[1];
+    gval = make_list(hp);
+    *orig = gval;
+    ptr[1] = gval;
+    erts_atomic_xchg(ERTS_PAR_GC_WORD(ptr), (long) THE_NON_VALUE);
+}
+
+static ERTS_INLINE void
+par_gc_move(ErtsParGcThr* t, Eterm* g_ptr)
+{
+    Eterm gval = *g_ptr;
+    Eterm* ptr;
+
+    switch (primary_tag(gval)) {
+    case TAG_PRIMARY_BOXED:
+	ptr = boxed_val(gval);
+	if (in_area(ptr, par_gc.src, par_gc.src_size) ||
+	    in_area(ptr, par_gc.oh, par_gc.oh_size)) {
+	    par_gc_move_boxed(t, ptr, g_ptr);
+	}
+	break;
+    case TAG_PRIMARY_LIST:
+	ptr = list_val(gval);
+	if (in_area(ptr, par_gc.src, par_gc.src_size) ||
+	    in_area(ptr, par_gc.oh, par_gc.oh_size)) {
+	    par_gc_move_cons(t, ptr, g_ptr);
+	}
+	break;
+    }
+}
+
+/*
+ * Return a point near the middle of the region where scanning can
+ * start, i.e. one that is not inside the body of a thing.
+ */
+static Eterm*
+par_gc_split(Eterm* hp, Eterm* end)
+{
+    Eterm* mid = hp + (end - hp) / 2;
+
+    while (hp < mid) {
+	Eterm val = *hp;
+	if (is_header(val) && header_is_thing(val)) {
+	    hp += thing_arityval(val) + 1;
+	} else {
+	    hp++;
+	}
+    }
+    return hp;
+}
+
+static void
+par_gc_scan(ErtsParGcThr* t, Eterm* hp, Eterm* end)
+{
+    while (hp < end) {
+	Eterm val = *hp;
+
+	switch (primary_tag(val)) {
+	case TAG_PRIMARY_BOXED:
+	case TAG_PRIMARY_LIST:
+	    par_gc_move(t, hp);
+	    hp++;
+	    break;
+	case TAG_PRIMARY_HEADER:
+	    if (!header_is_thing(val)) {
+		hp++;
+	    } else {
+		if (header_is_bin_matchstate(val)) {
+		    ErlBinMatchState *ms = (ErlBinMatchState*) hp;
+		    ErlBinMatchBuffer *mb = &(ms->mb);
+		    Eterm* orig = boxed_val(mb->orig);
+
+		    if (in_area(orig, par_gc.src, par_gc.src_size) ||
+			in_area(orig, par_gc.oh, par_gc.oh_size)) {
+			par_gc_move_boxed(t, orig, &(mb->orig));
+			mb->base = binary_bytes(mb->orig);
+		    }
+		}
+		hp += thing_arityval(val) + 1;
+	    }
+	    break;
+	default:
+	    hp++;
+	    break;
+	}
+    }
+}
+
+/*
+ * Wait for work to appear in the queue. Returns 0 when all threads
+ * are idle and no work remains.
+ */
+static int
+par_gc_idle(Eterm** start, Eterm** end)
+{
+    int rounds = 0;
+
+    erts_atomic_dec(&par_gc.active);
+    for (;;) {
+	if (erts_atomic_read(&par_gc.q_len) > 0) {
+	    erts_atomic_inc(&par_gc.active);
+	    if (par_gc_pop(start, end)) {
+		return 1;
+	    }
+	    erts_atomic_dec(&par_gc.active);
+	} else if (erts_atomic_read(&par_gc.active) == 0
+		   && erts_atomic_read(&par_gc.q_len) == 0) {
+	    return 0;
+	}
+	par_gc_backoff(&rounds);
+    }
+}
+
+static void
+par_gc_work(ErtsParGcThr* t)
+{
+    Eterm* start;
+    Eterm* end;
+
+    for (;;) {
+	if (t->unscanned < t->top) {
+	    start = t->unscanned;
+	    end = t->unscanned = t->top;
+	} else if (!par_gc_pop(&start, &end) && !par_gc_idle(&start, &end)) {
+	    break;
+	}
+
+	/*
+	 * Give half of a large region to an idle thread.
+	 */
+	if (end - start >= ERTS_PAR_GC_SHARE_SZ
+	    && erts_atomic_read(&par_gc.active) < par_gc.no_thr
+	    && erts_atomic_read(&par_gc.q_len) == 0) {
+	    Eterm* mid = par_gc_split(start, end);
+	    if (mid < end) {
+		par_gc_push(mid, end);
+		end = mid;
+	    }
+	}
+
+	par_gc_scan(t, start, end);
+    }
+    par_gc_fill(t->top, t->end);
+}
+
+static void *
+par_gc_thread_func(void *vix)
+{
+    int ix = (int) (long) vix;
+    Uint generation = 0;
+
+#ifdef ERTS_ENABLE_LOCK_CHECK
+    {
+	char buf[27];
+	erts_snprintf(&buf[0], 27, "gc %d", ix);
+	erts_lc_set_thread_name(&buf[0]);
+    }
+#endif
+
+    erts_mtx_lock(&par_gc_pool_mtx);
+    for (;;) {
+	while (generation == par_gc_generation) {
+	    erts_cnd_wait(&par_gc_pool_cnd, &par_gc_pool_mtx);
+	}
+	generation = par_gc_generation;
+	erts_mtx_unlock(&par_gc_pool_mtx);
+
+	par_gc_work(&par_gc_thr[ix]);
+
+	erts_mtx_lock(&par_gc_pool_mtx);
+	if (++par_gc_done == erts_no_gc_threads) {
+	    erts_cnd_signal(&par_gc_done_cnd);
+	}
+    }
+    return NULL;
+}
+
+static void
+init_par_gc(void)
+{
+    erts_thr_opts_t thr_opts = ERTS_THR_OPTS_DEFAULT_INITER;
+    erts_tid_t tid;
+    int i;
+
+    if (erts_no_gc_threads <= 0) {
+	erts_no_gc_threads = 0;
+	return;
+    }
+    erts_mtx_init(&par_gc_mtx, "par_gc");
+    erts_mtx_init(&par_gc_pool_mtx, "par_gc_pool");
+    erts_mtx_init(&par_gc.q_mtx, "par_gc_queue");
+    erts_cnd_init(&par_gc_pool_cnd);
+    erts_cnd_init(&par_gc_done_cnd);
+    par_gc_generation = 0;
+    par_gc_done = 0;
+    par_gc.no_thr = erts_no_gc_threads + 1;
+    par_gc_thr = erts_alloc(ERTS_ALC_T_GC_THR,
+			    par_gc.no_thr * sizeof(ErtsParGcThr));
+
+    thr_opts.detached = 1;
+    for (i = 1; i <= erts_no_gc_threads; i++) {
+	erts_thr_create(&tid, par_gc_thread_func, (void *) (long) i, &thr_opts);
+    }
+}
+
+/*
+ * Decide whether a fullsweep of sz words should be done in parallel.
+ * If so, the caller must call par_gc_sweep() and then par_gc_end().
+ */
+static int
+par_gc_begin(Uint sz)
+{
+    return (erts_no_gc_threads > 0
+	    && sz >= ERTS_PAR_GC_MIN_SZ
+	    && erts_mtx_trylock(&par_gc_mtx) == 0);
+}
+
+static void
+par_gc_end(void)
+{
+    erts_mtx_unlock(&par_gc_mtx);
+}
+
+/*
+ * Words to add to the size of the new heap to make up for the block
+ * tails left unused by a parallel fullsweep of sz words.
+ */
 static Uint
-adjust_after_fullsweep(Process *p, int size_before, int need, Eterm *objv, int nobj)
+par_gc_slack(Uint sz)
+{
+    return sz/4 + 2*(erts_no_gc_threads+1)*ERTS_PAR_GC_BLOCK_SZ;
+}
+
+/*
+ * Evacuate everything reachable from the rootset and from the data
+ * between n_heap and n_htop. Returns the new heap top, and in *holes
+ * the number of filler words below it.
+ */
+static Eterm*
+par_gc_sweep(Eterm* n_heap, Eterm* n_htop, Eterm* limit, Roots* roots, int n,
+	     char* src, Uint src_size, char* oh, Uint oh_size, Uint* holes)
+{
+    int i;
+
+    par_gc.src = src;
+    par_gc.src_size = src_size;
+    par_gc.oh = oh;
+    par_gc.oh_size = oh_size;
+    par_gc.limit = limit;
+    erts_atomic_init(&par_gc.top, (long) n_htop);
+    erts_atomic_init(&par_gc.active, (long) par_gc.no_thr);
+    erts_atomic_init(&par_gc.holes, 0);
+    erts_atomic_init(&par_gc.q_len, 0);
+    par_gc.q_size = ((limit - n_htop) / (ERTS_PAR_GC_BLOCK_SZ -
+					 ERTS_PAR_GC_LARGE_SZ)
+		     + (limit - n_htop) / ERTS_PAR_GC_LARGE_SZ
+		     + par_gc.no_thr + 2);
+    par_gc.q = erts_alloc(ERTS_ALC_T_TMP,
+			  par_gc.q_size * sizeof(ErtsParGcRegion));
+    for (i = 0; i < par_gc.no_thr; i++) {
+	par_gc_thr[i].top = par_gc_thr[i].end = par_gc_thr[i].unscanned = NULL;
+    }
+    if (n_heap < n_htop) {
+	par_gc_push(n_heap, n_htop);
+    }
+
+    erts_mtx_lock(&par_gc_pool_mtx);
+    par_gc_done = 0;
+    par_gc_generation++;
+    erts_cnd_broadcast(&par_gc_pool_cnd);
+    erts_mtx_unlock(&par_gc_pool_mtx);
+
+    while (n--) {
+	Eterm* g_ptr = roots->v;
+	Uint g_sz = roots->sz;
+
+	roots++;
+	while (g_sz--) {
+	    par_gc_move(&par_gc_thr[0], g_ptr++);
+	}
+    }
+    par_gc_work(&par_gc_thr[0]);
+
+    erts_mtx_lock(&par_gc_pool_mtx);
+    while (par_gc_done < erts_no_gc_threads) {
+	erts_cnd_wait(&par_gc_done_cnd, &par_gc_pool_mtx);
+    }
+    erts_mtx_unlock(&par_gc_pool_mtx);
+
+    erts_free(ERTS_ALC_T_TMP, (void *) par_gc.q);
+    *holes = (Uint) erts_atomic_read(&par_gc.holes);
+    return (Eterm *) erts_atomic_read(&par_gc.top);
+}
+
+#endif /* ERTS_PAR_GC */
+
+/*
+ * holes is the number of words of filler (unused block tails left by a
+ * parallel collection) below the heap top. They take up room in the
+ * heap until the next collection, but are not live data.
+ */
+static Uint
+adjust_after_fullsweep(Process *p, int size_before, int need, Uint holes,
+		       Eterm *objv, int nobj)
 {
     int wanted, sz, size_after, need_after;
     int stack_size = STACK_SZ_ON_HEAP(p);
     Uint reclaimed_now;
 
-    size_after = (HEAP_TOP(p) - HEAP_START(p));
+    size_after = (HEAP_TOP(p) - HEAP_START(p)) - holes;
     reclaimed_now = (size_before - size_after);
     
     /*
@@ -1337,9 +1949,9 @@ adjust_after_fullsweep(Process *p, int size_before, int need, Eterm *objv, int n
      */
     
     need_after = size_after + need + stack_size;
-    if (HEAP_SIZE(p) < need_after) {
+    if (HEAP_SIZE(p) < need_after + holes) {
         /* Too small - grow to match requested need */
-        sz = next_heap_size(p, need_after, 0);
+        sz = next_heap_size(p, need_after + holes, 0);
         grow_new_heap(p, sz, objv, nobj);
     } else if (3 * HEAP_SIZE(p) < 4 * need_after){
         /* Need more than 75% of current, postpone to next GC.*/
@@ -1356,7 +1968,7 @@ adjust_after_fullsweep(Process *p, int size_before, int need, Eterm *objv, int n
         } else {
             sz = next_heap_size(p, wanted, 0);
         }
-        if (sz < HEAP_SIZE(p)) {
+        if (sz < HEAP_SIZE(p) && sz >= need_after + holes) {
             shrink_new_heap(p, sz, objv, nobj);
         }
     }
@@ -1766,56 +2378,6 @@ sweep_one_area(Eterm* n_hp, Eterm* n_htop, char* src, Uint src_size)
     return n_htop;
 }
 
-static Eterm*
-sweep_one_heap(Eterm* heap_ptr, Eterm* heap_end, Eterm* htop, char* src, Uint src_size)
-{
-    while (heap_ptr < heap_end) {
-	Eterm* ptr;
-	Eterm val;
-	Eterm gval = *heap_ptr;
-
-	switch (primary_tag(gval)) {
-	case TAG_PRIMARY_BOXED: {
-	    ptr = boxed_val(gval);
-	    val = *ptr;
-	    if (IS_MOVED(val)) {
-		ASSERT(is_boxed(val));
-		*heap_ptr++ = val;
-	    } else if (in_area(ptr, src, src_size)) {
-		MOVE_BOXED(ptr,val,htop,heap_ptr++);
-	    } else {
-		heap_ptr++;
-	    }
-	    break;
-	}
-	case TAG_PRIMARY_LIST: {
-	    ptr = list_val(gval);
-	    val = *ptr;
-	    if (is_non_value(val)) {
-		*heap_ptr++ = ptr[1];
-	    } else if (in_area(ptr, src, src_size)) {
-		MOVE_CONS(ptr,val,htop,heap_ptr++);
-	    } else {
-		heap_ptr++;
-	    }
-	    break;
-	}
-	case TAG_PRIMARY_HEADER: {
-	    if (!header_is_thing(gval)) {
-		heap_ptr++;
-	    } else {
-		heap_ptr += (thing_arityval(gval)+1);
-	    }
-	    break;
-	}
-	default:
-	    heap_ptr++;
-	    break;
-	}
-    }
-    return htop;
-}
-
 /*
  * Collect heap fragments and check that they point in the correct direction.
  */
@@ -2229,6 +2791,8 @@ sweep_proc_bins(Process *p, int fullsweep)
     Binary* bptr;
     char* oh = NULL;
     Uint oh_size = 0;
+    Uint bin_vheap = 0;
+    Uint bin_old_vheap = 0;
 
     if (fullsweep == 0) {
 	oh = (char *) OLD_HEAP(p);
@@ -2250,16 +2814,20 @@ sweep_proc_bins(Process *p, int fullsweep)
         Eterm* ppt = (Eterm *) ptr;
 
         if (IS_MOVED(*ppt)) {        /* Object is alive */
+	    int new_heap;
             ptr = (ProcBin*) binary_val(*ppt);		   
-	    link_live_proc_bin(&shrink,
-			       &prev,
-			       &ptr,
-			       !in_area(ptr, oh, oh_size)); 
+	    new_heap = !in_area(ptr, oh, oh_size);
+	    if (new_heap)
+		bin_vheap += ptr->size / sizeof(Eterm);
+	    else
+		bin_old_vheap += ptr->size / sizeof(Eterm);
+	    link_live_proc_bin(&shrink, &prev, &ptr, new_heap);
         } else if (in_area(ppt, oh, oh_size)) {
             /*
              * Object resides on old heap, and we just did a
              * generational collection - keep object in list.
              */
+	    bin_old_vheap += ptr->size / sizeof(Eterm);
 	    link_live_proc_bin(&shrink, &prev, &ptr, 0); 
         } else {                /* Object has not been moved - deref it */
             *prev = ptr->next;
@@ -2326,6 +2894,20 @@ sweep_proc_bins(Process *p, int fullsweep)
     }
 
     *prev = shrink.old_candidates;
+
+    /*
+     * Adjust the virtual binary heaps to the amount of binary data
+     * that survived. The young generation is considered full again
+     * when the amount of binary data referred from it has grown past
+     * its virtual heap size.
+     */
+    if (fullsweep) {
+	BIN_OLD_VHEAP_SZ(p) = next_vheap_size(p, bin_vheap,
+					      BIN_OLD_VHEAP_SZ(p));
+    }
+    BIN_OLD_VHEAP(p) = bin_old_vheap;
+    BIN_VHEAP_SZ(p) = next_vheap_size(p, bin_vheap, BIN_VHEAP_SZ(p));
+    MSO(p).overhead = bin_vheap;
 }
 
 /*
@@ -87,6 +87,8 @@ int erts_use_sender_punish;
 Uint display_items;	    /* no of items to display in traces etc */
 Uint display_loads;		/* print info about loaded modules */
 int H_MIN_SIZE;			/* The minimum heap grain */
+int BIN_VH_MIN_SIZE;		/* The minimum binary virtual heap grain */
+int erts_heap_size_prediction;	/* Predict heap sizes per spawn site */
 
 Uint32 erts_debug_flags;	/* Debug flags. */
 #ifdef ERTS_OPCODE_COUNTER_SUPPORT
@@ -253,6 +255,7 @@ erl_init(void)
 			 no_schedulers_online);
 
     H_MIN_SIZE = erts_next_heap_size(H_MIN_SIZE, 0);
+    BIN_VH_MIN_SIZE = erts_next_heap_size(BIN_VH_MIN_SIZE, 0);
 
     erts_init_trace();
     erts_init_binary();
@@ -535,9 +538,22 @@ void erts_usage(void)
 
     erts_fprintf(stderr, "-h number  set minimum heap size in words (default %d)\n",
 	       H_DEFAULT_SIZE);
+    erts_fprintf(stderr, "-hmbs number  set minimum binary virtual heap size in words\n");
+    erts_fprintf(stderr, "           (default %d)\n", VH_DEFAULT_SIZE);
+    erts_fprintf(stderr, "-hpgc number  set number of helper threads for parallel\n");
+    erts_fprintf(stderr, "           garbage collection of large heaps (default 0)\n");
+    erts_fprintf(stderr, "-hpred boolean  enable or disable heap size prediction\n");
+    erts_fprintf(stderr, "           per spawn site (default true)\n");
 
     /*    erts_fprintf(stderr, "-i module  set the boot module (default init)\n"); */
 
+    erts_fprintf(stderr, "-IOo boolean  let kernel poll disarm file descriptors as\n");
+    erts_fprintf(stderr, "           they trigger and re-arm them lazily (default false)\n");
+    erts_fprintf(stderr, "-IOp number  set number of poll sets that file descriptors\n");
+    erts_fprintf(stderr, "           are spread over (default 1)\n");
+    erts_fprintf(stderr, "-IOt boolean  poll all file descriptors in dedicated poll\n");
+    erts_fprintf(stderr, "           threads instead of in schedulers (default false)\n");
+
     erts_fprintf(stderr, "-K boolean enable or disable kernel poll\n");
 
     erts_fprintf(stderr, "-l         turn on auto load tracing\n");
@@ -557,6 +573,8 @@ void erts_usage(void)
     erts_fprintf(stderr, "           u|ns|ts|ps|s|nnts|nnps|tnnps|db\n");
     erts_fprintf(stderr, "-sct cput  set cpu topology,\n");
     erts_fprintf(stderr, "           see the erl(1) documentation for more info.\n");
+    erts_fprintf(stderr, "-spp boolean  let port_command/2 enqueue the command on the\n");
+    erts_fprintf(stderr, "           port instead of calling the driver (default false)\n");
     erts_fprintf(stderr, "-sss size  suggested stack size in kilo words for scheduler threads,\n");
     erts_fprintf(stderr, "           valid range is [%d-%d]\n",
 		 ERTS_SCHED_THREAD_MIN_STACK_SIZE,
@@ -604,6 +622,9 @@ early_init(int *argc, char **argv) /*
     erts_async_max_threads = 0;
     erts_async_thread_suggested_stack_size = ERTS_ASYNC_THREAD_MIN_STACK_SIZE;
     H_MIN_SIZE = H_DEFAULT_SIZE;
+    BIN_VH_MIN_SIZE = VH_DEFAULT_SIZE;
+    erts_heap_size_prediction = 1;
+    erts_no_gc_threads = 0;
 
     erts_initialized = 0;
 
@@ -922,16 +943,61 @@ erl_start(int argc, char **argv)
 	    fprintf(stderr, "The undocumented +H option has been removed (R10B-6).\n\n");
 	    break;
 
-	case 'h':
-	    /* set default heap size */
-	    arg = get_arg(argv[i]+2, argv[i+1], &i);
-	    if ((H_MIN_SIZE = atoi(arg)) <= 0) {
-		erts_fprintf(stderr, "bad heap size %s\n", arg);
-		erts_usage();
+	case 'h': {
+	    char *sub_param = argv[i]+2;
+	    /* set default heap size
+	     *
+	     * h     - min_heap_size
+	     * hmbs  - min_bin_vheap_size
+	     * hpred - heap size prediction per spawn site
+	     * hpgc  - helper threads for parallel garbage collection
+	     */
+	    if (has_prefix("pgc", sub_param)) {
+		arg = get_arg(sub_param+3, argv[i+1], &i);
+		erts_no_gc_threads = atoi(arg);
+		if (erts_no_gc_threads < 0
+		    || erts_no_gc_threads > ERTS_MAX_NO_OF_GC_THREADS) {
+		    erts_fprintf(stderr,
+				 "bad number of gc helper threads %s\n", arg);
+		    erts_usage();
+		}
+		VERBOSE(DEBUG_SYSTEM,
+			("using %d gc helper threads\n", erts_no_gc_threads));
+	    }
+	    else if (has_prefix("pred", sub_param)) {
+		arg = get_arg(sub_param+4, argv[i+1], &i);
+		if (sys_strcmp("true", arg) == 0)
+		    erts_heap_size_prediction = 1;
+		else if (sys_strcmp("false", arg) == 0)
+		    erts_heap_size_prediction = 0;
+		else {
+		    erts_fprintf(stderr, "bad heap size prediction %s\n", arg);
+		    erts_usage();
+		}
+		VERBOSE(DEBUG_SYSTEM,
+			("heap size prediction %s\n", arg));
+	    }
+	    else if (has_prefix("mbs", sub_param)) {
+		arg = get_arg(sub_param+3, argv[i+1], &i);
+		if ((BIN_VH_MIN_SIZE = atoi(arg)) <= 0) {
+		    erts_fprintf(stderr, "bad binary virtual heap size %s\n", arg);
+		    erts_usage();
+		}
+		VERBOSE(DEBUG_SYSTEM,
+			("using minimum binary virtual heap size %d\n",
+			 BIN_VH_MIN_SIZE));
+	    }
+	    else {
+		arg = get_arg(sub_param, argv[i+1], &i);
+		if ((H_MIN_SIZE = atoi(arg)) <= 0) {
+		    erts_fprintf(stderr, "bad heap size %s\n", arg);
+		    erts_usage();
+		}
+		VERBOSE(DEBUG_SYSTEM,
+			("using minimum heap size %d\n",H_MIN_SIZE));
 	    }
-	    VERBOSE(DEBUG_SYSTEM,
-                    ("using minimum heap size %d\n",H_MIN_SIZE));
 	    break;
+	}
 
 	case 'd':
 	    /*
@@ -1089,6 +1155,19 @@ erl_start(int argc, char **argv)
 		use_multi_run_queue = 0;
 	    else if (sys_strcmp("nsp", sub_param) == 0)
 		erts_use_sender_punish = 0;
+	    else if (has_prefix("pp", sub_param)) {
+		arg = get_arg(sub_param+2, argv[i+1], &i);
+		if (sys_strcmp("true", arg) == 0)
+		    erts_port_parallelism = 1;
+		else if (sys_strcmp("false", arg) == 0)
+		    erts_port_parallelism = 0;
+		else {
+		    erts_fprintf(stderr, "bad port parallelism %s\n", arg);
+		    erts_usage();
+		}
+		VERBOSE(DEBUG_SYSTEM,
+			("port parallelism %s\n", arg));
+	    }
 	    else if (has_prefix("ss", sub_param)) {
 		/* suggested stack size (Kilo Words) for scheduler threads */
 		arg = get_arg(sub_param+2, argv[i+1], &i);
@@ -162,6 +162,9 @@ static erts_lc_lock_order_t erts_lock_order[] = {
     {	"xports_list_pre_alloc_lock",		"address"		},
     {	"inet_buffer_stack_lock",		NULL			},
     {	"gc_info",				NULL			},
+    {	"par_gc",				NULL			},
+    {	"par_gc_pool",				NULL			},
+    {	"par_gc_queue",				NULL			},
     {	"io_wake",				NULL			},
     {	"timer_wheel",				NULL			},
     {	"system_block",				NULL			},
@@ -188,7 +188,7 @@ link_mbuf_to_proc(Process *proc, ErlHeapFragment *bp)
 	bp->next = MBUF(proc);
 	MBUF(proc) = bp;
 	MBUF_SIZE(proc) += bp->size;
-	MSO(proc).overhead += proc->heap_sz; /* Force GC */
+	FORCE_GC(proc);
 
 	/* Move any binaries into the process */
 	if (bp->off_heap.mso != NULL) {
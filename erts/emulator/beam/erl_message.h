@@ -34,7 +34,8 @@ typedef struct erl_off_heap {
     struct erl_fun_thing* funs;	/* List of funs. */
 #endif
     struct external_thing_* externals; /* List of external things. */
-    int overhead;		/* Administrative overhead (used to force GC). */
+    Uint overhead;		/* Binary data referred (in words); used to
+				   force GC. */
 } ErlOffHeap;
 
 #include "external.h"
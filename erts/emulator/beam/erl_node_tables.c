@@ -105,21 +105,9 @@ dist_table_alloc(void *dep_tmpl)
     dep->nlinks				= NULL;
     dep->monitors			= NULL;
 
-    erts_smp_spinlock_init_x(&dep->qlock, "dist_entry_out_queue", chnl_nr);
-    dep->qflgs				= 0;
-    dep->qsize				= 0;
-    dep->out_queue.first		= NULL;
-    dep->out_queue.last			= NULL;
-    dep->suspended.first		= NULL;
-    dep->suspended.last			= NULL;
-
-    dep->finalized_out_queue.first	= NULL;
-    dep->finalized_out_queue.last	= NULL;
-
-    erts_smp_atomic_init(&dep->dist_cmd_scheduled, 0);
-    erts_port_task_handle_init(&dep->dist_cmd);
-    dep->send				= NULL;
-    dep->cache				= NULL;
+    erts_init_dist_stripe(&dep->primary, chnl_nr);
+    dep->no_stripes			= 0;
+    dep->stripes			= NULL;
 
     /* Link in */
 
@@ -167,10 +155,11 @@ dist_table_free(void *vdep)
     ASSERT(erts_no_of_not_connected_dist_entries > 0);
     erts_no_of_not_connected_dist_entries--;
 
-    ASSERT(!dep->cache);
+    ASSERT(!dep->primary.cache);
+    ASSERT(!dep->stripes);
     erts_smp_rwmtx_destroy(&dep->rwmtx);
     erts_smp_mtx_destroy(&dep->lnk_mtx);
-    erts_smp_spinlock_destroy(&dep->qlock);
+    erts_smp_spinlock_destroy(&dep->primary.qlock);
 
 #ifdef DEBUG
     sys_memset(vdep, 0x77, sizeof(DistEntry));
@@ -401,6 +390,31 @@ erts_set_dist_entry_not_connected(DistEntry *dep)
     erts_smp_rwmtx_rwunlock(&erts_dist_table_rwmtx);
 }
 
+void
+erts_init_dist_stripe(ErtsDistStripe *sp, Eterm chnl_nr)
+{
+    sp->cid				= NIL;
+    sp->attached			= 0;
+
+    erts_smp_spinlock_init_x(&sp->qlock, "dist_entry_out_queue", chnl_nr);
+    sp->qflgs				= 0;
+    sp->qsize				= 0;
+    sp->out_queue.first			= NULL;
+    sp->out_queue.last			= NULL;
+    sp->suspended.first			= NULL;
+    sp->suspended.last			= NULL;
+    sp->streams				= NULL;
+
+    sp->finalized_out_queue.first	= NULL;
+    sp->finalized_out_queue.last	= NULL;
+
+    erts_smp_atomic_init(&sp->dist_cmd_scheduled, 0);
+    erts_port_task_handle_init(&sp->dist_cmd);
+    sp->send				= NULL;
+    sp->cache				= NULL;
+    sp->in_fragments			= NULL;
+}
+
 void
 erts_set_dist_entry_connected(DistEntry *dep, Eterm cid, Uint flags)
 {
@@ -736,22 +750,10 @@ void erts_init_node_tables(void)
     erts_this_dist_entry->nlinks			= NULL;
     erts_this_dist_entry->monitors			= NULL;
 
-    erts_smp_spinlock_init_x(&erts_this_dist_entry->qlock,
-			     "dist_entry_out_queue",
-			     make_small(ERST_INTERNAL_CHANNEL_NO));
-    erts_this_dist_entry->qflgs				= 0;
-    erts_this_dist_entry->qsize				= 0;
-    erts_this_dist_entry->out_queue.first		= NULL;
-    erts_this_dist_entry->out_queue.last		= NULL;
-    erts_this_dist_entry->suspended.first		= NULL;
-    erts_this_dist_entry->suspended.last		= NULL;
-
-    erts_this_dist_entry->finalized_out_queue.first	= NULL;
-    erts_this_dist_entry->finalized_out_queue.last	= NULL;
-    erts_smp_atomic_init(&erts_this_dist_entry->dist_cmd_scheduled, 0);
-    erts_port_task_handle_init(&erts_this_dist_entry->dist_cmd);
-    erts_this_dist_entry->send				= NULL;
-    erts_this_dist_entry->cache				= NULL;
+    erts_init_dist_stripe(&erts_this_dist_entry->primary,
+			  make_small(ERST_INTERNAL_CHANNEL_NO));
+    erts_this_dist_entry->no_stripes			= 0;
+    erts_this_dist_entry->stripes			= NULL;
 
     (void) hash_put(&erts_dist_table, (void *) erts_this_dist_entry);
 
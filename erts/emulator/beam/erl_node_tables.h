@@ -67,6 +67,26 @@
 #define ERTS_DIST_OUTPUT_BUF_DBG_PATTERN ((Uint) 0xf713f713)
 #endif
 
+struct binary;
+
+/*
+ * A large binary that an output buffer refers to instead of holding a
+ * copy of it. The data of the binary follows the BINARY_EXT header
+ * that ends at ext_pos.
+ */
+typedef struct {
+    byte *ext_pos;
+    struct binary *bin;
+    byte *bytes;
+    Uint size;
+} ErtsDistBinRef;
+
+typedef struct {
+    Uint no;
+    Uint size;			/* Sum of the sizes of the binaries */
+    ErtsDistBinRef ref[1];
+} ErtsDistBinRefs;
+
 typedef struct ErtsDistOutputBuf_ ErtsDistOutputBuf;
 struct ErtsDistOutputBuf_ {
 #ifdef DEBUG
@@ -75,6 +95,11 @@ struct ErtsDistOutputBuf_ {
     ErtsDistOutputBuf *next;
     byte *extp;
     byte *ext_endp;
+    ErtsDistBinRefs *bin_refs;
+    ErtsDistOutputBuf *frag_of; /* Fragment of this buffer; the data */
+    Uint frag_offs;		/* follows ext_endp, frag_offs bytes */
+    Uint frag_size;		/* into the data of frag_of */
+    erts_refc_t frag_refc;	/* Fragments left of this buffer */
     byte data[1];
 };
 
@@ -89,6 +114,29 @@ typedef struct {
     struct ErtsProcList_ *last;
 } ErtsDistSuspended;
 
+/*
+ * The fragments of a large message, followed by what the same
+ * sender has sent after it.
+ */
+typedef struct ErtsDistOutputStream_ ErtsDistOutputStream;
+struct ErtsDistOutputStream_ {
+    ErtsDistOutputStream *next;
+    Eterm sender;
+    Sint size;
+    ErtsDistOutputQueue queue;
+    ErtsDistSuspended suspended;
+};
+
+/* A large message being put together from its fragments */
+typedef struct ErtsDistFragments_ ErtsDistFragments;
+struct ErtsDistFragments_ {
+    ErtsDistFragments *next;
+    Uint64 seq_id;
+    Uint64 frag_id;		/* Expected FragmentId of the next one */
+    struct binary *bin;
+    Uint size;
+};
+
 /*
  * Lock order:
  *   1. dist_entry->rwmtx
@@ -102,6 +150,34 @@ typedef struct {
 struct erl_link;
 struct port;
 
+/*
+ * One of the connections to a node. Besides the connection of the
+ * connection handler, a dist entry may have extra connections
+ * (stripes); the signals of a sender all go over the same one.
+ */
+typedef struct ErtsDistStripe_ ErtsDistStripe;
+struct ErtsDistStripe_ {
+    Eterm cid;			/* The port */
+    int attached;		/* Protected by the dist entry rwmtx */
+
+    erts_smp_spinlock_t qlock;  /* Protects qflgs and out_queue */
+    Uint32 qflgs;
+    Sint qsize;
+    ErtsDistOutputQueue out_queue;
+    ErtsDistSuspended suspended;
+    ErtsDistOutputStream *streams; /* Sent when out_queue is empty */
+
+    ErtsDistOutputQueue finalized_out_queue;
+    erts_smp_atomic_t dist_cmd_scheduled;
+    ErtsPortTaskHandle dist_cmd;
+
+    Uint (*send)(struct port *prt, ErtsDistOutputBuf *obuf);
+
+    struct cache* cache;	/* The atom cache */
+
+    ErtsDistFragments *in_fragments; /* Protected by the port lock */
+};
+
 typedef struct dist_entry_ {
     HashBucket hash_bucket;     /* Hash bucket */
     struct dist_entry_ *next;	/* Next entry in dist_table (not sorted) */
@@ -131,19 +207,9 @@ typedef struct dist_entry_ {
     ErtsLink *nlinks;           /* Link tree with subtrees */
     ErtsMonitor *monitors;      /* Monitor tree */
 
-    erts_smp_spinlock_t qlock;  /* Protects qflgs and out_queue */
-    Uint32 qflgs;
-    Sint qsize;
-    ErtsDistOutputQueue out_queue;
-    ErtsDistSuspended suspended;
-
-    ErtsDistOutputQueue finalized_out_queue;
-    erts_smp_atomic_t dist_cmd_scheduled;
-    ErtsPortTaskHandle dist_cmd;
-
-    Uint (*send)(struct port *prt, ErtsDistOutputBuf *obuf);
-
-    struct cache* cache;	/* The atom cache */
+    ErtsDistStripe primary;	/* The connection of cid */
+    int no_stripes;		/* Extra connections; both fields are */
+    ErtsDistStripe **stripes;	/* protected by rwmtx. NULL when gone. */
 } DistEntry;
 
 typedef struct erl_node_ {
@@ -179,6 +245,7 @@ Uint erts_dist_table_size(void);
 void erts_dist_table_info(int, void *);
 void erts_set_dist_entry_not_connected(DistEntry *);
 void erts_set_dist_entry_connected(DistEntry *, Eterm, Uint);
+void erts_init_dist_stripe(ErtsDistStripe *, Eterm);
 ErlNode *erts_find_or_insert_node(Eterm, Uint);
 void erts_delete_node(ErlNode *);
 void erts_set_this_node(Eterm, Uint);
@@ -46,7 +46,10 @@
 #define ERTS_PORT_REDS_INPUT		200
 #define ERTS_PORT_REDS_OUTPUT		200
 #define ERTS_PORT_REDS_EVENT		200
+#define ERTS_PORT_REDS_COMMAND		200
+#define ERTS_PORT_REDS_ASYNC		200
 #define ERTS_PORT_REDS_TERMINATE	100
+#define ERTS_PORT_REDS_BATCH		CONTEXT_REDS
 
 
 #define ERTS_PORT_TASK_INVALID_PORT(P, ID) \
@@ -554,7 +557,7 @@ erts_port_task_schedule(Eterm id,
 	return -1;
     }
 
-    ASSERT(!erts_port_task_is_scheduled(pthp));
+    ASSERT(!pthp || !erts_port_task_is_scheduled(pthp));
 
     ERTS_PT_CHK_PRES_PORTQ(runq, pp);
 #ifdef DEBUG
@@ -725,41 +728,22 @@ resume_after_block(void *vd)
 }
 
 /*
- * Run all scheduled tasks for the first port in run queue. If
+ * Run all scheduled tasks for a port popped from the run queue. If
  * new tasks appear while running reschedule port (free task is
- * an exception; it is always handled instantly).
- *
- * erts_port_task_execute() is called by scheduler threads between
- * scheduleing of processes. Sched lock should be held by caller.
+ * an exception; it is always handled instantly). Returns the
+ * reductions spent. Run queue lock is held on entry and on return.
  */
 
-int
-erts_port_task_execute(ErtsRunQueue *runq, Port **curr_port_pp)
+static int
+execute_port_tasks(ErtsRunQueue *runq, Port *pp, Port **curr_port_pp,
+		   long *io_tasks_executedp)
 {
     int port_was_enqueued = 0;
-    Port *pp;
     ErtsPortTaskQueue *ptqp;
     ErtsPortTask *ptp;
-    int res = 0;
     int reds = ERTS_PORT_REDS_EXECUTE;
     long io_tasks_executed = 0;
     int fpe_was_unmasked;
-    ErtsPortTaskExeBlockData blk_data = {runq, NULL};
-
-    ERTS_SMP_LC_ASSERT(erts_smp_lc_runq_is_locked(runq));
-
-    erts_smp_activity_begin(ERTS_ACTIVITY_IO,
-			    prepare_for_block,
-			    resume_after_block,
-			    (void *) &blk_data);
-
-    ERTS_PT_CHK_PORTQ(runq);
-
-    pp = pop_port(runq);
-    if (!pp) {
-	res = 0;
-	goto done;
-    }
 
     ERTS_PORT_NOT_IN_RUNQ(pp);
 
@@ -850,23 +834,40 @@ erts_port_task_execute(ErtsRunQueue *runq, Port **curr_port_pp)
 	    ASSERT((pp->status & ERTS_PORT_SFLGS_DEAD) == 0);
 	    /* NOTE some windows drivers use ->ready_input for input and output */
 	    (*pp->drv_ptr->ready_input)((ErlDrvData) pp->drv_data, ptp->event);
+#ifdef ERTS_SMP
+	    erts_sys_io_task_executed(pp->id, ptp->event, ERL_DRV_READ);
+#endif
 	    io_tasks_executed++;
 	    break;
 	case ERTS_PORT_TASK_OUTPUT:
 	    reds += ERTS_PORT_REDS_OUTPUT;
 	    ASSERT((pp->status & ERTS_PORT_SFLGS_DEAD) == 0);
 	    (*pp->drv_ptr->ready_output)((ErlDrvData) pp->drv_data, ptp->event);
+#ifdef ERTS_SMP
+	    erts_sys_io_task_executed(pp->id, ptp->event, ERL_DRV_WRITE);
+#endif
 	    io_tasks_executed++;
 	    break;
 	case ERTS_PORT_TASK_EVENT:
 	    reds += ERTS_PORT_REDS_EVENT;
 	    ASSERT((pp->status & ERTS_PORT_SFLGS_DEAD) == 0);
 	    (*pp->drv_ptr->event)((ErlDrvData) pp->drv_data, ptp->event, ptp->event_data);
+#ifdef ERTS_SMP
+	    erts_sys_io_task_executed(pp->id, ptp->event, 0);
+#endif
 	    io_tasks_executed++;
 	    break;
 	case ERTS_PORT_TASK_DIST_CMD:
 	    reds += erts_dist_command(pp, CONTEXT_REDS-reds);
 	    break;
+#ifdef ERTS_SMP
+	case ERTS_PORT_TASK_COMMAND:
+	    reds += ERTS_PORT_REDS_COMMAND*erts_port_flush_commands(pp);
+	    break;
+	case ERTS_PORT_TASK_ASYNC:
+	    reds += ERTS_PORT_REDS_ASYNC*erts_async_deliver(pp);
+	    break;
+#endif
 	default:
 	    erl_exit(ERTS_ABORT_EXIT,
 		     "Invalid port task type: %d\n",
@@ -901,10 +902,7 @@ erts_port_task_execute(ErtsRunQueue *runq, Port **curr_port_pp)
 
     erts_unblock_fpe(fpe_was_unmasked);
 
-    if (io_tasks_executed) {
-	ASSERT(erts_smp_atomic_read(&erts_port_task_outstanding_io_tasks) >= io_tasks_executed);
-	erts_smp_atomic_add(&erts_port_task_outstanding_io_tasks, -1*io_tasks_executed);
-    }
+    *io_tasks_executedp += io_tasks_executed;
 
     *curr_port_pp = NULL;
 
@@ -927,8 +925,6 @@ erts_port_task_execute(ErtsRunQueue *runq, Port **curr_port_pp)
     ASSERT(pp->sched.exe_taskq);
     pp->sched.exe_taskq = NULL;
 
-    res = erts_smp_atomic_read(&erts_port_task_outstanding_io_tasks) != (long) 0;
-
     ERTS_PT_CHK_PRES_PORTQ(runq, pp);
 
     port_taskq_free(ptqp);
@@ -953,12 +949,71 @@ erts_port_task_execute(ErtsRunQueue *runq, Port **curr_port_pp)
 	    erts_smp_runq_unlock(runq);
 	    erts_port_cleanup(pp); /* Might aquire runq lock */
 	    erts_smp_runq_lock(runq);
-	    res = erts_smp_atomic_read(&erts_port_task_outstanding_io_tasks) != (long) 0;
 	}
     }
 #endif
 
- done:
+    if (erts_sched_stat.enabled) {
+	erts_smp_spin_lock(&erts_sched_stat.lock);
+	erts_sched_stat.prio[ERTS_PORT_PRIO_LEVEL].total_reds += reds;
+	erts_sched_stat.prio[ERTS_PORT_PRIO_LEVEL].reds += reds;
+	erts_smp_spin_unlock(&erts_sched_stat.lock);
+    }
+
+    return reds;
+}
+
+/*
+ * Run the tasks of the ports in the run queue, one port after the
+ * other, until ERTS_PORT_REDS_BATCH reductions have been spent or
+ * each port that was in the queue on entry has been run once. This
+ * gives ports about the same share of the scheduler as a process
+ * time slice, while the fixed cost of switching to port execution
+ * is shared by all ports run in the batch.
+ *
+ * erts_port_task_execute() is called by scheduler threads between
+ * scheduleing of processes. Sched lock should be held by caller.
+ */
+
+int
+erts_port_task_execute(ErtsRunQueue *runq, Port **curr_port_pp)
+{
+    Port *pp;
+    int res = 0;
+    int reds = 0;
+    int ports = runq->ports.info.len;
+    long io_tasks_executed = 0;
+    ErtsPortTaskExeBlockData blk_data = {runq, NULL};
+
+    ERTS_SMP_LC_ASSERT(erts_smp_lc_runq_is_locked(runq));
+
+    erts_smp_activity_begin(ERTS_ACTIVITY_IO,
+			    prepare_for_block,
+			    resume_after_block,
+			    (void *) &blk_data);
+
+    ERTS_PT_CHK_PORTQ(runq);
+
+    /*
+     * Ports rescheduled while running are put last in the queue and
+     * are not run again in this batch, since we stop after the number
+     * of ports queued on entry.
+     */
+    while (ports-- > 0 && reds < ERTS_PORT_REDS_BATCH) {
+	pp = pop_port(runq);
+	if (!pp)
+	    break;
+	reds += execute_port_tasks(runq, pp, curr_port_pp,
+				   &io_tasks_executed);
+    }
+
+    if (io_tasks_executed) {
+	ASSERT(erts_smp_atomic_read(&erts_port_task_outstanding_io_tasks) >= io_tasks_executed);
+	erts_smp_atomic_add(&erts_port_task_outstanding_io_tasks, -1*io_tasks_executed);
+    }
+
+    res = erts_smp_atomic_read(&erts_port_task_outstanding_io_tasks) != (long) 0;
+
     blk_data.resp = &res;
     erts_smp_activity_end(ERTS_ACTIVITY_IO,
 			  prepare_for_block,
@@ -1008,6 +1063,8 @@ handle_remaining_tasks(ErtsRunQueue *runq, Port *pp)
 		erts_stale_drv_select(pp->id, ptp->event, 0, 1);
 		break;
 	    case ERTS_PORT_TASK_DIST_CMD:
+	    case ERTS_PORT_TASK_COMMAND:
+	    case ERTS_PORT_TASK_ASYNC:
 		break;
 	    default:
 		erl_exit(ERTS_ABORT_EXIT,
@@ -49,7 +49,9 @@ typedef enum {
     ERTS_PORT_TASK_OUTPUT,
     ERTS_PORT_TASK_EVENT,
     ERTS_PORT_TASK_TIMEOUT,
-    ERTS_PORT_TASK_DIST_CMD
+    ERTS_PORT_TASK_DIST_CMD,
+    ERTS_PORT_TASK_COMMAND,
+    ERTS_PORT_TASK_ASYNC
 } ErtsPortTaskType;
 
 #ifdef ERTS_INCLUDE_SCHEDULER_INTERNALS
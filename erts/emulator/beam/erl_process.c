@@ -479,6 +479,8 @@ erts_late_init_process(void)
 	erts_sched_stat.prio[ix].executed = 0;
 	erts_sched_stat.prio[ix].total_migrated = 0;
 	erts_sched_stat.prio[ix].migrated = 0;
+	erts_sched_stat.prio[ix].total_reds = 0;
+	erts_sched_stat.prio[ix].reds = 0;
     }
 
 }
@@ -5799,6 +5801,13 @@ Process *schedule(Process *p, int calls)
 
 	erts_smp_proc_lock(p, ERTS_PROC_LOCK_STATUS);
 
+	if (erts_sched_stat.enabled) {
+	    erts_smp_spin_lock(&erts_sched_stat.lock);
+	    erts_sched_stat.prio[p->prio].total_reds += actual_reds;
+	    erts_sched_stat.prio[p->prio].reds += actual_reds;
+	    erts_smp_spin_unlock(&erts_sched_stat.lock);
+	}
+
 	if ((erts_system_profile_flags.runnable_procs)
 	    && (p->status == P_WAITING)) {
 	    profile_runnable_proc(p, am_inactive);
@@ -6252,7 +6261,8 @@ Process *schedule(Process *p, int calls)
 	    erts_check_my_tracer_proc(p);
 #endif
 
-	if (((MBUF_SIZE(p) + MSO(p).overhead) * MBUF_GC_FACTOR) >= HEAP_SIZE(p)) {
+	if ((MBUF_SIZE(p) * MBUF_GC_FACTOR) >= HEAP_SIZE(p)
+	    || ERTS_BIN_VHEAP_EXCEEDED(p)) {
 	    reds -= erts_garbage_collect(p, 0, p->arg_reg, p->arity);
 	    if (reds < 0) {
 		reds = 1;
@@ -6278,7 +6288,7 @@ erts_sched_stat_modify(int what)
 	break;
     case ERTS_SCHED_STAT_MODIFY_DISABLE:
 	erts_smp_block_system(0);
-	erts_sched_stat.enabled = 1;
+	erts_sched_stat.enabled = 0;
 	erts_smp_release_system();
 	break;
     case ERTS_SCHED_STAT_MODIFY_CLEAR:
@@ -6288,6 +6298,8 @@ erts_sched_stat_modify(int what)
 	    erts_sched_stat.prio[ix].executed = 0;
 	    erts_sched_stat.prio[ix].total_migrated = 0;
 	    erts_sched_stat.prio[ix].migrated = 0;
+	    erts_sched_stat.prio[ix].total_reds = 0;
+	    erts_sched_stat.prio[ix].reds = 0;
 	}
 	erts_smp_spin_unlock(&erts_sched_stat.lock);
 	break;
@@ -6302,6 +6314,7 @@ erts_sched_stat_term(Process *p, int total)
     Eterm prio[ERTS_NO_PRIO_LEVELS];
     Uint executed[ERTS_NO_PRIO_LEVELS];
     Uint migrated[ERTS_NO_PRIO_LEVELS];
+    Uint reds[ERTS_NO_PRIO_LEVELS];
 
     erts_smp_spin_lock(&erts_sched_stat.lock);
     if (total) {
@@ -6310,6 +6323,7 @@ erts_sched_stat_term(Process *p, int total)
 	    prio[i] = erts_sched_stat.prio[i].name;
 	    executed[i] = erts_sched_stat.prio[i].total_executed;
 	    migrated[i] = erts_sched_stat.prio[i].total_migrated;
+	    reds[i] = erts_sched_stat.prio[i].total_reds;
 	}
     }
     else {
@@ -6320,16 +6334,18 @@ erts_sched_stat_term(Process *p, int total)
 	    erts_sched_stat.prio[i].executed = 0;
 	    migrated[i] = erts_sched_stat.prio[i].migrated;
 	    erts_sched_stat.prio[i].migrated = 0;
+	    reds[i] = erts_sched_stat.prio[i].reds;
+	    erts_sched_stat.prio[i].reds = 0;
 	}
     }
     erts_smp_spin_unlock(&erts_sched_stat.lock);
 
     sz = 0;
-    (void) erts_bld_atom_2uint_3tup_list(NULL, &sz, ERTS_NO_PRIO_LEVELS,
-					 prio, executed, migrated);
+    (void) erts_bld_atom_3uint_4tup_list(NULL, &sz, ERTS_NO_PRIO_LEVELS,
+					 prio, executed, migrated, reds);
     hp = HAlloc(p, sz);
-    return erts_bld_atom_2uint_3tup_list(&hp, NULL, ERTS_NO_PRIO_LEVELS,
-					 prio, executed, migrated);
+    return erts_bld_atom_3uint_4tup_list(&hp, NULL, ERTS_NO_PRIO_LEVELS,
+					 prio, executed, migrated, reds);
 }
 
 /*
@@ -6597,6 +6613,166 @@ alloc_process(void)
 
 }
 
+/*
+ * Heap size prediction per spawn site.
+ *
+ * When a process exits, the amount of heap it was using is folded into
+ * a running average kept in the export entry of the function that it
+ * was spawned to run, or in the fun entry if it was spawned to run a
+ * fun. New processes spawned to run the same function start with a
+ * heap of that size, instead of climbing the heap size ladder through
+ * repeated minor collections. The hint of an exported function can be
+ * fixed (or handed back to the learning) with
+ * erlang:system_flag(heap_size_hint, {MFA, Size}).
+ *
+ * The function is found at spawn, looking through erlang:apply/2 and
+ * the proc_lib and gen start functions; processes started by gen get
+ * the hint of Module:init/1. Processes spawned through other generic
+ * start functions learn nothing, rather than share one hint with
+ * unrelated processes.
+ *
+ * The hint is only written when the average changes, which it stops
+ * doing once processes from the site use a stable amount of heap.
+ */
+
+#define ERTS_HEAP_HINT_MAX (1024*1024)
+
+static Eterm
+nth_arg(Eterm args, Uint n)
+{
+    while (n-- > 1)
+	args = CDR(list_val(args));
+    return CAR(list_val(args));
+}
+
+static void
+heap_hint_site(Process *p, Eterm mod, Eterm func, Uint arity, Eterm args)
+{
+    Eterm fun;
+
+    p->heap_hint_ep = NULL;
+    p->heap_hint_fe = NULL;
+    if (!erts_heap_size_prediction)
+	return;
+
+    while (1) {
+	if (mod == am_erlang && func == am_apply && arity == 2) {
+	    fun = nth_arg(args, 1);
+	    break;
+	}
+	else if (mod == am_proc_lib && func == am_init_p && arity == 3) {
+	    fun = nth_arg(args, 3);
+	    break;
+	}
+	else if (mod == am_proc_lib && func == am_init_p && arity == 5) {
+	    Sint len;
+	    mod = nth_arg(args, 3);
+	    func = nth_arg(args, 4);
+	    args = nth_arg(args, 5);
+	    if (!is_atom(mod) || !is_atom(func)
+		|| (len = list_length(args)) < 0)
+		return;
+	    arity = (Uint) len;
+	}
+	else if (mod == am_gen && func == am_init_it
+		 && (arity == 6 || arity == 7)) {
+	    mod = nth_arg(args, arity - 2);
+	    if (!is_atom(mod))
+		return;
+	    func = am_init;
+	    arity = 1;
+	}
+	else if (mod == am_erlang && func == am_apply) {
+	    return;
+	}
+	else if (mod == am_proc_lib || mod == am_gen) {
+	    return;
+	}
+	else {
+	    p->heap_hint_ep = erts_find_export_entry(mod, func, arity);
+	    return;
+	}
+    }
+
+    if (is_fun(fun)) {
+	ErlFunEntry *fe = ((ErlFunThing *) fun_val(fun))->fe;
+	erts_refc_inc(&fe->refc, 2);
+	p->heap_hint_fe = fe;
+    }
+    else if (is_export(fun)) {
+	p->heap_hint_ep = (Export *) (export_val(fun))[1];
+    }
+}
+
+static ERTS_INLINE Uint
+predicted_heap_size(Process *p)
+{
+    long hint;
+
+    if (p->heap_hint_ep)
+	hint = erts_smp_atomic_read(&p->heap_hint_ep->heap_hint);
+    else if (p->heap_hint_fe)
+	hint = erts_smp_atomic_read(&p->heap_hint_fe->heap_hint);
+    else
+	return 0;
+    return hint ? erts_next_heap_size((Uint) hint, 0) : 0;
+}
+
+static void
+learn_heap_size(Process *p)
+{
+    erts_smp_atomic_t *hintp;
+    ErlFunEntry *fe = p->heap_hint_fe;
+    Uint used;
+    long hint;
+
+    if (p->heap_hint_ep) {
+	if (p->heap_hint_ep->heap_hint_fixed)
+	    return;
+	hintp = &p->heap_hint_ep->heap_hint;
+    }
+    else if (fe)
+	hintp = &fe->heap_hint;
+    else
+	return;
+
+    used = (HEAP_TOP(p) - HEAP_START(p)) + (HEAP_END(p) - STACK_TOP(p));
+    if (OLD_HEAP(p))
+	used += OLD_HTOP(p) - OLD_HEAP(p);
+    if (used > ERTS_HEAP_HINT_MAX)
+	used = ERTS_HEAP_HINT_MAX;
+
+    hint = erts_smp_atomic_read(hintp);
+    while (1) {
+	long new_hint = (3*hint + (long) used) / 4;
+	long act;
+	if (new_hint == hint)
+	    break;
+	act = erts_smp_atomic_cmpxchg(hintp, new_hint, hint);
+	if (act == hint)
+	    break;
+	hint = act;
+    }
+
+    p->heap_hint_ep = NULL;
+    if (fe) {
+	p->heap_hint_fe = NULL;
+	if (erts_refc_dectest(&fe->refc, 0) == 0)
+	    erts_erase_fun_entry(fe);
+    }
+}
+
+Eterm
+erts_heap_size_hint_term(Process *c_p, Export *ep)
+{
+    Eterm *hp = HAlloc(c_p, 3);
+    long hint = ep ? erts_smp_atomic_read(&ep->heap_hint) : 0;
+
+    return TUPLE2(hp,
+		  (ep && ep->heap_hint_fixed) ? am_fixed : am_learned,
+		  make_small(hint ? erts_next_heap_size((Uint) hint, 0) : 0));
+}
+
 Eterm
 erl_create_process(Process* parent, /* Parent of process (default group leader). */
 		   Eterm mod,	/* Tagged atom for module. */
@@ -6612,6 +6788,7 @@ erl_create_process(Process* parent, /* Parent of process (default group leader).
 #endif
     Uint sz;			/* Needed words on heap. */
     Uint heap_need;		/* Size needed on heap. */
+    Uint hint;			/* Predicted heap size. */
     Eterm res = THE_NON_VALUE;
 
 #ifdef ERTS_SMP
@@ -6664,10 +6841,12 @@ erl_create_process(Process* parent, /* Parent of process (default group leader).
      */
     if (so->flags & SPO_USE_ARGS) {
 	p->min_heap_size = so->min_heap_size;
+	p->min_vheap_size = so->min_vheap_size;
 	p->prio = so->priority;
 	p->max_gen_gcs = so->max_gen_gcs;
     } else {
 	p->min_heap_size = H_MIN_SIZE;
+	p->min_vheap_size = BIN_VH_MIN_SIZE;
 	p->prio = PRIORITY_NORMAL;
 	p->max_gen_gcs = (Uint16) erts_smp_atomic_read(&erts_max_gen_gcs);
     }
@@ -6687,6 +6866,9 @@ erl_create_process(Process* parent, /* Parent of process (default group leader).
 #endif
     p->off_heap.externals = NULL;
     p->off_heap.overhead = 0;
+    p->bin_vheap_sz = p->min_vheap_size;
+    p->bin_old_vheap_sz = p->min_vheap_size;
+    p->bin_old_vheap = 0;
 
     heap_need +=
 	IS_CONST(parent->group_leader) ? 0 : NC_HEAP_SIZE(parent->group_leader);
@@ -6697,6 +6879,12 @@ erl_create_process(Process* parent, /* Parent of process (default group leader).
 	sz = erts_next_heap_size(heap_need, 0);
     }
 
+    heap_hint_site(p, mod, func, (Uint) arity, args);
+    hint = predicted_heap_size(p);
+    if (hint > sz) {
+	sz = hint;
+    }
+
 #ifdef HIPE
     hipe_init_process(&p->hipe);
 #ifdef ERTS_SMP
@@ -6711,6 +6899,7 @@ erl_create_process(Process* parent, /* Parent of process (default group leader).
     p->scan_top = p->high_water;
 #endif
     p->gen_gcs = 0;
+    p->literal_refs = NULL;
     p->stop = p->hend = p->heap + sz;
     p->htop = p->heap;
     p->heap_sz = sz;
@@ -6944,7 +7133,14 @@ void erts_init_empty_process(Process *p)
     p->heap = NULL;
     p->gen_gcs = 0;
     p->max_gen_gcs = 0;
+    p->heap_hint_ep = NULL;
+    p->heap_hint_fe = NULL;
+    p->literal_refs = NULL;
     p->min_heap_size = 0;
+    p->min_vheap_size = 0;
+    p->bin_vheap_sz = 0;
+    p->bin_old_vheap_sz = 0;
+    p->bin_old_vheap = 0;
     p->status = P_RUNABLE;
     p->gcstatus = P_RUNABLE;
     p->rstatus = P_RUNABLE;
@@ -7179,6 +7375,9 @@ delete_process(Process* p)
     /* Clean binaries and funs */
     erts_cleanup_offheap(&p->off_heap);
 
+    /* Release literals of purged code */
+    erts_cleanup_literal_refs(p);
+
     /*
      * The mso list should not be used anymore, but if it is, make sure that
      * we'll notice.
@@ -7769,7 +7968,8 @@ static void doit_exit_monitor(ErtsMonitor *mon, void *vpcontext)
 						      ? rmon->name
 						      : rmon->pid),
 						     mon->ref,
-						     pcontext->reason);
+						     pcontext->reason,
+						     pcontext->p->id);
 			ASSERT(code == ERTS_DSIG_SEND_OK);
 		    }
 		    erts_destroy_monitor(rmon);
@@ -7813,6 +8013,7 @@ static void doit_exit_link(ErtsLink *lnk, void *vpcontext)
 		rlnk = erts_remove_link(&prt->nlinks, p->id);
 		if (rlnk)
 		    erts_destroy_link(rlnk);
+		ERTS_SMP_PORT_FLUSH_COMMANDS(prt);
 		erts_do_exit_port(prt, p->id, reason);
 		erts_port_release(prt);
 	    }
@@ -7940,6 +8141,8 @@ erts_do_exit_process(Process* p, Eterm reason)
 
     p->arity = 0;		/* No live registers */
     p->fvalue = reason;
+
+    learn_heap_size(p);
     
 #ifdef ERTS_SMP
     ERTS_SMP_CHK_HAVE_ONLY_MAIN_PROC_LOCK(p);
@@ -425,6 +425,8 @@ typedef struct {
 	Uint executed;
 	Uint total_migrated;
 	Uint migrated;
+	Uint total_reds;
+	Uint reds;
     } prio[ERTS_NO_PRIO_LEVELS];
 } erts_sched_stat_t;
 
@@ -471,6 +473,10 @@ struct ErtsPendingSuspend_ {
 #  define MBUF_SIZE(p)      (p)->mbuf_sz
 #  define MSO(p)            (p)->off_heap
 #  define MIN_HEAP_SIZE(p)  (p)->min_heap_size
+#  define MIN_VHEAP_SIZE(p)   (p)->min_vheap_size
+#  define BIN_VHEAP_SZ(p)     (p)->bin_vheap_sz
+#  define BIN_OLD_VHEAP_SZ(p) (p)->bin_old_vheap_sz
+#  define BIN_OLD_VHEAP(p)    (p)->bin_old_vheap
 
 struct process {
     /* All fields in the PCB that differs between different heap
@@ -556,6 +562,8 @@ struct process {
     Eterm seq_trace_token;	/* Sequential trace token (tuple size 5 see below) */
 
     Eterm initial[3];		/* Initial module(0), function(1), arity(2) */
+    struct export *heap_hint_ep; /* Where the heap size is learned for */
+    struct erl_fun_entry *heap_hint_fe; /* this process, if anywhere. */
     Eterm* current;		/* Current Erlang function:
 				 * module(0), function(1), arity(2)
 				 * (module and functions are tagged atoms;
@@ -580,8 +588,18 @@ struct process {
     Uint16 gen_gcs;		/* Number of (minor) generational GCs. */
     Uint16 max_gen_gcs;		/* Max minor gen GCs before fullsweep. */
     ErlOffHeap off_heap;	/* Off-heap data updated by copy_struct(). */
+    Uint min_vheap_size;	/* Minimum virtual binary heap size (in words). */
+    Uint bin_vheap_sz;		/* Virtual binary heap size, i.e. amount of
+				 * binary data (in words) referred from the
+				 * young heap that triggers a GC. */
+    Uint bin_old_vheap_sz;	/* Virtual binary heap size of the old
+				 * generation; triggers a fullsweep. */
+    Uint bin_old_vheap;		/* Binary data (in words) referred from
+				 * the old heap. */
     ErlHeapFragment* mbuf;	/* Pointer to message buffer list */
     Uint mbuf_sz;		/* Size of all message buffers */
+    struct erts_literal_ref* literal_refs; /* Literal areas of purged
+					    * code still referred to. */
     ErtsPSD *psd;		/* Rarely used process specific data */
 
     union {
@@ -670,17 +688,17 @@ void erts_check_for_holes(Process* p);
 #define MBUF_GC_FACTOR 1
 #endif
 
-/*
- * The weight of binaries outside the heap (for p->overhead calculation).
- */
-
-#define BINARY_OVERHEAD_FACTOR 16
-
 /*
  * Force a garbage collection for the given process.
+ *
+ * p->off_heap.overhead is the amount of binary data (in words) that
+ * has been referred from the young heap since the last GC. A GC is
+ * triggered when it exceeds the virtual binary heap size of the process.
  */
 
-#define FORCE_GC(p) ((p)->off_heap.overhead = p->heap_sz)
+#define FORCE_GC(p) ((p)->off_heap.overhead += BIN_VHEAP_SZ((p)) + 1)
+
+#define ERTS_BIN_VHEAP_EXCEEDED(p) (MSO((p)).overhead > BIN_VHEAP_SZ((p)))
 
 #define SEQ_TRACE_TOKEN(p)  ((p)->seq_trace_token)
 
@@ -726,6 +744,7 @@ typedef struct {
     Uint min_heap_size;		/* Minimum heap size (must be a valued returned
 				 * from next_heap_size()).
 				 */
+    Uint min_vheap_size;	/* Minimum virtual binary heap size (in words). */
     int priority;		/* Priority for process. */
     Uint16 max_gen_gcs;		/* Maximum number of gen GCs before fullsweep. */
     int scheduler;
@@ -995,6 +1014,7 @@ ErtsMigrateResult erts_proc_migrate(Process *,
 Process *schedule(Process*, int);
 void erts_schedule_misc_op(void (*)(void *), void *);
 Eterm erl_create_process(Process*, Eterm, Eterm, Eterm, ErlSpawnOpts*);
+Eterm erts_heap_size_hint_term(Process *, Export *);
 void erts_do_exit_process(Process*, Eterm);
 void erts_continue_exit_process(Process *);
 void set_timer(Process*, Uint);
@@ -51,6 +51,7 @@
 #define INPUT_REDUCTIONS (2 * CONTEXT_REDS)
 
 #define H_DEFAULT_SIZE  233     /* default (heap + stack) min size */
+#define VH_DEFAULT_SIZE 46368   /* default virtual (bin) heap min size (words) */
 
 #ifdef HYBRID
 #  define SH_DEFAULT_SIZE  2629425 /* default message area min size */
@@ -182,6 +183,8 @@ extern int num_instructions;	/* Number of instruction in opc[]. */
 #define MAX_PORT_LINK 8		/* Maximum number of links to a port        */
 
 extern int H_MIN_SIZE;		/* minimum (heap + stack) */
+extern int BIN_VH_MIN_SIZE;	/* minimum virtual (bin) heap */
+extern int erts_heap_size_prediction; /* learn heap sizes per spawn site */
 
 #define ORIG_CREATION 0
 
@@ -96,6 +96,8 @@ export_alloc(Export* tmpl)
     obj->code[3] = (Eterm) em_call_error_handler;
     obj->code[4] = 0;
     obj->match_prog_set = NULL;
+    erts_smp_atomic_init(&obj->heap_hint, 0);
+    obj->heap_hint_fixed = 0;
     return obj;
 }
 
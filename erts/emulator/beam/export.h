@@ -24,6 +24,8 @@
 #include "sys.h"
 #endif
 
+#include "erl_smp.h"
+
 #ifndef __INDEX_H__
 #include "index.h"
 #endif
@@ -36,6 +38,9 @@ typedef struct export
     IndexSlot slot; /* MUST BE LOCATED AT TOP OF STRUCT!!! */
     void* address;		/* Pointer to code for function. */
     struct binary* match_prog_set; /* Match program for tracing. */
+    erts_smp_atomic_t heap_hint; /* Predicted heap size (in words) of
+				   processes spawned to run this function. */
+    int heap_hint_fixed;	/* heap_hint set by system_flag/2; don't learn. */
 
     Eterm fake_op_func_info_for_hipe[2]; /* MUST be just before code[] */
     /*
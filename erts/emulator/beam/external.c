@@ -85,7 +85,8 @@
  *
  */
 
-static byte* enc_term(ErtsAtomCacheMap *, Eterm, byte*, Uint32);
+static byte* enc_term(ErtsAtomCacheMap *, Eterm, byte*, Uint32,
+		      ErtsDistBinRefs *);
 static Uint is_external_string(Eterm obj, int* p_is_string);
 static byte* enc_atom(ErtsAtomCacheMap *, Eterm, byte*, Uint32);
 static byte* enc_pid(ErtsAtomCacheMap *, Eterm, byte*, Uint32);
@@ -95,7 +96,8 @@ static byte* dec_pid(ErtsDistExternal *, Eterm**, byte*, ErlOffHeap*, Eterm*);
 static Sint decoded_size(byte *ep, byte* endp, int only_heap_bins);
 
 
-static Uint encode_size_struct2(ErtsAtomCacheMap *, Eterm, unsigned);
+static Uint encode_size_struct2(ErtsAtomCacheMap *, Eterm, unsigned,
+				ErtsDistBinRefs *);
 
 #define ERTS_MAX_INTERNAL_ATOM_CACHE_ENTRIES 255
 
@@ -449,31 +451,41 @@ byte *erts_encode_ext_dist_header_finalize(byte *ext, ErtsAtomCache *cache)
     return ep;
 }
 
-Uint erts_encode_dist_ext_size(Eterm term, Uint32 flags, ErtsAtomCacheMap *acmp)
+/*
+ * If refs is non-NULL, large binaries are not included in the size;
+ * they are counted in refs instead.
+ */
+Uint erts_encode_dist_ext_size(Eterm term, Uint32 flags, ErtsAtomCacheMap *acmp,
+			       ErtsDistBinRefs *refs)
 {
     Uint sz = 0;
 #ifndef ERTS_DEBUG_USE_DIST_SEP
     if (!(flags & DFLAG_DIST_HDR_ATOM_CACHE))
 #endif
 	sz++ /* VERSION_MAGIC */;
-    sz += encode_size_struct2(acmp, term, flags);
+    sz += encode_size_struct2(acmp, term, flags, refs);
     return sz;
 }
 
 Uint erts_encode_ext_size(Eterm term)
 {
-    return encode_size_struct2(NULL, term, TERM_TO_BINARY_DFLAGS)
+    return encode_size_struct2(NULL, term, TERM_TO_BINARY_DFLAGS, NULL)
 	+ 1 /* VERSION_MAGIC */;
 }
 
-void erts_encode_dist_ext(Eterm term, byte **ext, Uint32 flags, ErtsAtomCacheMap *acmp)
+/*
+ * If refs is non-NULL, large binaries are added to refs instead of
+ * being copied; refs must have room for them.
+ */
+void erts_encode_dist_ext(Eterm term, byte **ext, Uint32 flags,
+			  ErtsAtomCacheMap *acmp, ErtsDistBinRefs *refs)
 {
     byte *ep = *ext;
 #ifndef ERTS_DEBUG_USE_DIST_SEP
     if (!(flags & DFLAG_DIST_HDR_ATOM_CACHE))
 #endif
 	*ep++ = VERSION_MAGIC;
-    ep = enc_term(acmp, term, ep, flags);
+    ep = enc_term(acmp, term, ep, flags, refs);
     if (!ep)
 	erl_exit(ERTS_ABORT_EXIT,
 		 "%s:%d:erts_encode_dist_ext(): Internal data structure error\n",
@@ -485,7 +497,7 @@ void erts_encode_ext(Eterm term, byte **ext)
 {
     byte *ep = *ext;
     *ep++ = VERSION_MAGIC;
-    ep = enc_term(NULL, term, ep, TERM_TO_BINARY_DFLAGS);
+    ep = enc_term(NULL, term, ep, TERM_TO_BINARY_DFLAGS, NULL);
     if (!ep)
 	erl_exit(ERTS_ABORT_EXIT,
 		 "%s:%d:erts_encode_ext(): Internal data structure error\n",
@@ -505,7 +517,8 @@ erts_make_dist_ext_copy(ErtsDistExternal *edep, Uint xsize)
     dist_ext_sz = ERTS_DIST_EXT_SIZE(edep);
     ASSERT(edep->ext_endp && edep->extp);
     ASSERT(edep->ext_endp >= edep->extp);
-    ext_sz = edep->ext_endp - edep->extp;
+    /* If the data is in a binary, the copy refers to the binary */
+    ext_sz = edep->bin ? 0 : edep->ext_endp - edep->extp;
 
     align_sz = ERTS_WORD_ALIGN_PAD_SZ(dist_ext_sz + ext_sz);
 
@@ -517,13 +530,24 @@ erts_make_dist_ext_copy(ErtsDistExternal *edep, Uint xsize)
     ep += dist_ext_sz;
     if (new_edep->dep)
 	erts_refc_inc(&new_edep->dep->refc, 1);
+    new_edep->heap_size = -1;
+    if (new_edep->bin) {
+	erts_refc_inc(&new_edep->bin->refc, 2);
+	return new_edep;
+    }
     new_edep->extp = ep;
     new_edep->ext_endp = ep + ext_sz;
-    new_edep->heap_size = -1;
     sys_memcpy((void *) ep, (void *) edep->extp, ext_sz);
     return new_edep;
 }
 
+void
+erts_deref_dist_ext_bin(Binary *bin)
+{
+    if (erts_refc_dectest(&bin->refc, 0) == 0)
+	erts_bin_free(bin);
+}
+
 int
 erts_prepare_dist_ext(ErtsDistExternal *edep,
 		      byte *ext,
@@ -545,6 +569,7 @@ erts_prepare_dist_ext(ErtsDistExternal *edep,
 
     edep->heap_size = -1;
     edep->ext_endp = ext+size;
+    edep->bin = NULL;
 
     if (size < 2)
 	ERTS_EXT_FAIL;
@@ -914,6 +939,7 @@ BIF_RETTYPE erts_debug_dist_ext_to_term_2(BIF_ALIST_2)
 
     ede.flags = ERTS_DIST_EXT_ATOM_TRANS_TAB;
     ede.dep = NULL;
+    ede.bin = NULL;
     ede.heap_size = -1;
     
     if (is_not_tuple(BIF_ARG_1))
@@ -1151,7 +1177,7 @@ erts_term_to_binary(Process* p, Eterm Term, int level, Uint flags)
     size_t real_size;
     byte* endp;
 
-    size = encode_size_struct2(NULL, Term, flags) + 1 /* VERSION_MAGIC */;
+    size = encode_size_struct2(NULL, Term, flags, NULL) + 1 /* VERSION_MAGIC */;
 
     if (level != 0) {
 	byte buf[256];
@@ -1163,7 +1189,7 @@ erts_term_to_binary(Process* p, Eterm Term, int level, Uint flags)
 	    bytes = erts_alloc(ERTS_ALC_T_TMP, size);
 	}
 
-	if ((endp = enc_term(NULL, Term, bytes, flags))
+	if ((endp = enc_term(NULL, Term, bytes, flags, NULL))
 	    == NULL) {
 	    erl_exit(1, "%s, line %d: bad term: %x\n",
 		     __FILE__, __LINE__, Term);
@@ -1208,7 +1234,7 @@ erts_term_to_binary(Process* p, Eterm Term, int level, Uint flags)
 	bin = new_binary(p, (byte *)NULL, size);
 	bytes = binary_bytes(bin);
 	bytes[0] = VERSION_MAGIC;
-	if ((endp = enc_term(NULL, Term, bytes+1, flags))	
+	if ((endp = enc_term(NULL, Term, bytes+1, flags, NULL))	
 	    == NULL) {
 	    erl_exit(1, "%s, line %d: bad term: %x\n",
 		     __FILE__, __LINE__, Term);
@@ -1387,8 +1413,34 @@ dec_pid(ErtsDistExternal *edep, Eterm** hpp, byte* ep, ErlOffHeap* off_heap, Ete
 #define ENC_PATCH_FUN_SIZE ((Eterm) 2)
 #define ENC_LAST_ARRAY_ELEMENT ((Eterm) 3)
 
+/*
+ * Is obj a binary to send by reference? It has to be a large refc
+ * binary, byte aligned, and not writable (the data of a writable
+ * binary may move).
+ */
+static ERTS_INLINE ProcBin *
+dist_bin_ref(ErtsDistBinRefs *refs, Eterm obj, Uint *offsp)
+{
+    Eterm real_bin;
+    Uint bitoffs;
+    Uint bitsize;
+    ProcBin *pb;
+
+    if (!refs || binary_size(obj) < ERTS_DIST_BIN_REF_LIMIT)
+	return NULL;
+    ERTS_GET_REAL_BIN(obj, real_bin, *offsp, bitoffs, bitsize);
+    if (bitoffs != 0 || bitsize != 0
+	|| thing_subtag(*binary_val(real_bin)) != REFC_BINARY_SUBTAG)
+	return NULL;
+    pb = (ProcBin *) binary_val(real_bin);
+    if (pb->flags || (pb->val->flags & BIN_FLAG_MAGIC))
+	return NULL;
+    return pb;
+}
+
 static byte*
-enc_term(ErtsAtomCacheMap *acmp, Eterm obj, byte* ep, Uint32 dflags)
+enc_term(ErtsAtomCacheMap *acmp, Eterm obj, byte* ep, Uint32 dflags,
+	 ErtsDistBinRefs *refs)
 {
     DECLARE_ESTACK(s);
     Uint n;
@@ -1601,7 +1653,24 @@ enc_term(ErtsAtomCacheMap *acmp, Eterm obj, byte* ep, Uint32 dflags)
 		Uint bitoffs;
 		Uint bitsize;
 		byte* bytes;
+		Uint offs;
+		ProcBin* pb;
 
+		if ((pb = dist_bin_ref(refs, obj, &offs)) != NULL) {
+		    /* The data is sent from the binary itself */
+		    ErtsDistBinRef *rp = &refs->ref[refs->no++];
+		    *ep++ = BINARY_EXT;
+		    j = binary_size(obj);
+		    put_int32(j, ep);
+		    ep += 4;
+		    erts_refc_inc(&pb->val->refc, 2);
+		    rp->ext_pos = ep;
+		    rp->bin = pb->val;
+		    rp->bytes = pb->bytes + offs;
+		    rp->size = j;
+		    refs->size += j;
+		    break;
+		}
 		ERTS_GET_BINARY_BYTES(obj, bytes, bitoffs, bitsize);
 		if (bitsize == 0) {
 		    /* Plain old byte-sized binary. */
@@ -1647,7 +1716,7 @@ enc_term(ErtsAtomCacheMap *acmp, Eterm obj, byte* ep, Uint32 dflags)
 		    *ep++ = EXPORT_EXT;
 		    ep = enc_atom(acmp, exp->code[0], ep, dflags);
 		    ep = enc_atom(acmp, exp->code[1], ep, dflags);
-		    ep = enc_term(acmp, make_small(exp->code[2]), ep, dflags);
+		    ep = enc_term(acmp, make_small(exp->code[2]), ep, dflags, NULL);
 		} else {
 		    /* Tag, arity */
 		    *ep++ = SMALL_TUPLE_EXT;
@@ -1683,8 +1752,8 @@ enc_term(ErtsAtomCacheMap *acmp, Eterm obj, byte* ep, Uint32 dflags)
 		    put_int32(funp->num_free, ep);
 		    ep += 4;
 		    ep = enc_atom(acmp, funp->fe->module, ep, dflags);
-		    ep = enc_term(acmp, make_small(funp->fe->old_index), ep, dflags);
-		    ep = enc_term(acmp, make_small(funp->fe->old_uniq), ep, dflags);
+		    ep = enc_term(acmp, make_small(funp->fe->old_index), ep, dflags, NULL);
+		    ep = enc_term(acmp, make_small(funp->fe->old_uniq), ep, dflags, NULL);
 		    ep = enc_pid(acmp, funp->creator, ep, dflags);
 
 		fun_env:
@@ -2119,6 +2188,28 @@ dec_term(ErtsDistExternal *edep, Eterm** hpp, byte* ep, ErlOffHeap* off_heap, Et
 		    hp += heap_bin_size(n);
 		    sys_memcpy(hb->data, ep, n);
 		    *objp = make_binary(hb);
+		} else if (edep && edep->bin && n >= ERTS_DIST_BIN_REF_LIMIT
+			   && n >= (edep->bin->orig_size
+				    - edep->bin->orig_size/4)) { /* >=75% */
+		    /*
+		     * Refers to the data in the binary that it came in.
+		     * Only done when it is most of that binary, since
+		     * keeping the binary keeps all of it.
+		     */
+		    ProcBin* pb = (ProcBin *) hp;
+		    ASSERT((byte *) edep->bin->orig_bytes <= ep
+			   && ep + n <= ((byte *) edep->bin->orig_bytes
+					 + edep->bin->orig_size));
+		    erts_refc_inc(&edep->bin->refc, 2);
+		    pb->thing_word = HEADER_PROC_BIN;
+		    pb->size = n;
+		    pb->next = off_heap->mso;
+		    off_heap->mso = pb;
+		    pb->val = edep->bin;
+		    pb->bytes = ep;
+		    pb->flags = 0;
+		    hp += PROC_BIN_SIZE;
+		    *objp = make_binary(pb);
 		} else {
 		    Binary* dbin = erts_bin_nrml_alloc(n);
 		    ProcBin* pb;
@@ -2420,7 +2511,8 @@ dec_term(ErtsDistExternal *edep, Eterm** hpp, byte* ep, ErlOffHeap* off_heap, Et
    (except for cached atoms) */
 
 static Uint
-encode_size_struct2(ErtsAtomCacheMap *acmp, Eterm obj, unsigned dflags)
+encode_size_struct2(ErtsAtomCacheMap *acmp, Eterm obj, unsigned dflags,
+		    ErtsDistBinRefs *refs)
 {
     DECLARE_ESTACK(s);
     Uint m, i, arity;
@@ -2506,19 +2598,22 @@ encode_size_struct2(ErtsAtomCacheMap *acmp, Eterm obj, unsigned dflags)
 	    break;
 	case PID_DEF:
 	case EXTERNAL_PID_DEF:
-	    result += (1 + encode_size_struct2(acmp, pid_node_name(obj), dflags) +
+	    result += (1 + encode_size_struct2(acmp, pid_node_name(obj),
+						 dflags, NULL) +
 		       4 + 4 + 1);
 	    break;
 	case REF_DEF:
 	case EXTERNAL_REF_DEF:
 	    ASSERT(dflags & DFLAG_EXTENDED_REFERENCES);
 	    i = ref_no_of_numbers(obj);
-	    result += (1 + 2 + encode_size_struct2(acmp, ref_node_name(obj), dflags) +
+	    result += (1 + 2 + encode_size_struct2(acmp, ref_node_name(obj),
+						     dflags, NULL) +
 		       1 + 4*i);
 	    break;
 	case PORT_DEF:
 	case EXTERNAL_PORT_DEF:
-	    result += (1 + encode_size_struct2(acmp, port_node_name(obj), dflags) +
+	    result += (1 + encode_size_struct2(acmp, port_node_name(obj),
+						 dflags, NULL) +
 		      4 + 1);
 	    break;
 	case LIST_DEF:
@@ -2552,6 +2647,16 @@ encode_size_struct2(ErtsAtomCacheMap *acmp, Eterm obj, unsigned dflags)
 	    }
 	    break;
 	case BINARY_DEF:
+	    {
+		Uint offs;
+		if (dist_bin_ref(refs, obj, &offs)) {
+		    /* Only the header; the data is sent from the binary */
+		    result += 1 + 4;
+		    refs->no++;
+		    refs->size += binary_size(obj);
+		    break;
+		}
+	    }
 	    result += 1 + 4 + binary_size(obj) +
 		5;			/* For unaligned binary */
 	    break;
@@ -2562,8 +2667,8 @@ encode_size_struct2(ErtsAtomCacheMap *acmp, Eterm obj, unsigned dflags)
 		if ((dflags & DFLAG_NEW_FUN_TAGS) != 0) {
 		    result += 20+1+1+4;	/* New ID + Tag */
 		    result += 4; /* Length field (number of free variables */
-		    result += encode_size_struct2(acmp, funp->creator, dflags);
-		    result += encode_size_struct2(acmp, funp->fe->module, dflags);
+		    result += encode_size_struct2(acmp, funp->creator, dflags, NULL);
+		    result += encode_size_struct2(acmp, funp->fe->module, dflags, NULL);
 		    result += 2 * (1+4);	/* Index, Uniq */
 		} else {
 		    /*
@@ -2604,9 +2709,9 @@ encode_size_struct2(ErtsAtomCacheMap *acmp, Eterm obj, unsigned dflags)
 	    {
 		Export* ep = (Export *) (export_val(obj))[1];
 		result += 1;
-		result += encode_size_struct2(acmp, ep->code[0], dflags);
-		result += encode_size_struct2(acmp, ep->code[1], dflags);
-		result += encode_size_struct2(acmp, make_small(ep->code[2]), dflags);
+		result += encode_size_struct2(acmp, ep->code[0], dflags, NULL);
+		result += encode_size_struct2(acmp, ep->code[1], dflags, NULL);
+		result += encode_size_struct2(acmp, make_small(ep->code[2]), dflags, NULL);
 	    }
 	    break;
 
@@ -53,6 +53,8 @@
 #define FUN_EXT           'u'
 
 #define DIST_HEADER       'D'
+#define DIST_FRAG_HEADER  'E'
+#define DIST_FRAG_CONT    'F'
 #define ATOM_CACHE_REF    'R'
 #define COMPRESSED        'P'
 
@@ -104,10 +106,19 @@ typedef struct {
 
 #define ERTS_DIST_EXT_CON_ID(DIST_EXTP) \
   ((DIST_EXTP)->flags & ERTS_DIST_EXT_CON_ID_MASK)
+
+/*
+ * Binaries at least this large are sent by reference to the binary
+ * rather than copied into the output buffer. At the receiving end, a
+ * binary that is most of the data it is received in refers to it.
+ */
+#define ERTS_DIST_BIN_REF_LIMIT (16*1024)
+
 typedef struct {
     DistEntry *dep;
     byte *extp;
     byte *ext_endp;
+    struct binary *bin;		/* The data is in bin, if non-NULL */
     Sint heap_size;
     Uint32 flags;
     ErtsAtomTranslationTable attab;
@@ -142,8 +153,10 @@ Uint erts_encode_ext_dist_header_size(ErtsAtomCacheMap *);
 Uint erts_encode_ext_dist_header_size(ErtsAtomCacheMap *);
 byte *erts_encode_ext_dist_header_setup(byte *, ErtsAtomCacheMap *);
 byte *erts_encode_ext_dist_header_finalize(byte *, ErtsAtomCache *);
-Uint erts_encode_dist_ext_size(Eterm, Uint32, ErtsAtomCacheMap *);
-void erts_encode_dist_ext(Eterm, byte **, Uint32, ErtsAtomCacheMap *);
+Uint erts_encode_dist_ext_size(Eterm, Uint32, ErtsAtomCacheMap *,
+			       ErtsDistBinRefs *);
+void erts_encode_dist_ext(Eterm, byte **, Uint32, ErtsAtomCacheMap *,
+			  ErtsDistBinRefs *);
 
 Uint erts_encode_ext_size(Eterm);
 void erts_encode_ext(Eterm, byte **);
@@ -154,6 +167,7 @@ ERTS_GLB_INLINE void erts_peek_dist_header(ErtsDistHeaderPeek *, byte *, Uint);
 ERTS_GLB_INLINE void erts_free_dist_ext_copy(ErtsDistExternal *);
 ERTS_GLB_INLINE void *erts_dist_ext_trailer(ErtsDistExternal *);
 ErtsDistExternal *erts_make_dist_ext_copy(ErtsDistExternal *, Uint);
+void erts_deref_dist_ext_bin(struct binary *);
 void *erts_dist_ext_trailer(ErtsDistExternal *);
 void erts_destroy_dist_ext_copy(ErtsDistExternal *);
 int erts_prepare_dist_ext(ErtsDistExternal *, byte *, Uint,
@@ -194,14 +208,19 @@ erts_free_dist_ext_copy(ErtsDistExternal *edep)
 {
     if (edep->dep)
 	erts_deref_dist_entry(edep->dep);
+    if (edep->bin)
+	erts_deref_dist_ext_bin(edep->bin);
     erts_free(ERTS_ALC_T_EXT_TERM_DATA, edep);
 }
 
 ERTS_GLB_INLINE void *
 erts_dist_ext_trailer(ErtsDistExternal *edep)
 {
-    void *res = (void *) (edep->ext_endp
-			  + ERTS_WORD_ALIGN_PAD_SZ(edep->ext_endp));
+    /* A copy that refers to a binary has no data of its own */
+    byte *endp = (edep->bin
+		  ? ((byte *) edep) + ERTS_DIST_EXT_SIZE(edep)
+		  : edep->ext_endp);
+    void *res = (void *) (endp + ERTS_WORD_ALIGN_PAD_SZ(endp));
     ASSERT((((Uint) res) % sizeof(Uint)) == 0);
     return res;
 }
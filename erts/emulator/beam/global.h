@@ -41,6 +41,7 @@ typedef struct port Port;
 #include "erl_port_task.h"
 
 #define ERTS_MAX_NO_OF_ASYNC_THREADS 1024
+#define ERTS_MAX_NO_OF_GC_THREADS 1024
 extern int erts_async_max_threads;
 #define ERTS_ASYNC_THREAD_MIN_STACK_SIZE 16	/* Kilo words */
 #define ERTS_ASYNC_THREAD_MAX_STACK_SIZE 8192	/* Kilo words */
@@ -124,8 +125,20 @@ typedef struct ErtsXPortsList_ ErtsXPortsList;
  * port table.
  *
  * /rickard
+ *
+ * The command queue (cmdq_*) is protected by the state_lck. When port
+ * parallelism (+spp) is enabled port_command/2 only enqueues the command
+ * there without taking the port lock; the queue is passed on to the
+ * driver by the next thread holding the port lock.
+ *
+ * The async queue (async_*) is also protected by the state_lck. Async
+ * threads put finished driver_async() jobs there, and an async port
+ * task delivers them to the driver's ready_async callback.
  */
 
+typedef struct ErtsPortCmd_ ErtsPortCmd;
+typedef struct _erl_async ErlAsync;
+
 struct port {
     ErtsPortTaskSched sched;
     ErtsPortTaskHandle timeout_task;
@@ -134,7 +147,13 @@ struct port {
     erts_smp_mtx_t *lock;
     ErtsXPortsList *xports;
     erts_smp_atomic_t run_queue;
-    erts_smp_spinlock_t state_lck;  /* protects: id, status, snapshot */
+    erts_smp_spinlock_t state_lck;  /* protects: id, status, snapshot,
+				       cmdq_*, async_* */
+    ErtsPortCmd *cmdq_first;	/* Commands not yet passed to the driver */
+    ErtsPortCmd *cmdq_last;
+    Uint cmdq_bytes;		/* Bytes in the command queue */
+    ErlAsync *async_first;	/* Finished async jobs not yet delivered */
+    ErlAsync *async_last;
 #endif
     Eterm id;                   /* The Port id of this port */
     Eterm connected;            /* A connected process */
@@ -156,6 +175,7 @@ struct port {
 
     ErlIOQueue ioq;              /* driver accessible i/o queue */
     DistEntry *dist_entry;       /* Dist entry used in DISTRIBUTION */
+    ErtsDistStripe *dist_stripe; /* Set if an extra connection of it */
     char *name;		         /* String used in the open */
     erts_driver_t* drv_ptr;
     long drv_data;
@@ -411,6 +431,28 @@ typedef struct {
 #define BIN_FLAG_USR1       2 /* Reserved for use by different modules too mark */
 #define BIN_FLAG_USR2       4 /*  certain binaries as special (used by ets) */
 #define BIN_FLAG_DRV        8
+#define BIN_FLAG_EXTERN    16 /* Magic binary with its data elsewhere */
+
+/*
+ * Magic data of a BIN_FLAG_EXTERN binary, see driver_alloc_extern_binary().
+ */
+typedef struct {
+    byte *data;
+    Uint size;
+    void (*release)(char *, unsigned long);
+} ErtsExternBinData;
+
+#define ERTS_EXTERN_BIN_DATA(BP) \
+  ((ErtsExternBinData *) ERTS_MAGIC_BIN_DATA((BP)))
+#define ERTS_BIN_BYTES(BP) \
+  ((BP)->flags & BIN_FLAG_EXTERN \
+   ? ERTS_EXTERN_BIN_DATA((BP))->data \
+   : (byte *) (BP)->orig_bytes)
+#define ERTS_BIN_SIZE(BP) \
+  ((BP)->flags & BIN_FLAG_EXTERN \
+   ? ERTS_EXTERN_BIN_DATA((BP))->size \
+   : (Uint) (BP)->orig_size)
+#define ERTS_DRV_BIN_BYTES(DB) ERTS_BIN_BYTES(ErlDrvBinary2Binary((DB)))
 
 /*
  * This structure represents one type of a binary in a process.
@@ -716,6 +758,9 @@ do {									\
   (ERTS_PORT_SFLGS_INVALID_LOOKUP					\
    | ERTS_PORT_SFLG_PORT_BUSY						\
    | ERTS_PORT_SFLG_DISTRIBUTION)
+#define ERTS_PORT_SFLGS_INVALID_CMDQ_LOOKUP				\
+  (ERTS_PORT_SFLGS_INVALID_TRACER_LOOKUP				\
+   | ERTS_PORT_SFLG_EXITING)
 
 /* binary.c */
 
@@ -755,6 +800,7 @@ Eterm* find_function_from_pc(Eterm* pc);
 Eterm erts_module_info_0(Process* p, Eterm module);
 Eterm erts_module_info_1(Process* p, Eterm module, Eterm what);
 Eterm erts_make_stub_module(Process* p, Eterm Mod, Eterm Beam, Eterm Info);
+void erts_cleanup_literal_refs(Process* p);
 
 /* break.c */
 void init_break_handler(void);
@@ -898,10 +944,12 @@ extern void erts_delete_nodes_monitors(Process *, ErtsProcLocks);
 extern Eterm erts_monitor_nodes(Process *, Eterm, Eterm);
 extern Eterm erts_processes_monitoring_nodes(Process *);
 extern int erts_do_net_exits(DistEntry*, Eterm);
+extern void erts_do_dist_stripe_exit(Port *);
 extern int distribution_info(int, void *);
 extern int is_node_name_atom(Eterm a);
 
-extern int erts_net_message(Port *, DistEntry *, byte *, int, byte *, int);
+extern int erts_net_message(Port *, DistEntry *, byte *, int, byte *, int,
+			    Binary *);
 
 extern void init_dist(void);
 extern int stop_dist(void);
@@ -967,12 +1015,14 @@ typedef struct {
     Uint reclaimed;
 } ErtsGCInfo;
 
+extern int erts_no_gc_threads;
+
 void erts_gc_info(ErtsGCInfo *gcip);
 void erts_init_gc(void);
 int erts_garbage_collect(Process*, int, Eterm*, int);
 void erts_garbage_collect_hibernate(Process* p);
 Eterm erts_gc_after_bif_call(Process* p, Eterm result, Eterm* regs, Uint arity);
-void erts_garbage_collect_literals(Process* p, Eterm* literals, Uint lit_size);
+int erts_proc_refers_to_area(Process* p, char* area, Uint area_size);
 Uint erts_next_heap_size(Uint, Uint);
 Eterm erts_heap_sizes(Process* p);
 
@@ -1013,16 +1063,40 @@ void erts_do_exit_port(Port *, Eterm, Eterm);
 void erts_port_command(Process *, Eterm, Port *, Eterm);
 Eterm erts_port_control(Process*, Port*, Uint, Eterm);
 int erts_write_to_port(Eterm caller_id, Port *p, Eterm list);
+extern int erts_port_parallelism;
+#ifdef ERTS_SMP
+int erts_port_enqueue_command(Eterm caller_id, Eterm id, Eterm list);
+int erts_port_flush_commands(Port *);
+void erts_port_free_commands(Port *);
+/* Pass commands queued by other processes on to the driver first */
+#define ERTS_SMP_PORT_FLUSH_COMMANDS(P) \
+  ((void) ((P)->cmdq_first ? erts_port_flush_commands((P)) : 0))
+/* A driver may fail on a flushed command; its drv_data is then gone */
+#define ERTS_SMP_PORT_FLUSH_KILLED(P) \
+  ((P)->status & (ERTS_PORT_SFLGS_INVALID_LOOKUP | ERTS_PORT_SFLG_EXITING))
+#else
+#define ERTS_SMP_PORT_FLUSH_COMMANDS(P)
+#define ERTS_SMP_PORT_FLUSH_KILLED(P) 0
+#endif
 void print_port_info(int, void *, int);
 void erts_raw_port_command(Port*, byte*, Uint);
 void driver_report_exit(int, int);
 LineBuf* allocate_linebuf(int);
 int async_ready(Port *, void*);
+Eterm erts_async_statistics(Process *);
+#ifdef ERTS_SMP
+int erts_async_deliver(Port *);
+void erts_async_free_ready(Port *);
+#endif
 Sint erts_test_next_port(int, Uint);
 ErtsPortNames *erts_get_port_names(Eterm);
 void erts_free_port_names(ErtsPortNames *);
 Uint erts_port_ioq_size(Port *pp);
 void erts_stale_drv_select(Eterm, ErlDrvEvent, int, int);
+#ifdef ERTS_SMP
+/* Defined in sys.c; called when an I/O port task has been executed */
+void erts_sys_io_task_executed(Eterm, ErlDrvEvent, int);
+#endif
 void erts_port_cleanup(Port *);
 void erts_fire_port_monitor(Port *prt, Eterm ref);
 #ifdef ERTS_SMP
@@ -1421,8 +1495,8 @@ Eterm
 erts_bld_atom_uint_2tup_list(Uint **hpp, Uint *szp,
 			     Sint length, Eterm atoms[], Uint uints[]);
 Eterm
-erts_bld_atom_2uint_3tup_list(Uint **hpp, Uint *szp, Sint length,
-			      Eterm atoms[], Uint uints1[], Uint uints2[]);
+erts_bld_atom_3uint_4tup_list(Uint **hpp, Uint *szp, Sint length, Eterm atoms[],
+			      Uint uints1[], Uint uints2[], Uint uints3[]);
 
 Eterm store_external_or_ref_in_proc_(Process *, Eterm);
 Eterm store_external_or_ref_(Uint **, ExternalThing **, Eterm);
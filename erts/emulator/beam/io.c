@@ -61,6 +61,7 @@ erts_smp_atomic_t erts_bytes_in;	/* No bytes gotten into the system */
 
 Uint erts_max_ports;
 Uint erts_port_tab_index_mask;
+int erts_port_parallelism;	/* Asynchronous port_command/2 (+spp) */
 
 const ErlDrvTermData driver_term_nil = (ErlDrvTermData)NIL;
 
@@ -391,6 +392,7 @@ setup_port(Port* prt, Eterm pid, erts_driver_t *driver,
     prt->bytes_in = 0;
     prt->bytes_out = 0;
     prt->dist_entry = NULL;
+    prt->dist_stripe = NULL;
     prt->reg = NULL;
 #ifdef ERTS_SMP
     prt->ptimer = NULL;
@@ -1025,7 +1027,7 @@ io_list_vec_len(Eterm obj, int* vsize, int* csize,
 #define SMALL_WRITE_VEC  16
 
 
-/* write data to a port */
+/* write data to a port; returns -1 if the port died flushing commands */
 int erts_write_to_port(Eterm caller_id, Port *p, Eterm list)
 {
     char *buf;
@@ -1036,6 +1038,10 @@ int erts_write_to_port(Eterm caller_id, Port *p, Eterm list)
     ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(p));
     ERTS_SMP_CHK_NO_PROC_LOCKS;
 
+    ERTS_SMP_PORT_FLUSH_COMMANDS(p);
+    if (ERTS_SMP_PORT_FLUSH_KILLED(p))
+	return -1;
+
     p->caller = caller_id;
     if (drv->outputv != NULL) {
 	int vsize;
@@ -1165,6 +1171,239 @@ int erts_write_to_port(Eterm caller_id, Port *p, Eterm list)
     }
 }
 
+#ifdef ERTS_SMP
+
+/*
+ * Asynchronous port commands (port parallelism, +spp).
+ *
+ * port_command/2 converts the io-list into an I/O vector (referring
+ * to large binaries instead of copying them) and puts it on the command
+ * queue of the port without taking the port lock. The driver gets the
+ * queued commands, in order, from a port task or before any other
+ * operation is made on the port by a thread holding the port lock.
+ *
+ * Flow control is by the size of the queue; when it has grown to
+ * ERTS_PORT_CMDQ_HIGH_LIMIT bytes or the port is busy, senders take the
+ * synchronous path, i.e. block on the port lock or get suspended.
+ */
+
+#define ERTS_PORT_CMDQ_HIGH_LIMIT (64*1024)
+
+struct ErtsPortCmd_ {
+    ErtsPortCmd *next;
+    Eterm caller;
+    ErlDrvBinary *cbin;		/* Data copied from the io-list */
+    ErlIOVec ev;
+    SysIOVec iov[1];		/* ev.iov; ev.binv follows */
+};
+
+#define ERTS_PORT_CMD_SIZE(VSIZE) \
+  (sizeof(ErtsPortCmd) - sizeof(SysIOVec) \
+   + (VSIZE)*(sizeof(SysIOVec) + sizeof(ErlDrvBinary *)))
+
+static void
+port_cmd_free(ErtsPortCmd *cmd)
+{
+    int i;
+    for (i = 1; i < cmd->ev.vsize; i++) {
+	if (cmd->ev.binv[i])
+	    driver_free_binary(cmd->ev.binv[i]);
+    }
+    driver_free_binary(cmd->cbin);
+    erts_free(ERTS_ALC_T_PORT_CMD, (void *) cmd);
+}
+
+/* Returns NULL if list is not an io-list */
+static ErtsPortCmd *
+port_cmd_create(Eterm caller_id, Eterm list, int outputv)
+{
+    ErtsPortCmd *cmd;
+    int size, vsize, csize, pvsize, pcsize, blimit, i;
+
+    if (outputv) {
+	if ((size = io_list_vec_len(list, &vsize, &csize,
+				    ERL_SMALL_IO_BIN_LIMIT,
+				    &pvsize, &pcsize)) < 0) {
+	    return NULL;
+	}
+	/* Same packing of small binaries as in erts_write_to_port() */
+	vsize++;
+	if (vsize <= SMALL_WRITE_VEC) {
+	    blimit = 0;
+	} else {
+	    vsize = pvsize + 1;
+	    csize = pcsize;
+	    blimit = ERL_SMALL_IO_BIN_LIMIT;
+	}
+    } else {
+	if ((size = io_list_len(list)) < 0)
+	    return NULL;
+	vsize = 2;
+	csize = size;
+	blimit = 0;
+    }
+
+    cmd = (ErtsPortCmd *) erts_alloc(ERTS_ALC_T_PORT_CMD,
+				     ERTS_PORT_CMD_SIZE(vsize));
+    cmd->next = NULL;
+    cmd->caller = caller_id;
+    cmd->cbin = driver_alloc_binary(csize);
+    if (!cmd->cbin)
+	erts_alloc_enomem(ERTS_ALC_T_DRV_BINARY, sizeof(Binary) + csize);
+
+    /* Element 0 is for driver usage to add header block */
+    cmd->ev.iov = cmd->iov;
+    cmd->ev.binv = (ErlDrvBinary **) &cmd->iov[vsize];
+    cmd->ev.iov[0].iov_base = NULL;
+    cmd->ev.iov[0].iov_len = 0;
+    cmd->ev.binv[0] = NULL;
+    cmd->ev.size = size;
+
+    if (outputv) {
+	cmd->ev.vsize = io_list_to_vec(list, cmd->ev.iov+1, cmd->ev.binv+1,
+				       cmd->cbin, blimit) + 1;
+    } else {
+	(void) io_list_to_buf(list, cmd->cbin->orig_bytes, size);
+	cmd->ev.iov[1].iov_base = cmd->cbin->orig_bytes;
+	cmd->ev.iov[1].iov_len = size;
+	cmd->ev.binv[1] = cmd->cbin;
+	cmd->ev.vsize = 2;
+    }
+
+    /* The binaries have to stay alive until the driver has been called */
+    for (i = 1; i < cmd->ev.vsize; i++) {
+	if (cmd->ev.binv[i])
+	    driver_binary_inc_refc(cmd->ev.binv[i]);
+    }
+    return cmd;
+}
+
+/*
+ * Enqueue list as a command from caller_id to the port id.
+ * Returns 0 if enqueued, and non-zero if the command has to be
+ * passed synchronously (the port is busy, has too much queued, is
+ * not a valid port, or list is not an io-list; errors are reported
+ * by the synchronous path).
+ */
+int
+erts_port_enqueue_command(Eterm caller_id, Eterm id, Eterm list)
+{
+    Port *p;
+    ErtsPortCmd *cmd;
+    int outputv, schedule;
+
+    if (is_not_internal_port(id))
+	return 1;
+
+    p = &erts_port[internal_port_index(id)];
+
+    erts_smp_port_state_lock(p);
+    if (ERTS_INVALID_PORT_OPT(p, id, ERTS_PORT_SFLGS_INVALID_CMDQ_LOOKUP)
+	|| p->cmdq_bytes >= ERTS_PORT_CMDQ_HIGH_LIMIT
+	|| (p->trace_flags & F_TRACE_SCHED_PORTS)) {
+	erts_smp_port_state_unlock(p);
+	return 1;
+    }
+    outputv = p->drv_ptr->outputv != NULL;
+    erts_smp_port_state_unlock(p);
+
+    cmd = port_cmd_create(caller_id, list, outputv);
+    if (!cmd)
+	return 1;
+
+    erts_smp_port_state_lock(p);
+    if (ERTS_INVALID_PORT_OPT(p, id, ERTS_PORT_SFLGS_INVALID_CMDQ_LOOKUP)) {
+	erts_smp_port_state_unlock(p);
+	port_cmd_free(cmd);
+	return 1;
+    }
+    schedule = !p->cmdq_first;
+    if (schedule)
+	p->cmdq_first = cmd;
+    else
+	p->cmdq_last->next = cmd;
+    p->cmdq_last = cmd;
+    p->cmdq_bytes += cmd->ev.size;
+    erts_smp_port_state_unlock(p);
+
+    /*
+     * If the port dies before the task is executed, the queue is
+     * freed by terminate_port().
+     */
+    if (schedule)
+	(void) erts_port_task_schedule(id, NULL, ERTS_PORT_TASK_COMMAND,
+				       (ErlDrvEvent) -1, NULL);
+    return 0;
+}
+
+/*
+ * Pass all queued commands on to the driver. Commands queued to a
+ * port that has started to exit or close are dropped. Returns the
+ * number of commands passed on.
+ */
+int
+erts_port_flush_commands(Port *p)
+{
+    ErtsPortCmd *cmd, *next;
+    erts_driver_t *drv;
+    int fpe_was_unmasked;
+    int n = 0;
+
+    ERTS_SMP_LC_ASSERT(erts_lc_is_port_locked(p));
+
+    erts_smp_port_state_lock(p);
+    cmd = p->cmdq_first;
+    p->cmdq_first = p->cmdq_last = NULL;
+    p->cmdq_bytes = 0;
+    erts_smp_port_state_unlock(p);
+
+    for (; cmd; cmd = next) {
+	next = cmd->next;
+	if (!(p->status & (ERTS_PORT_SFLGS_INVALID_LOOKUP
+			   | ERTS_PORT_SFLG_EXITING))) {
+	    drv = p->drv_ptr;
+	    p->caller = cmd->caller;
+	    fpe_was_unmasked = erts_block_fpe();
+	    if (drv->outputv != NULL)
+		(*drv->outputv)((ErlDrvData)p->drv_data, &cmd->ev);
+	    else
+		(*drv->output)((ErlDrvData)p->drv_data,
+			       cmd->ev.iov[1].iov_base,
+			       cmd->ev.iov[1].iov_len);
+	    erts_unblock_fpe(fpe_was_unmasked);
+	    p->caller = NIL;
+	    p->bytes_out += cmd->ev.size;
+	    erts_smp_atomic_add(&erts_bytes_out, cmd->ev.size);
+	    if (p->xports)
+		erts_smp_xports_unlock(p);
+	    ASSERT(!p->xports);
+	    n++;
+	}
+	port_cmd_free(cmd);
+    }
+    return n;
+}
+
+/* Drop queued commands of a terminated port */
+void
+erts_port_free_commands(Port *p)
+{
+    ErtsPortCmd *cmd, *next;
+
+    erts_smp_port_state_lock(p);
+    cmd = p->cmdq_first;
+    p->cmdq_first = p->cmdq_last = NULL;
+    p->cmdq_bytes = 0;
+    erts_smp_port_state_unlock(p);
+
+    for (; cmd; cmd = next) {
+	next = cmd->next;
+	port_cmd_free(cmd);
+    }
+}
+
+#endif /* #ifdef ERTS_SMP */
+
 /* initialize the port array */
 void init_io(void)
 {
@@ -1228,6 +1467,11 @@ void init_io(void)
 	erts_port[i].lock = NULL;
 	erts_port[i].xports = NULL;
 	erts_smp_spinlock_init(&erts_port[i].state_lck, "port_state");
+	erts_port[i].cmdq_first = NULL;
+	erts_port[i].cmdq_last = NULL;
+	erts_port[i].cmdq_bytes = 0;
+	erts_port[i].async_first = NULL;
+	erts_port[i].async_last = NULL;
 #endif
 	erts_port[i].tracer_proc = NIL;
 	erts_port[i].trace_flags = 0;
@@ -1526,7 +1770,7 @@ static void deliver_read_message(Port* prt, Eterm to,
 	pb->flags = 0;
 	hp += PROC_BIN_SIZE;
 
-	ohp->overhead += pb->size / BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+	ohp->overhead += pb->size / sizeof(Eterm);
 	listp = make_binary(pb);
     }
 
@@ -1676,8 +1920,7 @@ deliver_vec_message(Port* prt,			/* Port */
 	    pb->flags = 0;
 	    hp += PROC_BIN_SIZE;
 	    
-	    ohp->overhead += iov->iov_len / BINARY_OVERHEAD_FACTOR /
-		sizeof(Eterm);
+	    ohp->overhead += iov->iov_len / sizeof(Eterm);
 
 	    if (listp == NIL) {  /* compatible with deliver_bin_message */
 		listp = make_binary(pb);
@@ -1715,7 +1958,7 @@ static void deliver_bin_message(Port*  prt,         /* port */
 {
     SysIOVec vec;
 
-    vec.iov_base = bin->orig_bytes+offs;
+    vec.iov_base = (char *) ERTS_DRV_BIN_BYTES(bin) + offs;
     vec.iov_len = len;
     deliver_vec_message(prt, to, hbuf, hlen, &bin, &vec, 1, len);
 }
@@ -1818,6 +2061,12 @@ terminate_port(Port *prt)
 	erts_free(ERTS_ALC_T_PRTSD, prt->psd);
 
     kill_port(prt);
+#ifdef ERTS_SMP
+    /* No more commands or async jobs can be enqueued now that the port
+       is dead */
+    erts_port_free_commands(prt);
+    erts_async_free_ready(prt);
+#endif
 
     /*
      * We don't want to send the closed message until after the
@@ -1986,7 +2235,10 @@ erts_do_exit_port(Port *p, Eterm from, Eterm reason)
 
 
    if ((p->status & ERTS_PORT_SFLG_DISTRIBUTION) && p->dist_entry) {
-       erts_do_net_exits(p->dist_entry, rreason);
+       if (p->dist_stripe)
+	   erts_do_dist_stripe_exit(p);
+       else
+	   erts_do_net_exits(p->dist_entry, rreason);
        erts_deref_dist_entry(p->dist_entry); 
        p->dist_entry = NULL; 
        erts_port_status_band_set(p, ~ERTS_PORT_SFLG_DISTRIBUTION);
@@ -2044,13 +2296,15 @@ void erts_port_command(Process *proc,
 	if ((pid = port->connected) == tp[1]) {
 	    /* PID must be connected */
 	    if (tp[2] == am_close) {
+		ERTS_SMP_PORT_FLUSH_COMMANDS(port);
 		erts_port_status_bor_set(port, ERTS_PORT_SFLG_SEND_CLOSED);
 		erts_do_exit_port(port, pid, am_normal);
 		goto done;
 	    } else if (is_tuple_arity(tp[2], 2)) {
 		tp = tuple_val(tp[2]);
 		if (tp[1] == am_command) {
-		    if (erts_write_to_port(caller_id, port, tp[2]) == 0)
+		    /* A port that died on queued commands drops this one too */
+		    if (erts_write_to_port(caller_id, port, tp[2]) <= 0)
 			goto done;
 		} else if ((tp[1] == am_connect) && is_internal_pid(tp[2])) {
 		    port->connected = tp[2];
@@ -2149,11 +2403,20 @@ erts_port_control(Process* p, Port* prt, Uint command, Eterm iolist)
 	}
     }
 
-    prt->caller = p->id;	/* Internal pid */
-
     erts_smp_proc_unlock(p, ERTS_PROC_LOCK_MAIN);
     ERTS_SMP_CHK_NO_PROC_LOCKS;
 
+    ERTS_SMP_PORT_FLUSH_COMMANDS(prt);
+    if (ERTS_SMP_PORT_FLUSH_KILLED(prt)) {
+	if (must_free) {
+	    erts_free(ERTS_ALC_T_TMP, (void *) to_port);
+	}
+	erts_smp_proc_lock(p, ERTS_PROC_LOCK_MAIN);
+	return THE_NON_VALUE;
+    }
+
+    prt->caller = p->id;	/* Internal pid */
+
     /*
      * Call the port's control routine.
      */
@@ -2208,8 +2471,7 @@ erts_port_control(Process* p, Port* prt, Uint command, Eterm iolist)
 		pb->val = ErlDrvBinary2Binary(dbin);
 		pb->bytes = (byte*) dbin->orig_bytes;
 		pb->flags = 0;
-		MSO(p).overhead += dbin->orig_size
-		    / BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+		MSO(p).overhead += dbin->orig_size / sizeof(Eterm);
 		return make_binary(pb);
 	    }
 	    port_resp = dbin->orig_bytes;
@@ -2775,7 +3037,7 @@ driver_deliver_term(ErlDrvPort port,
 	    b = (ErlDrvBinary*) ptr[0];
 	    size = ptr[1];
 	    offset = ptr[2];
-	    if (!b || size + offset > b->orig_size)
+	    if (!b || size + offset > ERTS_BIN_SIZE(ErlDrvBinary2Binary(b)))
 		ERTS_DDT_FAIL; /* No binary or outside the binary */
 	    need += (size <= ERL_ONHEAP_BIN_LIMIT
 			 ? heap_bin_size(size)
@@ -2947,7 +3209,7 @@ driver_deliver_term(ErlDrvPort port,
 		hbp->thing_word = header_heap_bin(size);
 		hbp->size = size;
 		if (size > 0) {
-		    sys_memcpy((void *) hbp->data, (void *) (((byte*) b->orig_bytes) + offset), size);
+		    sys_memcpy((void *) hbp->data, (void *) (ERTS_DRV_BIN_BYTES(b) + offset), size);
 		}
 		mess = make_binary(hbp);
 	    }
@@ -2959,12 +3221,11 @@ driver_deliver_term(ErlDrvPort port,
 		pb->next = ohp->mso;
 		ohp->mso = pb;
 		pb->val = ErlDrvBinary2Binary(b);
-		pb->bytes = ((byte*) b->orig_bytes) + offset;
+		pb->bytes = ERTS_DRV_BIN_BYTES(b) + offset;
 		pb->flags = 0;
 		mess =  make_binary(pb);
 		hp += PROC_BIN_SIZE;
-		ohp->overhead += pb->size / 
-		    BINARY_OVERHEAD_FACTOR / sizeof(Eterm);
+		ohp->overhead += pb->size / sizeof(Eterm);
 	    }
 	    ptr += 3;
 	    break;
@@ -3001,9 +3262,7 @@ driver_deliver_term(ErlDrvPort port,
 		pbp->val = bp;
 		pbp->bytes = (byte*) bp->orig_bytes;
 		pbp->flags = 0;
-		ohp->overhead += (pbp->size
-				  / BINARY_OVERHEAD_FACTOR
-				  / sizeof(Eterm));
+		ohp->overhead += (pbp->size / sizeof(Eterm));
 		mess = make_binary(pbp);
 	    }
 	    ptr += 2;
@@ -3167,7 +3426,8 @@ int driver_output_binary(ErlDrvPort ix, char* hbuf, int hlen,
 	return erts_net_message(prt,
 				prt->dist_entry,
 				(byte*) hbuf, hlen,
-				(byte*) (bin->orig_bytes+offs), len);
+				ERTS_DRV_BIN_BYTES(bin) + offs, len,
+				ErlDrvBinary2Binary(bin));
     }
     else
 	deliver_bin_message(prt, prt->connected, 
@@ -3203,12 +3463,14 @@ int driver_output2(ErlDrvPort ix, char* hbuf, int hlen, char* buf, int len)
 	    return erts_net_message(prt,
 				    prt->dist_entry,
 				    NULL, 0,
-				    (byte*) hbuf, hlen);
+				    (byte*) hbuf, hlen,
+				    NULL);
 	else
 	    return erts_net_message(prt,
 				    prt->dist_entry,
 				    (byte*) hbuf, hlen,
-				    (byte*) buf, len);
+				    (byte*) buf, len,
+				    NULL);
     }
     else if(prt->status & ERTS_PORT_SFLG_LINEBUF_IO)
 	deliver_linebuf_message(prt, prt->connected, hbuf, hlen, buf, len);
@@ -3361,6 +3623,42 @@ driver_alloc_binary(int size)
     return Binary2ErlDrvBinary(bin);
 }
 
+static void
+extern_binary_destructor(Binary *bin)
+{
+    ErtsExternBinData *xbd = ERTS_EXTERN_BIN_DATA(bin);
+    (*xbd->release)((char *) xbd->data, (unsigned long) xbd->size);
+}
+
+/*
+ * A binary referring to size bytes at data, which the emulator does not
+ * own; release(data, size) is called when the last reference is gone.
+ * The data must not change while referred to, and offsets given with the
+ * binary are from data.
+ */
+ErlDrvBinary*
+driver_alloc_extern_binary(char *data, ErlDrvUInt size,
+			   void (*release)(char *, ErlDrvUInt))
+{
+    Binary* bin;
+    ErtsExternBinData *xbd;
+    Uint bsize = (sizeof(Binary) - 1 + sizeof(ErtsBinaryMagicPart) - 1
+		  + sizeof(ErtsExternBinData));
+
+    bin = erts_alloc_fnf(ERTS_ALC_T_BINARY, bsize);
+    if (!bin)
+	return NULL;
+    bin->flags = BIN_FLAG_MAGIC|BIN_FLAG_EXTERN;
+    bin->orig_size = sizeof(ErtsBinaryMagicPart) - 1 + sizeof(ErtsExternBinData);
+    erts_refc_init(&bin->refc, 1);
+    ERTS_MAGIC_BIN_DESTRUCTOR(bin) = extern_binary_destructor;
+    xbd = ERTS_EXTERN_BIN_DATA(bin);
+    xbd->data = (byte *) data;
+    xbd->size = (Uint) size;
+    xbd->release = release;
+    return Binary2ErlDrvBinary(bin);
+}
+
 /* Reallocate space hold by binary */
 
 ErlDrvBinary* driver_realloc_binary(ErlDrvBinary* bin, int size)
@@ -3389,6 +3687,8 @@ ErlDrvBinary* driver_realloc_binary(ErlDrvBinary* bin, int size)
     }
 
     oldbin = ErlDrvBinary2Binary(bin);
+    if (oldbin->flags & BIN_FLAG_EXTERN)
+	return NULL;
     newbin = (Binary *) erts_bin_realloc_fnf(oldbin, size);
     if (!newbin)
 	return NULL;
@@ -3885,7 +4185,7 @@ int driver_enq_bin(ErlDrvPort ix, ErlDrvBinary* bin, int offs, int len)
     ASSERT(len >= 0);
     if (len == 0)
 	return 0;
-    iov.iov_base = bin->orig_bytes + offs;
+    iov.iov_base = (char *) ERTS_DRV_BIN_BYTES(bin) + offs;
     iov.iov_len  = len;
     ev.vsize = 1;
     ev.size = len;
@@ -3918,7 +4218,7 @@ int driver_pushq_bin(ErlDrvPort ix, ErlDrvBinary* bin, int offs, int len)
     ASSERT(len >= 0);
     if (len == 0)
 	return 0;
-    iov.iov_base = bin->orig_bytes + offs;
+    iov.iov_base = (char *) ERTS_DRV_BIN_BYTES(bin) + offs;
     iov.iov_len  = len;
     ev.vsize = 1;
     ev.size = len;
@@ -518,19 +518,21 @@ erts_bld_atom_uint_2tup_list(Uint **hpp, Uint *szp,
 }
 
 Eterm
-erts_bld_atom_2uint_3tup_list(Uint **hpp, Uint *szp, Sint length,
-			      Eterm atoms[], Uint uints1[], Uint uints2[])
+erts_bld_atom_3uint_4tup_list(Uint **hpp, Uint *szp, Sint length, Eterm atoms[],
+			      Uint uints1[], Uint uints2[], Uint uints3[])
 {
     Sint i;
     Eterm res = THE_NON_VALUE;
     if (szp) {
-	*szp += 6*length;
+	*szp += 7*length;
 	i = length;
 	while (--i >= 0) {
 	    if (!IS_USMALL(0, uints1[i]))
 		*szp += BIG_UINT_HEAP_SIZE;
 	    if (!IS_USMALL(0, uints2[i]))
 		*szp += BIG_UINT_HEAP_SIZE;
+	    if (!IS_USMALL(0, uints3[i]))
+		*szp += BIG_UINT_HEAP_SIZE;
 	}
     }
     if (hpp) {
@@ -540,6 +542,7 @@ erts_bld_atom_2uint_3tup_list(Uint **hpp, Uint *szp, Sint length,
 	while (--i >= 0) {
 	    Eterm ui1;
 	    Eterm ui2;
+	    Eterm ui3;
 
 	    if (IS_USMALL(0, uints1[i]))
 		ui1 = make_small(uints1[i]);
@@ -555,8 +558,15 @@ erts_bld_atom_2uint_3tup_list(Uint **hpp, Uint *szp, Sint length,
 		*hpp += BIG_UINT_HEAP_SIZE;
 	    }
 	    
-	    res = CONS(*hpp+4, TUPLE3(*hpp, atoms[i], ui1, ui2), res);
-	    *hpp += 6;
+	    if (IS_USMALL(0, uints3[i]))
+		ui3 = make_small(uints3[i]);
+	    else {
+		ui3 = uint_to_big(uints3[i], *hpp);
+		*hpp += BIG_UINT_HEAP_SIZE;
+	    }
+	    
+	    res = CONS(*hpp+5, TUPLE4(*hpp, atoms[i], ui1, ui2, ui3), res);
+	    *hpp += 7;
 	}
     }
     return res;
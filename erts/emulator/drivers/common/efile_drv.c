@@ -53,6 +53,7 @@
 #define FILE_IPREAD             27
 #define FILE_ALTNAME            28
 #define FILE_READ_LINE          29
+#define FILE_CACHE_INFO         30
 
 /* Return codes */
 
@@ -70,6 +71,7 @@
 
 #define FILE_OPT_DELAYED_WRITE 0
 #define FILE_OPT_READ_AHEAD    1
+#define FILE_OPT_MMAP          2
 
 /* IPREAD variants */
 
@@ -80,6 +82,10 @@
 #define FILE_SEGMENT_READ  (256*1024)
 #define FILE_SEGMENT_WRITE (256*1024)
 
+/* Sequential reads may grow the read-ahead up to this many times
+ * the size given in the read_ahead option */
+#define FILE_READ_AHEAD_SCALE 8
+
 /* Internal */
 
 /* Set to 1 to test having read_ahead implicitly for read_line */ 
@@ -105,6 +111,7 @@
 extern void erl_exit(int n, char *fmt, _DOTS_);
 
 static ErlDrvSysInfo sys_info;
+static ErlDrvTermData am_data;
 
 
 /*#define TRACE 1*/
@@ -195,6 +202,14 @@ enum e_timer {timer_idle, timer_again, timer_write};
 
 struct t_data;
 
+typedef struct {
+    Uint64          read_hits;      /* Reads served from read-ahead */
+    Uint64          read_misses;    /* Reads that had to read the file */
+    Uint64          read_dropped;   /* Read-ahead bytes thrown away */
+    Uint64          writes_delayed; /* Writes and pwrites kept buffered */
+    Uint64          write_flushes;  /* Buffered writes handed to a thread */
+} file_cache_stats;
+
 typedef struct {
     Sint            fd;
     ErlDrvPort      port;
@@ -207,9 +222,20 @@ typedef struct {
     struct t_data  *cq_tail;  /* -""- */
     enum e_timer    timer_state;
     size_t          read_bufsize;
+    size_t          read_ahead;   /* Current read-ahead, adapts between
+				     read_bufsize and 
+				     FILE_READ_AHEAD_SCALE*read_bufsize */
+    int             read_seq;     /* No seek or write since last read */
     ErlDrvBinary   *read_binp;
     size_t          read_offset;
     size_t          read_size;
+    ErlDrvBinary   *mmap_binp;    /* Extern binary of the mapped file */
+    char           *mmap_data;
+    Sint64          mmap_size;
+    Sint64          mmap_pos;     /* Position for read and read_line */
+    struct t_data  *pwrite_d;     /* Delayed pwrites, not yet queued */
+    unsigned        pwrite_max;   /* Number of specs room in pwrite_d */
+    file_cache_stats stats;
     size_t          write_bufsize;
     unsigned long   write_delay;
     int             write_error;
@@ -586,6 +612,8 @@ file_init(void)
 			    ? atoi(buf)
 			    : 0);
     driver_system_info(&sys_info, sizeof(ErlDrvSysInfo));
+    am_data = driver_mk_atom("data");
+    efile_init();
     return 0;
 }
 
@@ -614,9 +642,18 @@ file_start(ErlDrvPort port, char* command)
     desc->cq_tail = NULL;
     desc->timer_state = timer_idle;
     desc->read_bufsize = 0;
+    desc->read_ahead = 0;
+    desc->read_seq = 0;
     desc->read_binp = NULL;
     desc->read_offset = 0;
     desc->read_size = 0;
+    desc->mmap_binp = NULL;
+    desc->mmap_data = NULL;
+    desc->mmap_size = 0;
+    desc->mmap_pos = 0;
+    desc->pwrite_d = NULL;
+    desc->pwrite_max = 0;
+    memset(&desc->stats, 0, sizeof(desc->stats));
     desc->write_delay = 0L;
     desc->write_bufsize = 0;
     desc->write_error = 0;
@@ -663,6 +700,10 @@ file_stop(ErlDrvData e)
     if (desc->read_binp) {
 	driver_free_binary(desc->read_binp);
     }
+    if (desc->mmap_binp) {
+	driver_free_binary(desc->mmap_binp);
+    }
+    EF_FREE(desc->pwrite_d);
     EF_FREE(desc);
 }
 
@@ -845,6 +886,51 @@ static void reply_buf(file_descriptor *desc, char *buf, size_t len) {
     driver_output2(desc->port, header, sizeof(header), buf, len);
 }
 
+/*
+ * Replies with len bytes from offset in the mapped file. A binary port
+ * gets a binary referring to the mapping rather than a copy.
+ */
+static void reply_mmap_data(file_descriptor *desc, Sint64 offset, size_t len) {
+    ErlDrvTermData spec[2+2+2*9+4+2+2+2];
+    char header[1+4+4];
+    int i, n;
+
+    if (len == 0 || !(get_port_flags(desc->port) & PORT_FLAG_BINARY)) {
+	reply_buf(desc, desc->mmap_data + offset, len);
+	return;
+    }
+    /* Same as reply_data(), but offset and len are not limited to int:
+     * {Port, {data, [?FILE_RESP_DATA, 64-bit length (big-endian) | Data]}}
+     */
+    header[0] = FILE_RESP_DATA;
+    put_int64(len, header+1);
+    n = 0;
+    spec[n++] = ERL_DRV_PORT;
+    spec[n++] = driver_mk_port(desc->port);
+    spec[n++] = ERL_DRV_ATOM;
+    spec[n++] = am_data;
+    for (i = 0; i < sizeof(header); i++) {
+	spec[n++] = ERL_DRV_UINT;
+	spec[n++] = (ErlDrvTermData) (unsigned char) header[i];
+    }
+    spec[n++] = ERL_DRV_BINARY;
+    spec[n++] = (ErlDrvTermData) desc->mmap_binp;
+    spec[n++] = (ErlDrvTermData) len;
+    spec[n++] = (ErlDrvTermData) offset;
+    spec[n++] = ERL_DRV_LIST;
+    spec[n++] = sizeof(header) + 1;
+    spec[n++] = ERL_DRV_TUPLE;
+    spec[n++] = 2;
+    spec[n++] = ERL_DRV_TUPLE;
+    spec[n++] = 2;
+    ASSERT(n == sizeof(spec)/sizeof(spec[0]));
+    driver_output_term(desc->port, spec, n);
+}
+
+static void file_munmap(char *data, ErlDrvUInt size) {
+    efile_munmap(data, (Sint64) size);
+}
+
 static int reply_eof(file_descriptor *desc) {
     char c = FILE_RESP_EOF;
 
@@ -1124,6 +1210,33 @@ static void invoke_preadv(void *data)
     size_t           bytes_read_so_far = 0;
     unsigned char   *p = (unsigned char *)ev->iov[0].iov_base + 4+4+8*c->cnt;
 
+    if (! d->again && c->n - c->cnt > 1) {
+	/* Not segmented; let the OS do all reads at once if it can */
+	unsigned  i, n = c->n - c->cnt;
+	Efile_io *io = EF_ALLOC(sizeof(Efile_io)*n);
+	if (io) {
+	    ASSERT(c->size == 0);
+	    for (i = 0; i < n; i++) {
+		io[i].offset = c->offsets[c->cnt + i];
+		io[i].buf = ev->iov[1 + c->cnt + i].iov_base;
+		io[i].count = ev->iov[1 + c->cnt + i].iov_len;
+		io[i].result = 0;
+	    }
+	    if ( (d->result_ok 
+		  = efile_pread_batch(&d->errInfo, (int) d->fd, io, n))) {
+		for (i = 0; i < n; i++) {
+		    ASSERT(io[i].result <= io[i].count);
+		    ev->iov[1 + c->cnt].iov_len = io[i].result;
+		    ev->size += io[i].result;
+		    put_int64(io[i].result, p); p += 8;
+		    c->cnt++;
+		}
+	    }
+	    EF_FREE(io);
+	    return;
+	}
+    }
+
     while (c->cnt < c->n) {
 	size_t read_size = ev->iov[1 + c->cnt].iov_len - c->size;
 	size_t bytes_read = 0;
@@ -1395,8 +1508,46 @@ static void invoke_pwritev(void *data) {
 
     if (iovlen < 0)
 	goto error; /* Port terminated */
-    for (iovcnt = 0, c->free_size = 0;
-	 c->cnt < c->n && iovcnt < iovlen && c->free_size < size;
+    iovcnt = 0;
+    c->free_size = 0;
+    if (! segment && c->n - c->cnt > 1) {
+	/* Let the OS do all writes at once if it can */
+	unsigned  i, n;
+	Efile_io *io = EF_ALLOC(sizeof(Efile_io)*(c->n - c->cnt));
+	if (io) {
+	    for (n = 0; c->cnt + n < c->n && iovcnt < iovlen; n++) {
+		write_size = c->specs[c->cnt + n].size;
+		if (iov[iovcnt].iov_len - p < write_size) {
+		    /* Mismatch between pos/size spec and what is queued */
+		    EF_FREE(io);
+		    d->errInfo.posix_errno = EINVAL;
+		    d->result_ok = 0;
+		    d->again = 0;
+		    goto done;
+		}
+		io[n].offset = c->specs[c->cnt + n].offset;
+		io[n].buf = iov[iovcnt].iov_base + p;
+		io[n].count = write_size;
+		io[n].result = 0;
+		p += write_size;
+		if (iov[iovcnt].iov_len == p) {
+		    iovcnt++; p = 0;
+		}
+	    }
+	    d->result_ok = efile_pwrite_batch(&d->errInfo, (int) d->fd, io, n);
+	    for (i = 0; i < n && io[i].result == io[i].count; i++) {
+		c->free_size += io[i].count;
+		c->size -= io[i].count;
+		c->cnt++;
+	    }
+	    EF_FREE(io);
+	    if (! d->result_ok) {
+		d->again = 0;
+		goto done;
+	    }
+	}
+    }
+    for (; c->cnt < c->n && iovcnt < iovlen && c->free_size < size;
 	 c->cnt++) {
 	int chop;
 	write_size = c->specs[c->cnt].size;
@@ -1727,9 +1878,21 @@ static int async_write(file_descriptor *desc, int *errp,
     d->level = 1;
     cq_enq(desc, d);
     desc->write_buffered = 0;
+    desc->stats.write_flushes++;
     return 0;
 }
 
+/* Queue the delayed pwrites as one pwritev */
+static void flush_pwrite(file_descriptor *desc) {
+    if (desc->pwrite_d) {
+	TRACE_F(("W%lu", (unsigned long)desc->pwrite_d->c.pwritev.size));
+	cq_enq(desc, desc->pwrite_d);
+	desc->pwrite_d = NULL;
+	desc->pwrite_max = 0;
+	desc->stats.write_flushes++;
+    }
+}
+
 static int flush_write(file_descriptor *desc, int *errp) {
     int    result;
     MUTEX_LOCK(desc->q_mtx);
@@ -1739,6 +1902,7 @@ static int flush_write(file_descriptor *desc, int *errp) {
 	result = 0;
     }
     MUTEX_UNLOCK(desc->q_mtx);
+    flush_pwrite(desc);
     return result;
 }
 
@@ -1782,6 +1946,14 @@ static int async_lseek(file_descriptor *desc, int *errp, int reply,
 }
 
 static void flush_read(file_descriptor *desc) {
+    if (desc->read_size > 0) {
+	/* Read ahead in vain, the access is not sequential */
+	desc->stats.read_dropped += desc->read_size;
+	desc->read_ahead >>= 1;
+	if (desc->read_ahead < desc->read_bufsize)
+	    desc->read_ahead = desc->read_bufsize;
+    }
+    desc->read_seq = 0;
     desc->read_offset = 0;
     desc->read_size = 0;
     if (desc->read_binp) {
@@ -2022,10 +2194,18 @@ file_async_ready(ErlDrvData e, ErlDrvThreadData data)
 	  free_data(data);
 	  break;
       case FILE_PWRITEV:
-	  if (!d->result_ok) {
-	      reply_Uint_error(desc, d->c.pwritev.cnt, &d->errInfo);
+	  if (d->reply) {
+	      if (!d->result_ok) {
+		  reply_Uint_error(desc, d->c.pwritev.cnt, &d->errInfo);
+	      } else {
+		  reply_Uint(desc, d->c.pwritev.n);
+	      }
 	  } else {
-	      reply_Uint(desc, d->c.pwritev.n);
+	      /* Delayed pwrites, the error is returned by the next call */
+	      if (! d->result_ok) {
+		  desc->write_error = !0;
+		  desc->write_errInfo = d->errInfo;
+	      }
 	  }
 	  free_pwritev(data);
 	  break;
@@ -2050,7 +2230,8 @@ file_async_ready(ErlDrvData e, ErlDrvThreadData data)
       default:
 	abort();
     }
-    if (desc->write_buffered != 0 && desc->timer_state == timer_idle) {
+    if ((desc->write_buffered != 0 || desc->pwrite_d)
+	&& desc->timer_state == timer_idle) {
 	desc->timer_state = timer_write;
 	driver_set_timer(desc->port, desc->write_delay);
     }
@@ -2446,6 +2627,11 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 
     case FILE_CLOSE: {
 	flush_read(desc);
+	if (desc->mmap_binp) {
+	    /* Unmapped when no binary refers to it any more */
+	    driver_free_binary(desc->mmap_binp);
+	    desc->mmap_binp = NULL;
+	}
 	if (flush_write_check_error(desc, &err) < 0) {
 	    reply_posix_error(desc, err);
 	    goto done;
@@ -2519,15 +2705,37 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	    reply_buf(desc, &command, 0);
 	    goto done;
 	}
+	if (desc->mmap_binp) {
+	    /* Refer to the mapped file instead of reading */
+	    if (desc->mmap_pos >= desc->mmap_size) {
+		size = 0;
+	    } else if ((Uint64) (desc->mmap_size - desc->mmap_pos) < size) {
+		size = (size_t) (desc->mmap_size - desc->mmap_pos);
+	    }
+	    reply_mmap_data(desc, desc->mmap_pos, size);
+	    desc->mmap_pos += size;
+	    goto done;
+	}
 	if (desc->read_size >= size) {
 	    /* We already have all data */
 	    TRACE_C('D');
 	    reply_data(desc, desc->read_binp, desc->read_offset, size);
 	    desc->read_offset += size;
 	    desc->read_size -= size;
+	    desc->stats.read_hits++;
 	    try_free_read_bin(desc);
 	    goto done;
 	}
+	desc->stats.read_misses++;
+	/* Reading on where the last read ahead ended means that the
+	 * access is sequential, so read further ahead next time */
+	if (desc->read_seq && desc->read_ahead < 
+	    FILE_READ_AHEAD_SCALE*desc->read_bufsize) {
+	    desc->read_ahead <<= 1;
+	    if (desc->read_ahead > FILE_READ_AHEAD_SCALE*desc->read_bufsize)
+		desc->read_ahead = FILE_READ_AHEAD_SCALE*desc->read_bufsize;
+	}
+	desc->read_seq = !0;
 	/* We may have some of the data 
 	 */
 	/* Justification for the following strange formula:
@@ -2538,8 +2746,8 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	 * to copy. Therefore allocate the exact amount needed in 
 	 * this case, giving no lingering tail. */
 	alloc_size = 
-	    size > (desc->read_bufsize>>1) ? 
-	    size : desc->read_bufsize;
+	    size > (desc->read_ahead>>1) ? 
+	    size : desc->read_ahead;
 	if (! desc->read_binp) {
 	    /* Need to allocate a new binary for the result */
 	    if (! (desc->read_binp = driver_alloc_binary(alloc_size))) {
@@ -2608,6 +2816,33 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	    reply_posix_error(desc, EBADF);
 	    goto done;
 	}
+	if (desc->mmap_binp) {
+	    Sint64 pos = desc->mmap_pos;
+	    size_t size = pos < desc->mmap_size 
+		? (size_t) (desc->mmap_size - pos) : 0;
+	    char *nl_ptr = size ? memchr(desc->mmap_data + pos, '\n', size) : NULL;
+	    if (nl_ptr) {
+		size = nl_ptr - (desc->mmap_data + pos) + 1;
+		if (size > 1 && nl_ptr[-1] == '\r') {
+		    /* The mapping is read only, copy the line to
+		     * replace "\r\n" with "\n" */
+		    char *buf = EF_ALLOC(size - 1);
+		    if (! buf) {
+			reply_posix_error(desc, ENOMEM);
+			goto done;
+		    }
+		    memcpy(buf, desc->mmap_data + pos, size - 2);
+		    buf[size - 2] = '\n';
+		    reply_buf(desc, buf, size - 1);
+		    EF_FREE(buf);
+		    desc->mmap_pos += size;
+		    goto done;
+		}
+	    }
+	    reply_mmap_data(desc, pos, size);
+	    desc->mmap_pos += size;
+	    goto done;
+	}
 	if (desc->read_size > 0) {
 	    /* look for '\n' in what we'we already got */
 	    void *nl_ptr = memchr(desc->read_binp->orig_bytes + desc->read_offset,'\n',desc->read_size);
@@ -2678,6 +2913,8 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	    reply_Uint(desc, size);
 	    goto done;
 	}
+	/* Delayed pwrites have their data first in the queue */
+	flush_pwrite(desc);
 	MUTEX_LOCK(desc->q_mtx);
 	if (driver_enqv(desc->port, ev, skip)) {
 	    MUTEX_UNLOCK(desc->q_mtx);
@@ -2687,6 +2924,7 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	desc->write_buffered += size;
 	if (desc->write_buffered < desc->write_bufsize) {
 	    MUTEX_UNLOCK(desc->q_mtx);
+	    desc->stats.writes_delayed++;
 	    reply_Uint(desc, size);
 	    if (desc->timer_state == timer_idle) {
 		desc->timer_state = timer_write;
@@ -2711,7 +2949,10 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	    reply_Uint_posix_error(desc, 0, err);
 	    goto done;
 	}
-	if (flush_write_check_error(desc, &err) < 0) {
+	/* Delayed pwrites are kept to be queued along with these */
+	if ((desc->pwrite_d 
+	     ? check_write_error(desc, &err) 
+	     : flush_write_check_error(desc, &err)) < 0) {
 	    reply_Uint_posix_error(desc, 0, err);
 	    goto done;
 	}
@@ -2757,7 +2998,7 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	for(i = 0; i < n; i++) {
 	    Uint32 sizeH, sizeL;
 	    size_t size;
-	    if (   !EV_GET_UINT64(ev, &d->c.pwritev.specs[i].offset, &p, &q)
+	    if (   !EV_GET_UINT64(ev, &d->c.pwritev.specs[j].offset, &p, &q)
 		|| !EV_GET_UINT32(ev, &sizeH, &p, &q)
 		|| !EV_GET_UINT32(ev, &sizeL, &p, &q)) {
 		/* Misalignment in buffer */
@@ -2781,6 +3022,7 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 		j++;
 	    }
 	}
+	d->c.pwritev.n = j;
 	d->c.pwritev.size = total;
 	d->c.pwritev.free_size = 0;
 	if (j == 0) {
@@ -2795,7 +3037,65 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 		 */
 		EF_FREE(d);
 		reply_Uint_posix_error(desc, 0, EINVAL);
+	    } else if (desc->write_bufsize > 0 && n == j
+		       && (desc->flags & EFILE_MODE_WRITE)) {
+		/* Delayed write; gather the pwrites into one pwritev 
+		 * that is queued when enough data is buffered or 
+		 * before any other operation */
+		struct t_data *pd = desc->pwrite_d;
+		if (! pd || pd->c.pwritev.n + j > desc->pwrite_max) {
+		    unsigned max = pd ? 2*desc->pwrite_max : 16;
+		    if (max < (pd ? pd->c.pwritev.n : 0) + j)
+			max = (pd ? pd->c.pwritev.n : 0) + j;
+		    pd = pd 
+			? EF_REALLOC(pd, sizeof(struct t_data)
+				     + (max * sizeof(struct t_pbuf_spec)))
+			: EF_ALLOC(sizeof(struct t_data)
+				   + (max * sizeof(struct t_pbuf_spec)));
+		    if (! pd) {
+			EF_FREE(d);
+			flush_pwrite(desc);
+			reply_Uint_posix_error(desc, 0, ENOMEM);
+			goto done;
+		    }
+		    if (! desc->pwrite_d) {
+			pd->command = command;
+			pd->reply = 0;
+			pd->fd = desc->fd;
+			pd->flags = desc->flags;
+			pd->c.pwritev.port = desc->port;
+			pd->c.pwritev.q_mtx = desc->q_mtx;
+			pd->c.pwritev.n = 0;
+			pd->c.pwritev.cnt = 0;
+			pd->c.pwritev.size = 0;
+			pd->c.pwritev.free_size = 0;
+			pd->invoke = invoke_pwritev;
+			pd->free = free_pwritev;
+			pd->level = 1;
+		    }
+		    desc->pwrite_d = pd;
+		    desc->pwrite_max = max;
+		}
+		memcpy(&pd->c.pwritev.specs[pd->c.pwritev.n],
+		       d->c.pwritev.specs, j * sizeof(struct t_pbuf_spec));
+		pd->c.pwritev.n += j;
+		pd->c.pwritev.size += total;
+		EF_FREE(d);
+		MUTEX_LOCK(desc->q_mtx);
+		driver_enqv(desc->port, ev, skip);
+		MUTEX_UNLOCK(desc->q_mtx);
+		desc->stats.writes_delayed++;
+		reply_Uint(desc, n);
+		if (pd->c.pwritev.size >= desc->write_bufsize) {
+		    flush_pwrite(desc);
+		} else if (desc->timer_state == timer_idle) {
+		    desc->timer_state = timer_write;
+		    driver_set_timer(desc->port, desc->write_delay);
+		}
 	    } else {
+		/* Delayed pwrites have their data first in the queue,
+		 * so they must be queued before this one */
+		flush_pwrite(desc);
 		/* Enqueue the data */
 		MUTEX_LOCK(desc->q_mtx);
 		driver_enqv(desc->port, ev, skip);
@@ -2834,6 +3134,60 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	    reply_posix_error(desc, EINVAL);
 	    goto done;
 	}
+	if (desc->mmap_binp) {
+	    /* Reply with binaries referring to the mapped file */
+	    ErlIOVec      mev;
+	    ErlDrvBinary *hbin;
+	    mev.iov = EF_ALLOC((1+n) * (sizeof(*mev.iov) + sizeof(*mev.binv)));
+	    if (! mev.iov) {
+		reply_posix_error(desc, ENOMEM);
+		goto done;
+	    }
+	    mev.binv = void_ptr = &mev.iov[1+n];
+	    if (! (hbin = driver_alloc_binary(4+4+8*n))) {
+		EF_FREE(mev.iov);
+		reply_posix_error(desc, ENOMEM);
+		goto done;
+	    }
+	    put_int32(0, hbin->orig_bytes);
+	    put_int32(n, hbin->orig_bytes+4);
+	    mev.vsize = 1+n;
+	    mev.size = 4+4+8*n;
+	    mev.iov[0].iov_base = hbin->orig_bytes;
+	    mev.iov[0].iov_len = 4+4+8*n;
+	    mev.binv[0] = hbin;
+	    for (i = 1; i < 1+n; i++) {
+		Sint64 offset;
+		Uint32 sizeH, sizeL;
+		Uint64 size;
+		if (   !EV_GET_UINT64(ev, &offset, &p, &q)
+		    || !EV_GET_UINT32(ev, &sizeH, &p, &q)
+		    || !EV_GET_UINT32(ev, &sizeL, &p, &q)
+		    || offset < 0) {
+		    break;
+		}
+		size = ((Uint64) sizeH << 32) | sizeL;
+		if (offset >= desc->mmap_size) {
+		    size = 0;
+		    offset = 0;
+		} else if ((Uint64) (desc->mmap_size - offset) < size) {
+		    size = desc->mmap_size - offset;
+		}
+		put_int64(size, hbin->orig_bytes + 8*i);
+		mev.iov[i].iov_base = desc->mmap_data + offset;
+		mev.iov[i].iov_len = (size_t) size;
+		mev.binv[i] = desc->mmap_binp;
+		mev.size += (size_t) size;
+	    }
+	    if (i < 1+n) {
+		reply_posix_error(desc, EINVAL);
+	    } else {
+		reply_ev(desc, FILE_RESP_LDATA, &mev);
+	    }
+	    driver_free_binary(hbin);
+	    EF_FREE(mev.iov);
+	    goto done;
+	}
 	/* Create the thread data structure with the contained ErlIOVec 
 	 * and corresponding binaries for the response 
 	 */
@@ -2939,6 +3293,22 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	    reply_posix_error(desc, EINVAL);
 	    goto done;
 	}
+	if (desc->mmap_binp) {
+	    /* Only read and read_line use the position */
+	    switch (origin) {
+	    case EFILE_SEEK_SET: break;
+	    case EFILE_SEEK_CUR: offset += desc->mmap_pos; break;
+	    case EFILE_SEEK_END: offset += desc->mmap_size; break;
+	    default: offset = -1; break;
+	    }
+	    if (offset < 0) {
+		reply_posix_error(desc, EINVAL);
+	    } else {
+		desc->mmap_pos = offset;
+		reply_Sint64(desc, offset);
+	    }
+	    goto done;
+	}
 	if (async_lseek(desc, &err, !0, offset, origin) < 0) {
 	    reply_posix_error(desc, err);
 	    goto done;
@@ -3042,6 +3412,22 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 	cq_enq(desc, d);
     } goto done; /* case FILE_IPREAD: */
 
+    case FILE_CACHE_INFO: {
+	char buf[6*8];
+	if (ev->size != 1) {
+	    /* Wrong command length */
+	    reply_posix_error(desc, EINVAL);
+	    goto done;
+	}
+	put_int64(desc->stats.read_hits, buf);
+	put_int64(desc->stats.read_misses, buf+8);
+	put_int64(desc->read_ahead, buf+2*8);
+	put_int64(desc->stats.read_dropped, buf+3*8);
+	put_int64(desc->stats.writes_delayed, buf+4*8);
+	put_int64(desc->stats.write_flushes, buf+5*8);
+	reply_buf(desc, buf, sizeof(buf));
+    } goto done;
+
     case FILE_SETOPT: {
 	char opt;
 	if (ev->size < 1+1
@@ -3101,6 +3487,42 @@ file_outputv(ErlDrvData e, ErlIOVec *ev) {
 #else
 	    desc->read_bufsize = ((size_t)sizeH << 32) | sizeL;
 #endif
+	    desc->read_ahead = desc->read_bufsize;
+	    TRACE_C('K');
+	    reply_ok(desc);
+	} goto done;
+	case FILE_OPT_MMAP: {
+	    Efile_error errInfo;
+	    char *data;
+	    Sint64 size;
+	    if (ev->size != 1+1) {
+		reply_posix_error(desc, EINVAL);
+		goto done;
+	    }
+	    /* Only files that are read, and that nobody changes */
+	    if (desc->fd == FILE_FD_INVALID
+		|| ! (desc->flags & EFILE_MODE_READ)
+		|| (desc->flags & (EFILE_MODE_WRITE|EFILE_COMPRESSED))) {
+		reply_posix_error(desc, EINVAL);
+		goto done;
+	    }
+	    if (! desc->mmap_binp) {
+		if (! efile_mmap(&errInfo, (int) desc->fd, &data, &size)) {
+		    reply_error(desc, &errInfo);
+		    goto done;
+		}
+		desc->mmap_binp = driver_alloc_extern_binary(data,
+							     (ErlDrvUInt) size,
+							     file_munmap);
+		if (! desc->mmap_binp) {
+		    efile_munmap(data, size);
+		    reply_posix_error(desc, ENOMEM);
+		    goto done;
+		}
+		desc->mmap_data = data;
+		desc->mmap_size = size;
+		desc->mmap_pos = 0;
+	    }
 	    TRACE_C('K');
 	    reply_ok(desc);
 	} goto done;
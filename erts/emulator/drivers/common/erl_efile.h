@@ -109,10 +109,25 @@ typedef struct _Efile_info {
 				 */
 } Efile_info;
 
+/*
+ * One read or write of a batch for efile_pread_batch() and
+ * efile_pwrite_batch(). On a failed batch, the writes that
+ * were completed before the failing one have result == count.
+ */
+
+typedef struct _Efile_io {
+    Sint64 offset;		/* Offset in bytes from BOF. */
+    char* buf;			/* Buffer to read into or write from. */
+    size_t count;		/* Number of bytes to read or write. */
+    size_t result;		/* Number of bytes read or written. */
+} Efile_io;
+
 /*
  * Functions.
  */
 
+void efile_init(void);
+
 int efile_mkdir(Efile_error* errInfo, char* name);
 int efile_rmdir(Efile_error* errInfo, char* name);
 int efile_delete_file(Efile_error* errInfo, char* name);
@@ -143,6 +158,10 @@ int efile_pwrite(Efile_error* errInfo, int fd,
 		 char* buf, size_t count, Sint64 offset);
 int efile_pread(Efile_error* errInfo, int fd, 
 		Sint64 offset, char* buf, size_t count, size_t* pBytesRead);
+int efile_pwrite_batch(Efile_error* errInfo, int fd, Efile_io* io, int n);
+int efile_pread_batch(Efile_error* errInfo, int fd, Efile_io* io, int n);
+int efile_mmap(Efile_error* errInfo, int fd, char** pData, Sint64* pSize);
+void efile_munmap(char* data, Sint64 size);
 int efile_readlink(Efile_error* errInfo, char *name, 
 		   char* buffer, size_t size);
 int efile_altname(Efile_error* errInfo, char *name, 
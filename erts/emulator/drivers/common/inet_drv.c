@@ -226,6 +226,20 @@ struct  linger {
 #include <sys/ioctl.h>
 #endif
 
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#define HAVE_SENDFILE
+#endif
+
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define HAVE_RECVMMSG  /* glibc >= 2.12 */
+#if defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2,14)
+#define HAVE_SENDMMSG
+#endif
+#endif
+#endif
+
 #ifndef _OSE_
 #include <net/if.h>
 #else
@@ -462,6 +476,8 @@ static int my_strncasecmp(const char *s1, const char *s2, size_t n)
 #define INET_PASSIVE        0  /* false */
 #define INET_ACTIVE         1  /* true */
 #define INET_ONCE           2  /* true; active once then passive */
+#define INET_MULTI          3  /* true; active N then passive */
+#define INET_ACTIVE_N_MAX   32767  /* max N, and max count, for {active, N} */
 
 /* INET_REQ_GETSTATUS enumeration */
 #define INET_F_OPEN         0x0001
@@ -508,10 +524,12 @@ static int my_strncasecmp(const char *s1, const char *s2, size_t n)
 #define TCP_REQ_UNRECV         43
 #define TCP_REQ_SHUTDOWN       44
 #define TCP_REQ_MULTI_OP       45
+#define TCP_REQ_SENDFILE       46
 /* UDP and SCTP requests */
 #define PACKET_REQ_RECV        60 /* Common for UDP and SCTP         */
 #define SCTP_REQ_LISTEN	       61 /* Different from TCP; not for UDP */
 #define SCTP_REQ_BINDX	       62 /* Multi-home SCTP bind            */
+#define UDP_REQ_SENDMANY       63 /* Send several datagrams; UDP only */
 
 /* INET_REQ_SUBSCRIBE sub-requests */
 #define INET_SUBS_EMPTY_OUT_Q  1
@@ -544,6 +562,8 @@ static int my_strncasecmp(const char *s1, const char *s2, size_t n)
 #define UDP_OPT_MULTICAST_LOOP 13 /* set/get IP multicast loopback */
 #define UDP_OPT_ADD_MEMBERSHIP 14 /* add an IP group membership */
 #define UDP_OPT_DROP_MEMBERSHIP 15 /* drop an IP group membership */
+#define INET_OPT_REUSEPORT  16  /* enable/disable sharing of a local port */
+#define TCP_OPT_NOPUSH      17  /* cork: send only full segments */
 /* LOPT is local options */
 #define INET_LOPT_BUFFER      20  /* min buffer size hint */
 #define INET_LOPT_HEADER      21  /* list header size */
@@ -561,6 +581,9 @@ static int my_strncasecmp(const char *s1, const char *s2, size_t n)
 #define INET_LOPT_UDP_READ_PACKETS 33  /* Number of packets to read */
 #define INET_OPT_RAW               34  /* Raw socket options */
 #define INET_LOPT_TCP_SEND_TIMEOUT_CLOSE 35  /* auto-close on send timeout or not */
+#define INET_LOPT_UDP_BATCH_PACKETS 36  /* Deliver packets read together as one message */
+#define INET_LOPT_ACTIVE_N         37  /* {active, N}: add N to active count */
+#define INET_LOPT_TCP_DELAY_SEND_LIMIT 38  /* Send delayed data at this size */
 /* SCTP options: a separate range, from 100: */
 #define SCTP_OPT_RTOINFO		100
 #define SCTP_OPT_ASSOCINFO		101
@@ -795,7 +818,9 @@ typedef struct {
     inet_async_op* opt;          /* queue tail or NULL */
     inet_async_op  op_queue[INET_MAX_ASYNC];  /* call queue */
 
-    int   active;               /* 0 = passive, 1 = active, 2 = active once */
+    int   active;               /* 0 = passive, 1 = active, 2 = active once,
+				   3 = active N */
+    int   active_count;         /* messages left to deliver in {active, N} */
     int   stype;                /* socket type:
 				    SOCK_STREAM/SOCK_DGRAM/SOCK_SEQPACKET   */
     int   sprotocol;            /* socket protocol:
@@ -842,9 +867,15 @@ typedef struct {
 
 #define TCP_MAX_PACKET_SIZE 0x4000000  /* 64 M */
 
-#define MAX_VSIZE 16		/* Max number of entries allowed in an I/O
-				 * vector sock_sendv().
-				 */
+/* Max number of entries allowed in an I/O vector sock_sendv(). Queued
+ * output, e.g. many small delayed sends, is written with as few calls
+ * as the system allows.
+ */
+#if defined(IOV_MAX) && IOV_MAX > 16
+#define MAX_VSIZE (IOV_MAX < 1024 ? IOV_MAX : 1024)
+#else
+#define MAX_VSIZE 16
+#endif
 
 static int tcp_inet_init(void);
 static void tcp_inet_stop(ErlDrvData);
@@ -1000,12 +1031,41 @@ typedef struct {
     char*         i_ptr_start;  /* packet start pos in buf */
     int           i_remain;     /* remaining chars to read */
     int           tcp_add_flags;/* Additional TCP descriptor flags */
+    int           delay_send_limit; /* send delayed data when this much
+				   is queued (0 = wait for next poll) */
     int           http_state;   /* 0 = response|request  1=headers fields */
     inet_async_multi_op *multi_first;/* NULL == no multi-accept-queue, op is in ordinary queue */
     inet_async_multi_op *multi_last;
     MultiTimerData *mtd;        /* Timer structures for multiple accept */
+#ifdef HAVE_SENDFILE
+    struct {
+	int fd;                 /* file being sent, -1 if none */
+	Uint64 offset;          /* next offset in file */
+	Uint64 left;            /* bytes left to send (if !to_eof) */
+	Uint64 sent;            /* bytes sent so far */
+	int to_eof;             /* send until end of file */
+	int qbefore;            /* queued bytes to send before the file */
+	ErlDrvTermData caller;  /* process waiting for the result */
+    } sendfile;
+#endif
 } tcp_descriptor;
 
+#ifdef HAVE_SENDFILE
+#define TCP_SENDFILE_PENDING(desc) ((desc)->sendfile.fd >= 0)
+/* Max bytes to send from a file per output event */
+#define TCP_SENDFILE_MAX_STEP  (1024*1024)
+#else
+#define TCP_SENDFILE_PENDING(desc) 0
+#endif
+
+/* Delayed sends (delay_send) are written at once, instead of at the next
+ * poll, when the queue reaches delay_send_limit bytes */
+#define TCP_DELAY_SEND_FLUSH(desc, qsz, len)				\
+    (((desc)->tcp_add_flags & TCP_ADDF_DELAY_SEND)			\
+     && (desc)->delay_send_limit > 0					\
+     && (qsz) < (desc)->delay_send_limit				\
+     && (qsz) + (len) >= (desc)->delay_send_limit)
+
 /* send function */
 static int tcp_send(tcp_descriptor* desc, char* ptr, int len);
 static int tcp_sendv(tcp_descriptor* desc, ErlIOVec* ev);
@@ -1013,13 +1073,22 @@ static int tcp_recv(tcp_descriptor* desc, int request_len);
 static int tcp_deliver(tcp_descriptor* desc, int len);
 
 static int tcp_inet_output(tcp_descriptor* desc, HANDLE event);
+#ifdef HAVE_SENDFILE
+static int tcp_sendfile_reply(tcp_descriptor* desc, ErlDrvTermData reason);
+static int tcp_sendfile_step(tcp_descriptor* desc);
+#endif
 static int tcp_inet_input(tcp_descriptor* desc, HANDLE event);
 
 typedef struct {
     inet_descriptor inet;   /* common data structure (DON'T MOVE) */
     int read_packets;       /* Number of packets to read per invocation */
+    int batch_packets;      /* Deliver packets read per invocation as one
+			       {udp_batch, S, [{IP, Port, Data}]} message */
 } udp_descriptor;
 
+/* Max number of datagrams per recvmmsg()/sendmmsg() */
+#define UDP_MAX_BATCH 32
+
 
 static int packet_inet_input(udp_descriptor* udesc, HANDLE event);
 static int packet_inet_output(udp_descriptor* udesc, HANDLE event);
@@ -1042,11 +1111,18 @@ static ErlDrvTermData am_closed;
 static ErlDrvTermData am_tcp_closed;
 static ErlDrvTermData am_tcp_error;
 static ErlDrvTermData am_udp_error;
+static ErlDrvTermData am_udp_batch;
+static ErlDrvTermData am_tcp_passive;
+static ErlDrvTermData am_udp_passive;
 static ErlDrvTermData am_empty_out_q;
+#ifdef HAVE_SENDFILE
+static ErlDrvTermData am_sendfile;
+#endif
 static ErlDrvTermData am_ssl_tls;
 #ifdef HAVE_SCTP
 static ErlDrvTermData am_sctp;
 static ErlDrvTermData am_sctp_error;
+static ErlDrvTermData am_sctp_passive;
 static ErlDrvTermData am_true;
 static ErlDrvTermData am_false;
 static ErlDrvTermData am_buffer;
@@ -1166,6 +1242,13 @@ static void *realloc_wrapper(void *current, size_t size){
   ((vec)[(i)+2] = (len)), \
   ((i)+LOAD_BUF2BINARY_CNT))
 
+/* Data from a receive buffer: copied if small, else a sub binary of it */
+#define LOAD_DATA_CNT LOAD_BINARY_CNT
+#define LOAD_DATA(vec, i, bin, offs, len) \
+  (((len) < INET_COPY_LIMIT) ? \
+   LOAD_BUF2BINARY(vec, i, (bin)->orig_bytes+(offs), len) : \
+   LOAD_BINARY(vec, i, bin, offs, len))
+
 #define LOAD_STRING_CNT 3
 #define LOAD_STRING(vec, i, str, len) \
   (((vec)[(i)] = ERL_DRV_STRING), \
@@ -1287,14 +1370,30 @@ static int load_ip_and_port
 
 /*
 ** Binary Buffer Managment
-** We keep a stack of usable buffers 
+** We keep a pool of usable buffers: a stack per size class, where the
+** classes are powers of two from 256 bytes to INET_MAX_BUFFER (plus room
+** for an address in front of udp data). Buffers are allocated rounded up
+** to their class size so that they can be reused for any read of that
+** class, and are put back in the largest class they can serve.
 */
-#define BUFFER_STACK_SIZE 16
+#define BUFFER_CLASSES    9	/* 256 .. 64k */
+#define BUFFER_STACK_SIZE 32	/* per class, room for a UDP_MAX_BATCH read */
+#define BUFFER_CLASS_SIZE(c) ((256L << (c)) + (long) sizeof(inet_address))
+
+typedef struct {
+    erts_smp_spinlock_t lock;
+    int pos;
+    ErlDrvBinary* stack[BUFFER_STACK_SIZE];
+} inet_buffer_stack;
 
-static erts_smp_spinlock_t inet_buffer_stack_lock;
-static ErlDrvBinary* buffer_stack[BUFFER_STACK_SIZE];
-static int buffer_stack_pos = 0;
+static inet_buffer_stack buffer_pool[BUFFER_CLASSES];
 
+/*
+** Received data smaller than this is copied out of the buffer when
+** delivered, instead of being delivered as a (sub) binary keeping the
+** whole buffer alive. The buffer can then be reused at once.
+*/
+#define INET_COPY_LIMIT 1024
 
 /*
  * XXX
@@ -1302,32 +1401,33 @@ static int buffer_stack_pos = 0;
  * driver is special). Replace when driver locking api has been implemented.
  * /rickard
  */
-#define BUFSTK_LOCK	erts_smp_spin_lock(&inet_buffer_stack_lock);
-#define BUFSTK_UNLOCK	erts_smp_spin_unlock(&inet_buffer_stack_lock);
+#define BUFSTK_LOCK(c)	 erts_smp_spin_lock(&buffer_pool[(c)].lock);
+#define BUFSTK_UNLOCK(c) erts_smp_spin_unlock(&buffer_pool[(c)].lock);
 
 #ifdef DEBUG
+static erts_smp_spinlock_t inet_buffer_count_lock;
 static int tot_buf_allocated = 0;  /* memory in use for i_buf */
 static int tot_buf_stacked = 0;   /* memory on stack */
 static int max_buf_allocated = 0; /* max allocated */
 
 #define COUNT_BUF_ALLOC(sz) do { \
-  BUFSTK_LOCK; \
+  erts_smp_spin_lock(&inet_buffer_count_lock); \
   tot_buf_allocated += (sz); \
   if (tot_buf_allocated > max_buf_allocated) \
     max_buf_allocated = tot_buf_allocated; \
-  BUFSTK_UNLOCK; \
+  erts_smp_spin_unlock(&inet_buffer_count_lock); \
 } while(0)
 
 #define COUNT_BUF_FREE(sz) do { \
- BUFSTK_LOCK; \
+ erts_smp_spin_lock(&inet_buffer_count_lock); \
  tot_buf_allocated -= (sz); \
- BUFSTK_UNLOCK; \
+ erts_smp_spin_unlock(&inet_buffer_count_lock); \
  } while(0)
 
 #define COUNT_BUF_STACK(sz) do { \
- BUFSTK_LOCK; \
+ erts_smp_spin_lock(&inet_buffer_count_lock); \
  tot_buf_stacked += (sz); \
- BUFSTK_UNLOCK; \
+ erts_smp_spin_unlock(&inet_buffer_count_lock); \
  } while(0)
 
 #else
@@ -1338,31 +1438,52 @@ static int max_buf_allocated = 0; /* max allocated */
 
 #endif
 
+static void init_buffer_pool(void)
+{
+    int c;
+    for (c = 0; c < BUFFER_CLASSES; c++) {
+	erts_smp_spinlock_init(&buffer_pool[c].lock, "inet_buffer_stack_lock");
+	buffer_pool[c].pos = 0;
+    }
+#ifdef DEBUG
+    erts_smp_spinlock_init(&inet_buffer_count_lock, "inet_buffer_count_lock");
+#endif
+}
+
+/* Smallest class that buffers of size sz fit in (BUFFER_CLASSES if none) */
+static int buffer_class(long sz)
+{
+    int c = 0;
+    while ((c < BUFFER_CLASSES) && (BUFFER_CLASS_SIZE(c) < sz))
+	c++;
+    return c;
+}
+
 static ErlDrvBinary* alloc_buffer(long minsz)
 {
     ErlDrvBinary* buf = NULL;
-
-    BUFSTK_LOCK;
+    int c = buffer_class(minsz);
 
     DEBUGF(("alloc_buffer: sz = %ld, tot = %d, max = %d\r\n", 
 	    minsz, tot_buf_allocated, max_buf_allocated));
 
-    if (buffer_stack_pos > 0) {
-	int origsz;
+    if (c == BUFFER_CLASSES) {
+	if ((buf = driver_alloc_binary(minsz)) == NULL)
+	    return NULL;
+	COUNT_BUF_ALLOC(buf->orig_size);
+	return buf;
+    }
 
-	buf = buffer_stack[--buffer_stack_pos];
-	origsz = buf->orig_size;
-	BUFSTK_UNLOCK;
-	COUNT_BUF_STACK(-origsz);
-	if (origsz < minsz) {
-	    if ((buf = driver_realloc_binary(buf, minsz)) == NULL)
-		return NULL;
-	    COUNT_BUF_ALLOC(buf->orig_size - origsz);
-	}
+    BUFSTK_LOCK(c);
+    if (buffer_pool[c].pos > 0) {
+	buf = buffer_pool[c].stack[--buffer_pool[c].pos];
+	BUFSTK_UNLOCK(c);
+	COUNT_BUF_STACK(-buf->orig_size);
+	ASSERT(buf->orig_size >= minsz);
     }
     else {
-	BUFSTK_UNLOCK;
-	if ((buf = driver_alloc_binary(minsz)) == NULL)
+	BUFSTK_UNLOCK(c);
+	if ((buf = driver_alloc_binary(BUFFER_CLASS_SIZE(c))) == NULL)
 	    return NULL;
 	COUNT_BUF_ALLOC(buf->orig_size);
     }
@@ -1370,19 +1491,31 @@ static ErlDrvBinary* alloc_buffer(long minsz)
 }
 
 /*
-** Max buffer memory "cached" BUFFER_STACK_SIZE * INET_MAX_BUFFER
-** (16 * 64k ~ 1M)
+** Max buffer memory "cached" BUFFER_STACK_SIZE times the sum of the
+** class sizes (32 * 128k ~ 4M). Buffers larger than the largest class,
+** e.g. grown by tcp_expand_buffer, are freed; any other buffer is less
+** than twice the size of the class it is cached in.
 */
 /*#define CHECK_DOUBLE_RELEASE 1*/
 static void release_buffer(ErlDrvBinary* buf)
 {
+    int c;
+
     DEBUGF(("release_buffer: %ld\r\n", (buf==NULL) ? 0 : buf->orig_size));
     if (buf == NULL)
 	return;
-    BUFSTK_LOCK;
-    if ((buf->orig_size > INET_MAX_BUFFER) || 
-	(buffer_stack_pos >= BUFFER_STACK_SIZE)) {
-	BUFSTK_UNLOCK;
+    /* The largest class the buffer can serve */
+    c = buffer_class(buf->orig_size);
+    if ((c < BUFFER_CLASSES) && (BUFFER_CLASS_SIZE(c) > buf->orig_size))
+	c--;
+    if ((c < 0) || (c == BUFFER_CLASSES)) {
+	COUNT_BUF_FREE(buf->orig_size);
+	driver_free_binary(buf);
+	return;
+    }
+    BUFSTK_LOCK(c);
+    if (buffer_pool[c].pos >= BUFFER_STACK_SIZE) {
+	BUFSTK_UNLOCK(c);
 	COUNT_BUF_FREE(buf->orig_size);
 	driver_free_binary(buf);
     }
@@ -1392,16 +1525,16 @@ static void release_buffer(ErlDrvBinary* buf)
 #warning CHECK_DOUBLE_RELEASE is enabled, this is a custom build emulator
 #endif
 	int i;
-	for (i = 0; i < buffer_stack_pos; ++i) {
-	    if (buffer_stack[i] == buf) {
+	for (i = 0; i < buffer_pool[c].pos; ++i) {
+	    if (buffer_pool[c].stack[i] == buf) {
 		erl_exit(1,"Multiple buffer release in inet_drv, this is a "
 			 "bug, save the core and send it to "
 			 "support@erlang.ericsson.se!");
 	    }
 	}
 #endif
-	buffer_stack[buffer_stack_pos++] = buf;
-	BUFSTK_UNLOCK;
+	buffer_pool[c].stack[buffer_pool[c].pos++] = buf;
+	BUFSTK_UNLOCK(c);
 	COUNT_BUF_STACK(buf->orig_size);
     }
 }
@@ -2931,7 +3064,7 @@ inet_async_binary_data
     else {
 	/* INET_MODE_BINARY => [H1,H2,...HSz | Binary] or [Binary]: */
 	int sz = len - hsz;
-	i = LOAD_BINARY(spec, i, bin, offs+hsz, sz);
+	i = LOAD_DATA(spec, i, bin, offs+hsz, sz);
 	if (hsz > 0)
 	    i = LOAD_STRING_CONS(spec, i, bin->orig_bytes+offs, hsz);
     }
@@ -3098,7 +3231,7 @@ static int packet_binary_message
 	    /* INET_MODE_BINARY => [H1,H2,...HSz | Binary]	*/
 	    int sz = len - hsz;
 
-	    i = LOAD_BINARY(spec, i, bin, offs+hsz, sz);
+	    i = LOAD_DATA(spec, i, bin, offs+hsz, sz);
 	    if (hsz > 0)
 		i = LOAD_STRING_CONS(spec, i, bin->orig_bytes+offs, hsz);
 	}
@@ -3185,6 +3318,70 @@ static void scanbit8(inet_descriptor* desc, const char* buf, int len)
     desc->bit8 = ((c & 0x80) != 0);
 }
 
+/*
+** send active message {tcp_passive|udp_passive|sctp_passive, S}
+** when an {active, N} socket has used up its count
+*/
+static int inet_passive_message(inet_descriptor* desc)
+{
+    ErlDrvTermData spec[LOAD_ATOM_CNT + LOAD_PORT_CNT + LOAD_TUPLE_CNT];
+    ErlDrvTermData am_passive = am_udp_passive;
+    int i = 0;
+
+    DEBUGF(("inet_passive_message(%ld):\r\n", (long)desc->port));
+    if (desc->stype == SOCK_STREAM)
+	am_passive = am_tcp_passive;
+#ifdef HAVE_SCTP
+    else if (IS_SCTP(desc))
+	am_passive = am_sctp_passive;
+#endif
+    i = LOAD_ATOM(spec, i, am_passive);
+    i = LOAD_PORT(spec, i, desc->dport);
+    i = LOAD_TUPLE(spec, i, 2);
+    ASSERT(i == sizeof(spec)/sizeof(*spec));
+    return driver_output_term(desc->port, spec, i);
+}
+
+/*
+** An active message has been delivered: {active, once} goes passive,
+** {active, N} goes passive when N messages have been delivered.
+*/
+static void inet_active_delivered(inet_descriptor* desc)
+{
+    if (desc->active == INET_ONCE)
+	desc->active = INET_PASSIVE;
+    else if ((desc->active == INET_MULTI) && (--desc->active_count <= 0)) {
+	desc->active_count = 0;
+	desc->active = INET_PASSIVE;
+	inet_passive_message(desc);
+    }
+}
+
+/*
+** {active, N}: add N to the number of messages left to deliver.
+** N can be negative, but the count must stay below INET_ACTIVE_N_MAX.
+** A count that drops to 0 makes the socket passive.
+*/
+static int inet_set_active_n(inet_descriptor* desc, int n)
+{
+    int count = (desc->active == INET_MULTI) ? desc->active_count : 0;
+
+    if ((n < -INET_ACTIVE_N_MAX) || (n > INET_ACTIVE_N_MAX) ||
+	(count + n > INET_ACTIVE_N_MAX))
+	return -1;
+    count += n;
+    if (count <= 0) {
+	desc->active_count = 0;
+	desc->active = INET_PASSIVE;
+	inet_passive_message(desc);
+    }
+    else {
+	desc->active_count = count;
+	desc->active = INET_MULTI;
+    }
+    return 0;
+}
+
 /* 
 ** active=TRUE:
 **  (NOTE! distribution MUST use active=TRUE, deliver=PORT)
@@ -3219,8 +3416,7 @@ static int tcp_reply_data(tcp_descriptor* desc, char* buf, int len)
 
     if (code < 0)
 	return code;
-    if (desc->inet.active == INET_ONCE)
-	desc->inet.active = INET_PASSIVE;
+    inet_active_delivered(INETP(desc));
     return code;
 }
 
@@ -3249,8 +3445,7 @@ tcp_reply_binary_data(tcp_descriptor* desc, ErlDrvBinary* bin, int offs, int len
     }
     if (code < 0)
 	return code;
-    if (desc->inet.active == INET_ONCE)
-	desc->inet.active = INET_PASSIVE;
+    inet_active_delivered(INETP(desc));
     return code;
 }
 
@@ -3268,15 +3463,14 @@ packet_reply_binary_data(inet_descriptor* desc, unsigned  int hsz,
 	/* "inet" is actually for both UDP and SCTP, as well as TCP! */
 	return inet_async_binary_data(desc, hsz, bin, offs, len, extra);
     else
-    {	/* INET_ACTIVE or INET_ONCE: */
+    {	/* INET_ACTIVE, INET_ONCE or INET_MULTI: */
 	if (desc->deliver == INET_DELIVER_PORT)
 	    code = inet_port_binary_data(desc, bin, offs, len);
 	else
 	    code = packet_binary_message(desc, bin, offs, len, extra);
 	if (code < 0)
 	    return code;
-	if (desc->active == INET_ONCE)
-	    desc->active = INET_PASSIVE;
+	inet_active_delivered(desc);
 	return code;
     }
 }
@@ -3322,6 +3516,7 @@ sock_init(void) /* May be called multiple times. */
 static void inet_init_sctp(void) {
     INIT_ATOM(sctp);
     INIT_ATOM(sctp_error);
+    INIT_ATOM(sctp_passive);
     INIT_ATOM(true);
     INIT_ATOM(false);
     INIT_ATOM(buffer);
@@ -3438,9 +3633,7 @@ static int inet_init()
     if (!sock_init())
 	goto error;
 
-    buffer_stack_pos = 0;
-
-    erts_smp_spinlock_init(&inet_buffer_stack_lock, "inet_buffer_stack_lock");
+    init_buffer_pool();
 
     ASSERT(sizeof(struct in_addr) == 4);
 #   if defined(HAVE_IN6) && defined(AF_INET6)
@@ -3463,7 +3656,13 @@ static int inet_init()
     INIT_ATOM(tcp_closed);
     INIT_ATOM(tcp_error);
     INIT_ATOM(udp_error);
+    INIT_ATOM(udp_batch);
+    INIT_ATOM(tcp_passive);
+    INIT_ATOM(udp_passive);
     INIT_ATOM(empty_out_q);
+#ifdef HAVE_SENDFILE
+    INIT_ATOM(sendfile);
+#endif
     INIT_ATOM(ssl_tls);
 
     INIT_ATOM(http_eoh);
@@ -4593,10 +4792,21 @@ static int inet_set_opts(inet_descriptor* desc, char* ptr, int len)
 	    desc->bufsz = ival;
 	    continue;
 
+	case INET_LOPT_ACTIVE_N:
+	    DEBUGF(("inet_set_opts(%ld): s=%d, ACTIVE_N=%d\r\n",
+		    (long)desc->port, desc->s,ival));
+	    if (inet_set_active_n(desc, ival) < 0)
+		return -1;
+	    goto active_changed;
+
 	case INET_LOPT_ACTIVE:
 	    DEBUGF(("inet_set_opts(%ld): s=%d, ACTIVE=%d\r\n",
 		    (long)desc->port, desc->s,ival));
+	    if ((ival < INET_PASSIVE) || (ival > INET_ONCE))
+		return -1;
 	    desc->active = ival;
+	    desc->active_count = 0;
+	active_changed:
 	    if ((desc->stype == SOCK_STREAM) && (desc->active != INET_PASSIVE) && 
 		(desc->state == INET_STATE_CLOSED)) {
 		tcp_closed_message((tcp_descriptor *) desc);
@@ -4697,6 +4907,15 @@ static int inet_set_opts(inet_descriptor* desc, char* ptr, int len)
 	    }
 	    continue;
 
+	case INET_LOPT_TCP_DELAY_SEND_LIMIT:
+	    if (desc->stype == SOCK_STREAM) {
+		tcp_descriptor* tdesc = (tcp_descriptor*) desc;
+		if (ival < 0) ival = 0;
+		else if (ival > INET_MAX_BUFFER*2) ival = INET_MAX_BUFFER*2;
+		tdesc->delay_send_limit = ival;
+	    }
+	    continue;
+
 	case INET_LOPT_UDP_READ_PACKETS:
 	    if (desc->stype == SOCK_DGRAM) {
 		udp_descriptor* udesc = (udp_descriptor*) desc;
@@ -4705,6 +4924,13 @@ static int inet_set_opts(inet_descriptor* desc, char* ptr, int len)
 	    }
 	    continue;
 
+	case INET_LOPT_UDP_BATCH_PACKETS:
+	    if (desc->stype == SOCK_DGRAM) {
+		udp_descriptor* udesc = (udp_descriptor*) desc;
+		udesc->batch_packets = ival;
+	    }
+	    continue;
+
 	case INET_OPT_REUSEADDR: 
 #ifdef __WIN32__
 	    continue;  /* Bjorn says */
@@ -4713,6 +4939,16 @@ static int inet_set_opts(inet_descriptor* desc, char* ptr, int len)
 	    DEBUGF(("inet_set_opts(%ld): s=%d, SO_REUSEADDR=%d\r\n",
 		    (long)desc->port, desc->s,ival));
 	    break;
+#endif
+	case INET_OPT_REUSEPORT:
+#ifdef SO_REUSEPORT
+	    type = SO_REUSEPORT;
+	    propagate = 1; /* binding a shared port fails otherwise */
+	    DEBUGF(("inet_set_opts(%ld): s=%d, SO_REUSEPORT=%d\r\n",
+		    (long)desc->port, desc->s,ival));
+	    break;
+#else
+	    continue;
 #endif
 	case INET_OPT_KEEPALIVE: type = SO_KEEPALIVE;
 	    DEBUGF(("inet_set_opts(%ld): s=%d, SO_KEEPALIVE=%d\r\n",
@@ -4792,6 +5028,20 @@ static int inet_set_opts(inet_descriptor* desc, char* ptr, int len)
 		    (long)desc->port, desc->s, ival));
 	    break;
 
+	case TCP_OPT_NOPUSH:
+#if defined(TCP_CORK)
+	    proto = IPPROTO_TCP;
+	    type = TCP_CORK;
+#elif defined(TCP_NOPUSH)
+	    proto = IPPROTO_TCP;
+	    type = TCP_NOPUSH;
+#else
+	    continue;
+#endif
+	    DEBUGF(("inet_set_opts(%ld): s=%d, TCP_NOPUSH=%d\r\n",
+		    (long)desc->port, desc->s, ival));
+	    break;
+
 #ifdef HAVE_MULTICAST_SUPPORT
 
 	case UDP_OPT_MULTICAST_TTL:
@@ -5026,6 +5276,14 @@ static int sctp_set_opts(inet_descriptor* desc, char* ptr, int len)
 
 	case INET_LOPT_ACTIVE:
 	    desc->active = get_int32(curr);		curr += 4;
+	    desc->active_count = 0;
+	    res = 0;
+	    continue;
+
+	case INET_LOPT_ACTIVE_N:
+	    if (inet_set_active_n(desc, get_int32(curr)) < 0)
+		return -1;
+	    curr += 4;
 	    res = 0;
 	    continue;
 
@@ -5507,8 +5765,15 @@ static int inet_fill_opts(inet_descriptor* desc,
 	    put_int32(desc->deliver, ptr);
 	    continue;
 	case INET_LOPT_ACTIVE:
-	    *ptr++ = opt;
-	    put_int32(desc->active, ptr);
+	    if (desc->active == INET_MULTI) {
+		/* reported as {active, N} */
+		*ptr++ = INET_LOPT_ACTIVE_N;
+		put_int32(desc->active_count, ptr);
+	    }
+	    else {
+		*ptr++ = opt;
+		put_int32(desc->active, ptr);
+	    }
 	    continue;
 	case INET_LOPT_PACKET:
 	    *ptr++ = opt;
@@ -5582,6 +5847,16 @@ static int inet_fill_opts(inet_descriptor* desc,
 	    }
 	    continue;
 
+	case INET_LOPT_TCP_DELAY_SEND_LIMIT:
+	    if (desc->stype == SOCK_STREAM) {
+		*ptr++ = opt;
+		ival = ((tcp_descriptor*)desc)->delay_send_limit;
+		put_int32(ival, ptr);
+	    } else {
+		TRUNCATE_TO(0,ptr);
+	    }
+	    continue;
+
 	case INET_LOPT_UDP_READ_PACKETS:
 	    if (desc->stype == SOCK_DGRAM) {
 		*ptr++ = opt;
@@ -5592,6 +5867,16 @@ static int inet_fill_opts(inet_descriptor* desc,
 	    }
 	    continue;
 
+	case INET_LOPT_UDP_BATCH_PACKETS:
+	    if (desc->stype == SOCK_DGRAM) {
+		*ptr++ = opt;
+		ival = ((udp_descriptor*)desc)->batch_packets;
+		put_int32(ival, ptr);
+	    } else {
+		TRUNCATE_TO(0,ptr);
+	    }
+	    continue;
+
 	case INET_OPT_PRIORITY:
 #ifdef SO_PRIORITY
 	    type = SO_PRIORITY;
@@ -5614,6 +5899,15 @@ static int inet_fill_opts(inet_descriptor* desc,
 	case INET_OPT_REUSEADDR: 
 	    type = SO_REUSEADDR; 
 	    break;
+	case INET_OPT_REUSEPORT:
+#ifdef SO_REUSEPORT
+	    type = SO_REUSEPORT;
+	    break;
+#else
+	    *ptr++ = opt;
+	    put_int32(0, ptr);
+	    continue;
+#endif
 	case INET_OPT_KEEPALIVE: 
 	    type = SO_KEEPALIVE; 
 	    break;
@@ -5636,6 +5930,20 @@ static int inet_fill_opts(inet_descriptor* desc,
 	    proto = IPPROTO_TCP;
 	    type = TCP_NODELAY;
 	    break;
+	case TCP_OPT_NOPUSH:
+#if defined(TCP_CORK)
+	    proto = IPPROTO_TCP;
+	    type = TCP_CORK;
+	    break;
+#elif defined(TCP_NOPUSH)
+	    proto = IPPROTO_TCP;
+	    type = TCP_NOPUSH;
+	    break;
+#else
+	    *ptr++ = opt;
+	    put_int32(0, ptr);
+	    continue;
+#endif
 
 #ifdef HAVE_MULTICAST_SUPPORT
 	case UDP_OPT_MULTICAST_TTL:
@@ -5852,6 +6160,9 @@ static int sctp_fill_opts(inet_descriptor* desc, char* buf, int buflen,
 		case INET_ONCE   :
 		{ i = LOAD_ATOM (spec, i, am_once);  break; }
 
+		case INET_MULTI  :
+		{ i = LOAD_INT  (spec, i, desc->active_count); break; }
+
 		default: ASSERT (0);
 	    }
 	    i = LOAD_TUPLE (spec, i, 2);
@@ -6584,6 +6895,7 @@ static ErlDrvData inet_start(ErlDrvPort port, int size, int protocol)
     desc->bit8    = 0;
     desc->deliver = INET_DELIVER_TERM; /* standard term format */
     desc->active  = INET_PASSIVE;      /* start passive */
+    desc->active_count = 0;
     desc->oph = NULL;
     desc->opt = NULL;
 
@@ -7085,6 +7397,10 @@ static void tcp_clear_output(tcp_descriptor* desc)
     int qsz = driver_sizeq(ix);
 
     driver_deq(ix, qsz);
+#ifdef HAVE_SENDFILE
+    if (TCP_SENDFILE_PENDING(desc))
+	tcp_sendfile_reply(desc, am_closed);
+#endif
     send_empty_out_q_msgs(INETP(desc));
 }
 
@@ -7131,9 +7447,14 @@ static ErlDrvData tcp_inet_start(ErlDrvPort port, char* args)
     desc->i_remain = 0;
     desc->i_bufsz = 0;
     desc->tcp_add_flags = 0;
+    desc->delay_send_limit = 0;
     desc->http_state = 0;
     desc->mtd = NULL;
     desc->multi_first = desc->multi_last = NULL;
+#ifdef HAVE_SENDFILE
+    desc->sendfile.fd = -1;
+    desc->sendfile.caller = 0;
+#endif
     DEBUGF(("tcp_inet_start(%ld) }\r\n", (long)port));
     return (ErlDrvData) desc;
 }
@@ -7175,6 +7496,7 @@ static tcp_descriptor* tcp_inet_copy(tcp_descriptor* desc,SOCKET s,
     copy_desc->low           = desc->low;
     copy_desc->send_timeout  = desc->send_timeout;
     copy_desc->send_timeout_close = desc->send_timeout_close;
+    copy_desc->delay_send_limit = desc->delay_send_limit;
     
     /* The new port will be linked and connected to the original caller */
     port = driver_create_port(port, owner, "tcp_inet", (ErlDrvData) copy_desc);
@@ -7237,6 +7559,10 @@ static void tcp_inet_stop(ErlDrvData e)
     DEBUGF(("tcp_inet_stop(%ld) {s=%d\r\n", 
 	    (long)desc->inet.port, desc->inet.s));
     tcp_close_check(desc);
+#ifdef HAVE_SENDFILE
+    if (TCP_SENDFILE_PENDING(desc))
+	tcp_sendfile_reply(desc, am_closed);
+#endif
     /* free input buffer & output buffer */
     if (desc->i_buf != NULL)
 	release_buffer(desc->i_buf);
@@ -7536,6 +7862,45 @@ static int tcp_inet_ctl(ErlDrvData e, unsigned int cmd, char* buf, int len,
 	}
     }
 #endif
+    case TCP_REQ_SENDFILE: {
+#ifdef HAVE_SENDFILE
+	int fd;
+
+	DEBUGF(("tcp_inet_ctl(%ld): SENDFILE\r\n", (long)desc->inet.port)); 
+	/* INPUT: Fd(4), Offset(8), Length(8), Length 0 == to end of file
+	** The result {sendfile, S, {ok, SentHi, SentLo} | {error, Reason}}
+	** is sent to the caller when the file has been sent.
+	** The driver sends from a duplicate of Fd, so that the file stays
+	** the same even if the caller closes Fd or dies.
+	*/
+	if (!IS_CONNECTED(INETP(desc)))
+	    return ctl_error(ENOTCONN, rbuf, rsize);
+	if (len != 20)
+	    return ctl_error(EINVAL, rbuf, rsize);
+	if (TCP_SENDFILE_PENDING(desc))
+	    return ctl_error(EALREADY, rbuf, rsize);
+	if ((fd = dup((int) get_int32(buf))) < 0)
+	    return ctl_error(errno, rbuf, rsize);
+	desc->sendfile.fd = fd;
+	desc->sendfile.offset = (((Uint64) (Uint32) get_int32(buf+4)) << 32)
+	    | (Uint64) (Uint32) get_int32(buf+8);
+	desc->sendfile.left = (((Uint64) (Uint32) get_int32(buf+12)) << 32)
+	    | (Uint64) (Uint32) get_int32(buf+16);
+	desc->sendfile.to_eof = (desc->sendfile.left == 0);
+	desc->sendfile.sent = 0;
+	desc->sendfile.caller = driver_caller(desc->inet.port);
+	/* Data already queued is sent first */
+	desc->sendfile.qbefore = driver_sizeq(desc->inet.port);
+	if (desc->sendfile.qbefore == 0 && tcp_sendfile_step(desc) < 0) {
+	    /* The socket is closed; {error, closed} has been sent */
+	    DEBUGF(("tcp_inet_ctl(%ld): SENDFILE closed\r\n",
+		    (long)desc->inet.port));
+	}
+	return ctl_reply(INET_REP_OK, NULL, 0, rbuf, rsize);
+#else
+	return ctl_xerror("enotsup", rbuf, rsize);
+#endif
+    }
     default:
 	DEBUGF(("tcp_inet_ctl(%ld): %u\r\n", (long)desc->inet.port, cmd)); 
 	return inet_ctl(INETP(desc), cmd, buf, len, rbuf, rsize);
@@ -7893,8 +8258,9 @@ static int tcp_deliver(tcp_descriptor* desc, int len)
 
 	inet_input_count(INETP(desc), len);
 
-	/* deliver binary? */
-	if (len*4 >= desc->i_buf->orig_size*3) { /* >=75% */
+	/* deliver binary? (the pooled buffer may be larger than i_bufsz) */
+	if ((len >= INET_COPY_LIMIT) &&
+	    (len*4 >= desc->i_bufsz*3)) { /* >=75% */
 	    /* something after? */
 	    if (desc->i_ptr_start + len == desc->i_ptr) { /* no */
 		code = tcp_reply_binary_data(desc, desc->i_buf,
@@ -8489,9 +8855,16 @@ static int tcp_sendv(tcp_descriptor* desc, ErlIOVec* ev)
 	ev->size += h_len;
     }
 
-    if ((sz = driver_sizeq(ix)) > 0) {
+    if ((sz = driver_sizeq(ix)) > 0 || TCP_SENDFILE_PENDING(desc)) {
 	driver_enqv(ix, ev, 0);
-	if (sz+ev->size >= desc->high) {
+	if (TCP_DELAY_SEND_FLUSH(desc, sz, ev->size)) {
+	    if (tcp_inet_output(desc, (HANDLE) desc->inet.event) < 0)
+		return -1;
+	    sz = driver_sizeq(ix);
+	}
+	else
+	    sz += ev->size;
+	if (sz >= desc->high) {
 	    DEBUGF(("tcp_sendv(%ld): s=%d, sender forced busy\r\n",
 		    (long)desc->inet.port, desc->inet.s));
 	    desc->inet.state |= INET_F_BUSY;  /* mark for low-watermark */
@@ -8509,7 +8882,8 @@ static int tcp_sendv(tcp_descriptor* desc, ErlIOVec* ev)
 	
 	DEBUGF(("tcp_sendv(%ld): s=%d, about to send %d,%d bytes\r\n",
 		(long)desc->inet.port, desc->inet.s, h_len, len));
-	if (desc->tcp_add_flags & TCP_ADDF_DELAY_SEND) {
+	if ((desc->tcp_add_flags & TCP_ADDF_DELAY_SEND)
+	    && !TCP_DELAY_SEND_FLUSH(desc, 0, ev->size)) {
 	    n = 0;
 	} else if (sock_sendv(desc->inet.s, ev->iov, vsize, &n, 0) 
 		   == SOCKET_ERROR) {
@@ -8577,11 +8951,18 @@ static int tcp_send(tcp_descriptor* desc, char* ptr, int len)
     inet_output_count(INETP(desc), len+h_len);
 
 
-    if ((sz = driver_sizeq(ix)) > 0) {
+    if ((sz = driver_sizeq(ix)) > 0 || TCP_SENDFILE_PENDING(desc)) {
 	if (h_len > 0)
 	    driver_enq(ix, buf, h_len);
 	driver_enq(ix, ptr, len);
-	if (sz+h_len+len >= desc->high) {
+	if (TCP_DELAY_SEND_FLUSH(desc, sz, h_len+len)) {
+	    if (tcp_inet_output(desc, (HANDLE) desc->inet.event) < 0)
+		return -1;
+	    sz = driver_sizeq(ix);
+	}
+	else
+	    sz += h_len+len;
+	if (sz >= desc->high) {
 	    DEBUGF(("tcp_send(%ld): s=%d, sender forced busy\r\n",
 		    (long)desc->inet.port, desc->inet.s));
 	    desc->inet.state |= INET_F_BUSY;  /* mark for low-watermark */
@@ -8602,7 +8983,8 @@ static int tcp_send(tcp_descriptor* desc, char* ptr, int len)
 
 	DEBUGF(("tcp_send(%ld): s=%d, about to send %d,%d bytes\r\n",
 		(long)desc->inet.port, desc->inet.s, h_len, len));
-	if (desc->tcp_add_flags & TCP_ADDF_DELAY_SEND) {
+	if ((desc->tcp_add_flags & TCP_ADDF_DELAY_SEND)
+	    && !TCP_DELAY_SEND_FLUSH(desc, 0, h_len+len)) {
 	    sock_send(desc->inet.s, buf, 0, 0);
 	    n = 0;
 	} else 	if (sock_sendv(desc->inet.s,iov,2,&n,0) == SOCKET_ERROR) {
@@ -8638,6 +9020,101 @@ static int tcp_send(tcp_descriptor* desc, char* ptr, int len)
     return 0;
 }
 
+#ifdef HAVE_SENDFILE
+/* send:
+**   {sendfile, S, {ok, SentHi, SentLo}} when reason == 0
+**   {sendfile, S, {error, Reason}}      otherwise
+** to the caller of the sendfile request, which is then done, and
+** close the file descriptor duplicated for it
+*/
+static int tcp_sendfile_reply(tcp_descriptor* desc, ErlDrvTermData reason)
+{
+    ErlDrvTermData spec[3*LOAD_ATOM_CNT + LOAD_PORT_CNT + 2*LOAD_UINT_CNT +
+			2*LOAD_TUPLE_CNT];
+    ErlDrvTermData caller = desc->sendfile.caller;
+    int i = 0;
+
+    i = LOAD_ATOM(spec, i, am_sendfile);
+    i = LOAD_PORT(spec, i, desc->inet.dport);
+    if (reason == 0) {
+	i = LOAD_ATOM(spec, i, am_ok);
+	i = LOAD_UINT(spec, i, (ErlDrvUInt) (desc->sendfile.sent >> 32));
+	i = LOAD_UINT(spec, i, (ErlDrvUInt) (desc->sendfile.sent & 0xffffffff));
+	i = LOAD_TUPLE(spec, i, 3);
+    }
+    else {
+	i = LOAD_ATOM(spec, i, am_error);
+	i = LOAD_ATOM(spec, i, reason);
+	i = LOAD_TUPLE(spec, i, 2);
+    }
+    i = LOAD_TUPLE(spec, i, 3);
+    ASSERT(i <= sizeof(spec)/sizeof(*spec));
+
+    while (close(desc->sendfile.fd) < 0 && errno == EINTR)
+	;
+    desc->sendfile.fd = -1;
+    desc->sendfile.caller = 0;
+    return driver_send_term(desc->inet.port, caller, spec, i);
+}
+
+/*
+** Send file data with sendfile(2), i.e. without copying it through
+** user space. Returns 1 when done, i.e. the requested length or end of
+** file has been reached or the file could not be read, 0 if the socket
+** would block or TCP_SENDFILE_MAX_STEP bytes has been sent (output is
+** then selected), and -1 if the socket has been closed.
+*/
+static int tcp_sendfile_step(tcp_descriptor* desc)
+{
+    Uint64 step = 0;
+
+    while (step < TCP_SENDFILE_MAX_STEP) {
+	size_t count = TCP_SENDFILE_MAX_STEP - step;
+	off_t offset = (off_t) desc->sendfile.offset;
+	ssize_t n;
+
+	if (!desc->sendfile.to_eof && desc->sendfile.left < count)
+	    count = (size_t) desc->sendfile.left;
+	n = sendfile(desc->inet.s, desc->sendfile.fd, &offset, count);
+	if (n < 0) {
+	    int err = errno;
+	    if (err == EINTR)
+		continue;
+	    if (err == ERRNO_BLOCK) {
+		sock_select(INETP(desc), (FD_WRITE|FD_CLOSE), 1);
+		return 0;
+	    }
+	    DEBUGF(("tcp_sendfile_step(%ld): s=%d, errno = %d\r\n",
+		    (long)desc->inet.port, desc->inet.s, err));
+	    if (err == EPIPE || err == ECONNRESET) {
+		tcp_sendfile_reply(desc, am_closed);
+		return tcp_send_error(desc, err);
+	    }
+	    /* A file error; the socket is still usable */
+	    tcp_sendfile_reply(desc, error_atom(err));
+	    return 1;
+	}
+	if (n == 0) { /* end of file */
+	    tcp_sendfile_reply(desc, 0);
+	    return 1;
+	}
+	inet_output_count(INETP(desc), n);
+	desc->sendfile.offset += n;
+	desc->sendfile.sent += n;
+	step += n;
+	if (!desc->sendfile.to_eof) {
+	    desc->sendfile.left -= n;
+	    if (desc->sendfile.left == 0) {
+		tcp_sendfile_reply(desc, 0);
+		return 1;
+	    }
+	}
+    }
+    sock_select(INETP(desc), (FD_WRITE|FD_CLOSE), 1);
+    return 0;
+}
+#endif
+
 static void tcp_inet_drv_output(ErlDrvData data, ErlDrvEvent event)
 {
     (void)tcp_inet_output((tcp_descriptor*)data, (HANDLE)event);
@@ -8656,6 +9133,9 @@ static int tcp_inet_output(tcp_descriptor* desc, HANDLE event)
 {
     int ret = 0;
     ErlDrvPort ix = desc->inet.port;
+#ifdef HAVE_SENDFILE
+    SysIOVec one_iov;
+#endif
 
     DEBUGF(("tcp_inet_output(%ld) {s=%d\r\n", 
 	    (long)desc->inet.port, desc->inet.s));
@@ -8711,12 +9191,34 @@ static int tcp_inet_output(tcp_descriptor* desc, HANDLE event)
 	    int n;
 	    SysIOVec* iov;
 
+#ifdef HAVE_SENDFILE
+	    if (TCP_SENDFILE_PENDING(desc) && desc->sendfile.qbefore == 0) {
+		if ((ret = tcp_sendfile_step(desc)) <= 0)
+		    goto done;
+		ret = 0;
+	    }
+#endif
 	    if ((iov = driver_peekq(ix, &vsize)) == NULL) {
 		sock_select(INETP(desc), FD_WRITE, 0);
 		send_empty_out_q_msgs(INETP(desc));
 		goto done;
 	    }
 	    vsize = vsize > MAX_VSIZE ? MAX_VSIZE : vsize;
+#ifdef HAVE_SENDFILE
+	    if (TCP_SENDFILE_PENDING(desc)) {
+		/* Only send what was queued before the file */
+		int k, qbefore = desc->sendfile.qbefore;
+		for (k = 0; k < vsize && iov[k].iov_len <= qbefore; k++)
+		    qbefore -= iov[k].iov_len;
+		if (k == 0) {
+		    one_iov.iov_base = iov[0].iov_base;
+		    one_iov.iov_len = desc->sendfile.qbefore;
+		    iov = &one_iov;
+		    k = 1;
+		}
+		vsize = k;
+	    }
+#endif
 	    DEBUGF(("tcp_inet_output(%ld): s=%d, About to send %d items\r\n", 
 		    (long)desc->inet.port, desc->inet.s, vsize));
 	    if (sock_sendv(desc->inet.s, iov, vsize, &n, 0)==SOCKET_ERROR) {
@@ -8731,6 +9233,10 @@ static int tcp_inet_output(tcp_descriptor* desc, HANDLE event)
 #endif
 		goto done;
 	    }
+#ifdef HAVE_SENDFILE
+	    if (TCP_SENDFILE_PENDING(desc))
+		desc->sendfile.qbefore -= n;
+#endif
 	    if (driver_deq(ix, n) <= desc->low) {
 		if (IS_BUSY(INETP(desc))) {
 		    desc->inet.caller = desc->inet.busy_caller;
@@ -8818,6 +9324,7 @@ static ErlDrvData packet_inet_start(ErlDrvPort port, char* args, int protocol)
 	return ERL_DRV_ERROR_ERRNO;
 
     desc->read_packets = INET_PACKET_POLL;
+    desc->batch_packets = 0;
     return drvd;
 }
 
@@ -8859,6 +9366,108 @@ static int packet_error(udp_descriptor* udesc, int err)
 /*
 ** Various functions accessible via "port_control" on the Erlang side:
 */
+/*
+** Send a number of datagrams in one request (UDP_REQ_SENDMANY).
+** input: repeated [Port(2), IP(4|16), Len(4), Data(Len)]
+** Datagrams are handed to the kernel UDP_MAX_BATCH at a time with
+** sendmmsg() where available. Sending stops when the socket would block;
+** the number of datagrams actually sent is returned, Count(4).
+*/
+static int udp_sendmany(inet_descriptor* desc, char* buf, int len,
+			char** rbuf, int rsize)
+{
+    inet_address addr[UDP_MAX_BATCH];
+    int alen[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+#endif
+    int connected = (desc->state & INET_F_ACTIVE);
+    char tbuf[4];
+    char* ptr;
+    int left;
+    int sent = 0;
+    int err = 0;
+
+    /* Check the whole request before sending anything */
+    for (ptr = buf, left = len; left > 0; ) {
+	int sz = left;
+	char* qtr;
+	unsigned int dlen;
+
+	if ((qtr = inet_set_address(desc->sfamily, &addr[0], ptr, &sz)) == NULL)
+	    return ctl_error(EINVAL, rbuf, rsize);
+	left -= (qtr - ptr);
+	if (left < 4)
+	    return ctl_error(EINVAL, rbuf, rsize);
+	dlen = get_int32(qtr);
+	left -= 4;
+	if (dlen > (unsigned int) left)
+	    return ctl_error(EINVAL, rbuf, rsize);
+	left -= dlen;
+	ptr = qtr + 4 + dlen;
+    }
+
+    for (ptr = buf, left = len; (left > 0) && (err == 0); ) {
+	int n = 0;
+	int code;
+	int k;
+
+	while ((left > 0) && (n < UDP_MAX_BATCH)) {
+	    char* qtr;
+	    unsigned int dlen;
+
+	    alen[n] = left;
+	    qtr = inet_set_address(desc->sfamily, &addr[n], ptr, &alen[n]);
+	    dlen = get_int32(qtr);
+	    iov[n].iov_base = qtr + 4;
+	    iov[n].iov_len  = dlen;
+	    left -= (qtr + 4 + dlen) - ptr;
+	    ptr = qtr + 4 + dlen;
+	    n++;
+	}
+
+#ifdef HAVE_SENDMMSG
+	for (k = 0; k < n; k++) {
+	    msgs[k].msg_hdr.msg_name       = connected ? NULL : &addr[k];
+	    msgs[k].msg_hdr.msg_namelen    = connected ? 0 : alen[k];
+	    msgs[k].msg_hdr.msg_iov        = &iov[k];
+	    msgs[k].msg_hdr.msg_iovlen     = 1;
+	    msgs[k].msg_hdr.msg_control    = NULL;
+	    msgs[k].msg_hdr.msg_controllen = 0;
+	    msgs[k].msg_hdr.msg_flags      = 0;
+	}
+	code = sendmmsg(desc->s, msgs, n, 0);
+	if (code == SOCKET_ERROR)
+	    err = sock_errno();
+#else
+	for (code = 0; code < n; code++) {
+	    int r;
+	    if (connected)
+		r = sock_send(desc->s, iov[code].iov_base, iov[code].iov_len, 0);
+	    else
+		r = sock_sendto(desc->s, iov[code].iov_base, iov[code].iov_len,
+				0, &addr[code].sa, alen[code]);
+	    if (r == SOCKET_ERROR) {
+		err = sock_errno();
+		break;
+	    }
+	}
+#endif
+	for (k = 0; k < code; k++)
+	    inet_output_count(desc, iov[k].iov_len);
+	if (code > 0)
+	    sent += code;
+	if ((err == 0) && (code < n))
+	    break;
+    }
+
+    if ((err != 0) && (err != ERRNO_BLOCK) && (sent == 0))
+	return ctl_error(err, rbuf, rsize);
+    put_int32(sent, tbuf);
+    return ctl_reply(INET_REP_OK, tbuf, 4, rbuf, rsize);
+}
+
 static int packet_inet_ctl(ErlDrvData e, unsigned int cmd, char* buf, int len,
 			   char** rbuf, int rsize)
 {
@@ -9113,6 +9722,14 @@ static int packet_inet_ctl(ErlDrvData e, unsigned int cmd, char* buf, int len,
 	}
 #endif  /* HAVE_SCTP */
 
+    case UDP_REQ_SENDMANY:
+	DEBUGF(("packet_inet_ctl(%ld): SENDMANY\r\n", (long)desc->port)); 
+	if (!IS_OPEN(desc))
+	    return ctl_xerror(EXBADPORT, rbuf, rsize);
+	if (!IS_BOUND(desc) || (type != SOCK_DGRAM))
+	    return ctl_error(EINVAL, rbuf, rsize);
+	return udp_sendmany(desc, buf, len, rbuf, rsize);
+
     case PACKET_REQ_RECV:
 	{	/* THIS IS A FRONT-END for "recv*" requests. It only enqueues the
 		   request  and possibly returns the data  immediately available.
@@ -9301,6 +9918,173 @@ static void packet_inet_drv_input(ErlDrvData e, ErlDrvEvent event)
     (void)  packet_inet_input((udp_descriptor*)e, (HANDLE)event);
 }
 
+#ifdef HAVE_RECVMMSG
+
+#define UDP_BATCH_TERM_DATA_LEN						\
+    (LOAD_ATOM_CNT + LOAD_PORT_CNT +					\
+     UDP_MAX_BATCH*(8*LOAD_INT_CNT + LOAD_TUPLE_CNT + LOAD_INT_CNT +	\
+		    LOAD_BINARY_CNT + LOAD_STRING_CONS_CNT + LOAD_TUPLE_CNT) + \
+     LOAD_NIL_CNT + LOAD_LIST_CNT + LOAD_TUPLE_CNT)
+
+/*
+** active mode message for batch_packets:
+**        {udp_batch, S, [{IP, Port, [H1,...Hsz | Data]}, ...]}
+** bufs[k] holds Family(1), Port(2), IP(4|16) and the data at offs[k].
+*/
+static int udp_batch_message(inet_descriptor* desc, ErlDrvBinary** bufs,
+			     int* offs, int* lens, int n)
+{
+    ErlDrvTermData spec[UDP_BATCH_TERM_DATA_LEN];
+    unsigned int hsz = desc->hsz;
+    int alen = addrlen(desc->sfamily);
+    int i = 0;
+    int k;
+
+    i = LOAD_ATOM(spec, i, am_udp_batch);
+    i = LOAD_PORT(spec, i, desc->dport);
+    for (k = 0; k < n; k++) {
+	char* ptr = bufs[k]->orig_bytes + offs[k];
+	int doffs = offs[k] + alen + 3;
+	int len = lens[k] - (alen + 3);
+
+	scanbit8(desc, ptr, lens[k]);
+	i = load_ip_address(spec, i, desc->sfamily, ptr+3);
+	i = load_ip_port(spec, i, ptr+1);
+	if ((desc->mode == INET_MODE_LIST) || (hsz > len))
+	    i = LOAD_STRING(spec, i, bufs[k]->orig_bytes+doffs, len);
+	else {
+	    i = LOAD_DATA(spec, i, bufs[k], doffs+hsz, len-hsz);
+	    if (hsz > 0)
+		i = LOAD_STRING_CONS(spec, i, bufs[k]->orig_bytes+doffs, hsz);
+	}
+	i = LOAD_TUPLE(spec, i, 3);
+    }
+    i = LOAD_NIL(spec, i);
+    i = LOAD_LIST(spec, i, n+1);
+    i = LOAD_TUPLE(spec, i, 3);
+    ASSERT(i <= UDP_BATCH_TERM_DATA_LEN);
+    return driver_output_term(desc->port, spec, i);
+}
+
+/*
+** Active mode input for UDP: read up to read_packets datagrams using
+** recvmmsg(), UDP_MAX_BATCH at a time. Each datagram gets a buffer of
+** its own so it can be passed on as a binary without copying.
+*/
+static int udp_inet_input_mmsg(udp_descriptor* udesc)
+{
+    inet_descriptor* desc = INETP(udesc);
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+    inet_address other[UDP_MAX_BATCH];
+    ErlDrvBinary* bufs[UDP_MAX_BATCH];
+    int offs[UDP_MAX_BATCH];
+    int lens[UDP_MAX_BATCH];
+    char abuf[sizeof(inet_address)];
+    unsigned int len = sizeof(inet_address);
+    int sz = desc->bufsz;
+    int packet_count = udesc->read_packets;
+    int count = 0;     /* number of packets delivered to owner */
+
+    while(packet_count > 0) {
+	int want = (packet_count < UDP_MAX_BATCH) ? packet_count : UDP_MAX_BATCH;
+	int code = 0;
+	int n;
+	int k;
+
+	/* Do not read more than {active,once} or {active,N} may deliver */
+	if (!(udesc->batch_packets && (desc->deliver == INET_DELIVER_TERM))) {
+	    if (desc->active == INET_ONCE)
+		want = 1;
+	    else if ((desc->active == INET_MULTI) &&
+		     (desc->active_count < want))
+		want = desc->active_count;
+	}
+
+	for (k = 0; k < want; k++) {
+	    if ((bufs[k] = alloc_buffer(sz+len)) == NULL) {
+		while(k--)
+		    release_buffer(bufs[k]);
+		return packet_error(udesc, ENOMEM);
+	    }
+	    iov[k].iov_base = bufs[k]->orig_bytes + len;
+	    iov[k].iov_len  = sz;
+	    msgs[k].msg_hdr.msg_name       = &other[k];
+	    msgs[k].msg_hdr.msg_namelen    = len;
+	    msgs[k].msg_hdr.msg_iov        = &iov[k];
+	    msgs[k].msg_hdr.msg_iovlen     = 1;
+	    msgs[k].msg_hdr.msg_control    = NULL;
+	    msgs[k].msg_hdr.msg_controllen = 0;
+	    msgs[k].msg_hdr.msg_flags      = 0;
+	}
+
+	n = recvmmsg(desc->s, msgs, want, 0, NULL);
+	if (n == SOCKET_ERROR) {
+	    int err = sock_errno();
+	    for (k = 0; k < want; k++)
+		release_buffer(bufs[k]);
+	    if (err != ERRNO_BLOCK)
+		packet_error_message(udesc, err);
+	    return count;
+	}
+	for (k = n; k < want; k++)
+	    release_buffer(bufs[k]);
+
+	for (k = 0; k < n; k++) {
+	    unsigned int alen = len;
+	    int m = msgs[k].msg_len;
+
+	    inet_input_count(desc, m);
+	    if (msgs[k].msg_hdr.msg_namelen == 0)
+		other[k] = desc->remote;
+	    inet_get_address(desc->sfamily, abuf, &other[k], &alen);
+	    ASSERT (alen <= len);
+	    sys_memcpy(bufs[k]->orig_bytes + len - alen, abuf, alen);
+	    offs[k] = len - alen;
+	    lens[k] = m + alen;
+
+	    /* Check if we need to reallocate binary (small data is copied) */
+	    if ((desc->mode == INET_MODE_BINARY) &&
+		(desc->hsz < m) && (m - desc->hsz >= INET_COPY_LIMIT) &&
+		(lens[k] < BIN_REALLOC_LIMIT(sz))) {
+		ErlDrvBinary* tmp;
+		if ((tmp = realloc_buffer(bufs[k],lens[k]+offs[k])) != NULL)
+		    bufs[k] = tmp;
+	    }
+	}
+
+	if (udesc->batch_packets && (desc->deliver == INET_DELIVER_TERM)) {
+	    if ((code = udp_batch_message(desc, bufs, offs, lens, n)) >= 0) {
+		count += n;
+		inet_active_delivered(desc);
+	    }
+	}
+	else {
+	    for (k = 0; (k < n) && (code >= 0); k++) {
+		code = packet_reply_binary_data(desc, len - offs[k], bufs[k],
+						offs[k], lens[k], NULL);
+		if (code >= 0)
+		    count++;
+	    }
+	}
+	for (k = 0; k < n; k++)
+	    free_buffer(bufs[k]);
+
+	if (code < 0)
+	    return count;
+	if (!desc->active) {
+	    driver_cancel_timer(desc->port); /* possibly cancel */
+	    sock_select(desc,FD_READ,0);
+	    return count;
+	}
+	if (n < want)
+	    return count;  /* drained */
+	packet_count -= n;
+    }
+    return count;
+}
+#endif
+
 /*
 ** THIS IS A BACK-END FOR "recv*" REQUEST, which actually receives the
 **	data requested, and delivers them to the caller:
@@ -9324,6 +10108,15 @@ static int packet_inet_input(udp_descriptor* udesc, HANDLE event)
     int short_recv = 0;
 #endif
 
+#ifdef HAVE_RECVMMSG
+    if (desc->active
+#ifdef HAVE_SCTP
+	&& !IS_SCTP(desc)
+#endif
+	)
+	return udp_inet_input_mmsg(udesc);
+#endif
+
     while(packet_count--) {
 	len = sizeof(other);
 	sz = desc->bufsz;
@@ -9418,9 +10211,15 @@ static int packet_inet_input(udp_descriptor* udesc, HANDLE event)
 	    nsz  = n + alen;              /* nsz = data + address */
 	    offs = ptr - buf->orig_bytes; /* initial pointer offset */
 
-	    /* Check if we need to reallocate binary */
+	    /* Check if we need to reallocate binary (small udp data is copied) */
 	    if ((desc->mode == INET_MODE_BINARY) &&
-		(desc->hsz < n) && (nsz < BIN_REALLOC_LIMIT(sz))) {
+		(desc->hsz < n) && (nsz < BIN_REALLOC_LIMIT(sz))
+#ifdef HAVE_SCTP
+		&& (IS_SCTP(desc) || (n - desc->hsz >= INET_COPY_LIMIT))
+#else
+		&& (n - desc->hsz >= INET_COPY_LIMIT)
+#endif
+		) {
 		ErlDrvBinary* tmp;
 		if ((tmp = realloc_buffer(buf,nsz+offs)) != NULL)
 		    buf = tmp;
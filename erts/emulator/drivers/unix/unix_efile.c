@@ -83,6 +83,21 @@ extern STATUS copy(char *, char *);
 #define MAXIOV 16
 #endif
 
+#if defined(HAVE_MMAP) && !defined(VXWORKS) && !defined(_OSE_)
+#include <sys/mman.h>
+#define EFILE_HAVE_MMAP
+#endif
+
+#if defined(__linux__) && !defined(_OSE_)
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#include <limits.h>
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+#define HAVE_IO_URING
+#endif
+#endif
+
 
 /*
  * Macros for testing file types.
@@ -1273,6 +1288,383 @@ efile_pwrite(Efile_error* errInfo,  /* Where to return error codes. */
 #endif
 }
 
+#ifdef HAVE_IO_URING
+
+/*
+ * Batches of positional reads and writes are handed to an io_uring
+ * owned by the calling thread, so that the kernel works on all of them
+ * at once instead of one pread() or pwrite() system call at a time.
+ * The ring is created on first use and lives as long as the thread.
+ * If the ring fails, the thread goes back to system calls for good.
+ * Single reads and writes, and syncs, always use system calls.
+ */
+
+#define EFILE_RING_ENTRIES 64
+#define EFILE_RING_NOT_DONE INT_MIN
+
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+} EfileRing;
+
+static ErlDrvTSDKey efile_ring_key;
+static int efile_ring_key_created = 0;
+static EfileRing efile_no_ring;	/* Thread failed to set up a ring */
+
+static EfileRing *
+efile_ring(void)
+{
+    struct io_uring_params p;
+    EfileRing *r;
+    char *sq, *cq;
+    void *sqes;
+    size_t sq_sz, cq_sz;
+    int fd;
+
+    if (!efile_ring_key_created)
+	return NULL;
+    r = (EfileRing *) erl_drv_tsd_get(efile_ring_key);
+    if (r)
+	return r == &efile_no_ring ? NULL : r;
+
+    erl_drv_tsd_set(efile_ring_key, (void *) &efile_no_ring);
+
+    memset((void *) &p, 0, sizeof(p));
+    fd = syscall(__NR_io_uring_setup, EFILE_RING_ENTRIES, &p);
+    if (fd < 0)
+	return NULL;
+
+    sq_sz = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+    cq_sz = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+#ifdef IORING_FEAT_SINGLE_MMAP
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+	if (cq_sz > sq_sz)
+	    sq_sz = cq_sz;
+	cq_sz = sq_sz;
+    }
+#endif
+    sq = mmap(NULL, sq_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+	      fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+	goto fail_sq;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+	cq = sq;
+    else
+#endif
+    {
+	cq = mmap(NULL, cq_sz, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+		  fd, IORING_OFF_CQ_RING);
+	if (cq == MAP_FAILED)
+	    goto fail_cq;
+    }
+    sqes = mmap(NULL, p.sq_entries*sizeof(struct io_uring_sqe),
+		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+		fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+	goto fail_sqes;
+    r = (EfileRing *) driver_alloc(sizeof(EfileRing));
+    if (!r)
+	goto fail_alloc;
+
+    r->fd = fd;
+    r->entries = p.sq_entries;
+    r->sq_head = (unsigned *) (sq + p.sq_off.head);
+    r->sq_tail = (unsigned *) (sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *) (sq + p.sq_off.array);
+    r->cq_head = (unsigned *) (cq + p.cq_off.head);
+    r->cq_tail = (unsigned *) (cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+    r->sqes = (struct io_uring_sqe *) sqes;
+    if (r->entries > EFILE_RING_ENTRIES)
+	r->entries = EFILE_RING_ENTRIES;
+    erl_drv_tsd_set(efile_ring_key, (void *) r);
+    return r;
+
+ fail_alloc:
+    munmap(sqes, p.sq_entries*sizeof(struct io_uring_sqe));
+ fail_sqes:
+    if (cq != sq)
+	munmap(cq, cq_sz);
+ fail_cq:
+    munmap(sq, sq_sz);
+ fail_sq:
+    close(fd);
+    return NULL;
+}
+
+/*
+ * Submit one chunk of at most r->entries operations and wait for all
+ * of them. res[i] gets the result of io[i] as returned by the kernel,
+ * or EFILE_RING_NOT_DONE if the operation was never submitted and has
+ * to be done synchronously by the caller. Returns 0 if io_uring_enter()
+ * failed, after which the ring should not be used again.
+ */
+static int
+efile_ring_chunk(EfileRing *r, int op, int fd, Efile_io *io, int n, int *res)
+{
+    struct iovec iov[EFILE_RING_ENTRIES];
+    unsigned tail, head, mask;
+    int i, submit, wait, ret;
+    int failed = 0;
+
+    tail = *r->sq_tail;
+    mask = *r->sq_mask;
+    for (i = 0; i < n; i++) {
+	struct io_uring_sqe *sqe = &r->sqes[(tail + i) & mask];
+	iov[i].iov_base = io[i].buf;
+	iov[i].iov_len = io[i].count;
+	memset((void *) sqe, 0, sizeof(*sqe));
+	sqe->opcode = op;
+	sqe->fd = fd;
+	sqe->off = (__u64) io[i].offset;
+	sqe->addr = (__u64) (unsigned long) &iov[i];
+	sqe->len = 1;
+	sqe->user_data = (__u64) i;
+	r->sq_array[(tail + i) & mask] = (tail + i) & mask;
+	res[i] = EFILE_RING_NOT_DONE;
+    }
+    __sync_synchronize();
+    *r->sq_tail = tail + n;
+    __sync_synchronize();
+
+    submit = n;
+    wait = n;
+    while (wait > 0) {
+	if (failed) {
+	    /*
+	     * The kernel cannot be asked to wait, but the operations
+	     * in flight use the caller's buffers. Poll for them.
+	     */
+	    usleep(100);
+	} else {
+	    ret = syscall(__NR_io_uring_enter, r->fd, submit, 1,
+			  IORING_ENTER_GETEVENTS, NULL, 0);
+	    if (ret >= 0)
+		submit -= ret;
+	    else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+		/*
+		 * Take back what the kernel has not consumed; the caller
+		 * does those operations synchronously.
+		 */
+		failed = 1;
+		__sync_synchronize();
+		head = *r->sq_head;
+		*r->sq_tail = head;
+		__sync_synchronize();
+		wait -= submit;
+		submit = 0;
+	    }
+	}
+	__sync_synchronize();
+	head = *r->cq_head;
+	while (head != *r->cq_tail) {
+	    struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+	    res[cqe->user_data] = cqe->res;
+	    head++;
+	    wait--;
+	}
+	*r->cq_head = head;
+	__sync_synchronize();
+    }
+    return !failed;
+}
+
+/*
+ * Operations in a chunk run in any order, so writes to overlapping
+ * ranges must be done one at a time for the last one to win.
+ */
+static int
+efile_ring_overlap(Efile_io *io, int n)
+{
+    int i, j;
+    for (i = 1; i < n; i++) {
+	for (j = 0; j < i; j++) {
+	    if (io[i].offset < io[j].offset + (Sint64) io[j].count
+		&& io[j].offset < io[i].offset + (Sint64) io[i].count)
+		return 1;
+	}
+    }
+    return 0;
+}
+
+/*
+ * Returns 0 with errInfo set on error, 1 when all operations are done,
+ * and -1 when the batch has to be done synchronously.
+ */
+static int
+efile_ring_batch(Efile_error* errInfo, int write, int fd, Efile_io* io, int n)
+{
+    int res[EFILE_RING_ENTRIES];
+    EfileRing *r;
+    int i, j, chunk, entries;
+
+    for (i = 0; i < n; i++) {
+	off_t off = (off_t) io[i].offset;
+	/* A negative offset means the current position to io_uring */
+	if (io[i].offset < 0 || off != io[i].offset || io[i].count > INT_MAX)
+	    return -1;
+    }
+    if ((r = efile_ring()) == NULL)
+	return -1;
+    entries = (int) r->entries;
+
+    for (i = 0; i < n; i += chunk) {
+	chunk = n - i > entries ? entries : n - i;
+	if (!r || (write && efile_ring_overlap(io + i, chunk))) {
+	    for (j = 0; j < chunk; j++)
+		res[j] = EFILE_RING_NOT_DONE;
+	} else if (!efile_ring_chunk(r, write ? IORING_OP_WRITEV
+				     : IORING_OP_READV,
+				     fd, io + i, chunk, res)) {
+	    /* The rest of the batch, and later ones, use system calls */
+	    erl_drv_tsd_set(efile_ring_key, (void *) &efile_no_ring);
+	    r = NULL;
+	}
+	for (j = 0; j < chunk; j++) {
+	    Efile_io *p = &io[i + j];
+	    if (res[j] == -EINTR || res[j] == -EAGAIN)
+		res[j] = EFILE_RING_NOT_DONE;
+	    if (res[j] == EFILE_RING_NOT_DONE) {
+		if (write
+		    ? !efile_pwrite(errInfo, fd, p->buf, p->count, p->offset)
+		    : !efile_pread(errInfo, fd, p->offset, p->buf, p->count,
+				   &p->result))
+		    return 0;
+	    } else if (res[j] < 0) {
+		errno = -res[j];
+		return check_error(-1, errInfo);
+	    } else if (!write) {
+		p->result = (size_t) res[j];
+	    } else if ((size_t) res[j] < p->count
+		       && !efile_pwrite(errInfo, fd, p->buf + res[j],
+					p->count - res[j], p->offset + res[j])) {
+		return 0;
+	    }
+	    if (write)
+		p->result = p->count;
+	}
+    }
+    return 1;
+}
+
+#endif /* HAVE_IO_URING */
+
+void
+efile_init(void)
+{
+#ifdef HAVE_IO_URING
+    if (erl_drv_tsd_key_create("efile_ring", &efile_ring_key) == 0)
+	efile_ring_key_created = 1;
+#endif
+}
+
+int
+efile_pwrite_batch(Efile_error* errInfo, /* Where to return error codes. */
+		   int fd,		 /* File descriptor to write to. */
+		   Efile_io* io,	 /* Writes to do. */
+		   int n)		 /* Number of writes. */
+{
+    int i;
+#ifdef HAVE_IO_URING
+    if (n > 1) {
+	int res = efile_ring_batch(errInfo, 1, fd, io, n);
+	if (res >= 0)
+	    return res;
+    }
+#endif
+    for (i = 0; i < n; i++) {
+	if (!efile_pwrite(errInfo, fd, io[i].buf, io[i].count, io[i].offset))
+	    return 0;
+	io[i].result = io[i].count;
+    }
+    return 1;
+}
+
+int
+efile_pread_batch(Efile_error* errInfo, /* Where to return error codes. */
+		  int fd,		/* File descriptor to read from. */
+		  Efile_io* io,		/* Reads to do. */
+		  int n)		/* Number of reads. */
+{
+    int i;
+#ifdef HAVE_IO_URING
+    if (n > 1) {
+	int res = efile_ring_batch(errInfo, 0, fd, io, n);
+	if (res >= 0)
+	    return res;
+    }
+#endif
+    for (i = 0; i < n; i++) {
+	if (!efile_pread(errInfo, fd, io[i].offset, io[i].buf, io[i].count,
+			 &io[i].result))
+	    return 0;
+    }
+    return 1;
+}
+
+/*
+ * Maps the whole file read only. An empty file gives a NULL mapping.
+ * Reading a page of the mapping that a truncation of the file has cut
+ * off raises SIGBUS, which kills the emulator; there is no guard
+ * against that here, which is why file:open/2 only takes the mode as
+ * {mmap, unsafe}.
+ */
+int
+efile_mmap(Efile_error* errInfo,    /* Where to return error codes. */
+	   int fd,		    /* File descriptor to map. */
+	   char** pData,	    /* Where to return the mapping. */
+	   Sint64* pSize)	    /* Where to return its size. */
+{
+#ifdef EFILE_HAVE_MMAP
+    struct stat statbuf;
+    void *p;
+
+    if (fstat(fd, &statbuf) < 0)
+	return check_error(-1, errInfo);
+    if (!ISREG(statbuf)) {
+	errno = EINVAL;
+	return check_error(-1, errInfo);
+    }
+    if ((off_t) (size_t) statbuf.st_size != statbuf.st_size) {
+	errno = ENOMEM;
+	return check_error(-1, errInfo);
+    }
+    *pData = NULL;
+    *pSize = (Sint64) statbuf.st_size;
+    if (statbuf.st_size == 0)
+	return 1;
+    p = mmap(NULL, (size_t) statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+	return check_error(-1, errInfo);
+    *pData = (char *) p;
+    return 1;
+#else
+    errno = ENOTSUP;
+    return check_error(-1, errInfo);
+#endif
+}
+
+void
+efile_munmap(char* data, Sint64 size)
+{
+#ifdef EFILE_HAVE_MMAP
+    if (data)
+	munmap((void *) data, (size_t) size);
+#endif
+}
+
 
 int
 efile_seek(Efile_error* errInfo,      /* Where to return error codes. */
@@ -1058,6 +1058,86 @@ size_t* pBytesRead;		/* Where to return number of bytes read. */
     }
 }
 
+void
+efile_init()
+{
+}
+
+/* Batches are done one operation at a time */
+int
+efile_pwrite_batch(errInfo, fd, io, n)
+Efile_error* errInfo;		/* Where to return error codes. */
+int fd;				/* File descriptor to write to. */
+Efile_io* io;			/* Writes to do. */
+int n;				/* Number of writes. */
+{
+    int i;
+    for (i = 0; i < n; i++) {
+	if (!efile_pwrite(errInfo, fd, io[i].buf, io[i].count, io[i].offset))
+	    return 0;
+	io[i].result = io[i].count;
+    }
+    return 1;
+}
+
+int
+efile_pread_batch(errInfo, fd, io, n)
+Efile_error* errInfo;		/* Where to return error codes. */
+int fd;				/* File descriptor to read from. */
+Efile_io* io;			/* Reads to do. */
+int n;				/* Number of reads. */
+{
+    int i;
+    for (i = 0; i < n; i++) {
+	if (!efile_pread(errInfo, fd, io[i].offset, io[i].buf, io[i].count,
+			 &io[i].result))
+	    return 0;
+    }
+    return 1;
+}
+
+/* Maps the whole file read only. An empty file gives a NULL mapping. */
+int
+efile_mmap(errInfo, fd, pData, pSize)
+Efile_error* errInfo;		/* Where to return error codes. */
+int fd;				/* File descriptor to map. */
+char** pData;			/* Where to return the mapping. */
+Sint64* pSize;			/* Where to return its size. */
+{
+    LARGE_INTEGER size;
+    HANDLE map;
+    char* p;
+
+    if (!GetFileSizeEx((HANDLE) fd, &size))
+	return set_error(errInfo);
+    *pData = NULL;
+    *pSize = (Sint64) size.QuadPart;
+    if (size.QuadPart == 0)
+	return 1;
+    map = CreateFileMapping((HANDLE) fd, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (map == NULL)
+	return set_error(errInfo);
+    p = (char *) MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (p == NULL) {
+	set_error(errInfo);
+	CloseHandle(map);
+	return 0;
+    }
+    /* The view keeps the mapping object alive */
+    CloseHandle(map);
+    *pData = p;
+    return 1;
+}
+
+void
+efile_munmap(data, size)
+char* data;
+Sint64 size;
+{
+    if (data)
+	UnmapViewOfFile(data);
+}
+
 
 
 int
@@ -69,12 +69,21 @@ typedef char EventStateFlags;
 #define ERTS_CIO_POLL_INTR 	ERTS_POLL_EXPORT(erts_poll_interrupt)
 #define ERTS_CIO_POLL_INTR_TMD	ERTS_POLL_EXPORT(erts_poll_interrupt_timed)
 #define ERTS_CIO_NEW_POLLSET 	ERTS_POLL_EXPORT(erts_poll_create_pollset)
+#define ERTS_CIO_POLL_ONESHOT	ERTS_POLL_EXPORT(erts_poll_use_oneshot)
 #define ERTS_CIO_FREE_POLLSET	ERTS_POLL_EXPORT(erts_poll_destroy_pollset)
 #define ERTS_CIO_POLL_MAX_FDS	ERTS_POLL_EXPORT(erts_poll_max_fds)
 #define ERTS_CIO_POLL_INIT	ERTS_POLL_EXPORT(erts_poll_init)
 #define ERTS_CIO_POLL_INFO	ERTS_POLL_EXPORT(erts_poll_info)
 
-static struct pollset_info
+/*
+ * The fds are spread over erts_no_pollsets pollsets. An fd is put in the
+ * pollset of the port selecting it (by port index) when it enters a
+ * pollset, and stays there until it has left it. pollsets[0] is polled by
+ * the schedulers in erts_check_io(); the others are polled by poll
+ * threads of their own. When erts_use_poll_threads is set, no fds are
+ * put in pollsets[0]; the schedulers then only use it for waiting.
+ */
+struct pollset_info
 {
     ErtsPollSet ps;
     erts_smp_atomic_t in_poll_wait;        /* set while doing poll */
@@ -82,8 +91,23 @@ static struct pollset_info
     struct removed_fd* removed_list;       /* list of deselected fd's*/
     erts_smp_spinlock_t removed_list_lock;
 #endif
-}pollset;
-#define NUM_OF_POLLSETS 1
+};
+
+static union {
+    struct pollset_info psi;
+    byte _cache_line_alignment[ERTS_ALC_CACHE_LINE_ALIGN_SIZE(
+				   sizeof(struct pollset_info))];
+} *pollsets;
+
+#define PSI(IX) (&pollsets[(IX)].psi)
+
+static int no_pollsets;		/* Total number of pollsets */
+static int first_fd_pollset;	/* First pollset that fds are put in */
+
+#ifdef ERTS_SMP
+/* Timeout used by poll threads; they have no timers to handle */
+#define ERTS_POLL_THREAD_TIMEOUT_SEC 3600
+#endif
 
 typedef struct {
 #ifndef ERTS_SYS_CONTINOUS_FD_NUMBERS
@@ -96,7 +120,9 @@ typedef struct {
 	erts_driver_t* drv_ptr;           /* ERTS_EV_TYPE_STOP_USE */
     } driver;
     ErtsPollEvents events;
+    ErtsPollEvents paused;     /* events taken out of pollset by poll thread */
     unsigned short remove_cnt; /* number of removed_fd's referring to this fd */
+    unsigned short pollset_ix; /* pollset that the fd is, or was last, in */
     EventStateType type;
     EventStateFlags flags;
 } ErtsDrvEventState;
@@ -163,7 +189,9 @@ static ERTS_INLINE ErtsDrvEventState* hash_new_drv_ev_state(ErtsSysFdType fd)
     tmpl.fd = fd;
     tmpl.driver.select = NULL;
     tmpl.events = 0;
+    tmpl.paused = 0;
     tmpl.remove_cnt = 0;
+    tmpl.pollset_ix = 0;
     tmpl.type = ERTS_EV_TYPE_NONE;
     tmpl.flags = 0;
     return  (ErtsDrvEventState *) safe_hash_put(&drv_ev_state_tab, (void *) &tmpl);
@@ -213,9 +241,10 @@ ERTS_SCHED_PREF_QUICK_ALLOC_IMPL(removed_fd, struct removed_fd, 64, ERTS_ALC_T_F
 #endif
 
 static ERTS_INLINE void
-remember_removed(ErtsDrvEventState *state, struct pollset_info* psi)
+remember_removed(ErtsDrvEventState *state)
 {
 #ifdef ERTS_SMP
+    struct pollset_info *psi = PSI(state->pollset_ix);
     struct removed_fd *fdlp;
     ERTS_SMP_LC_ASSERT(erts_smp_lc_mtx_is_locked(fd_mtx(state->fd)));
     if (erts_smp_atomic_read(&psi->in_poll_wait)) {
@@ -347,7 +376,9 @@ grow_drv_ev_state(int min_ix)
 	    drv_ev_state[i].fd = (ErtsSysFdType) i;
 	    drv_ev_state[i].driver.select = NULL;
 	    drv_ev_state[i].events = 0;
+	    drv_ev_state[i].paused = 0;
 	    drv_ev_state[i].remove_cnt = 0;
+	    drv_ev_state[i].pollset_ix = 0;
 	    drv_ev_state[i].type = ERTS_EV_TYPE_NONE;
 	    drv_ev_state[i].flags = 0;
 	}
@@ -362,6 +393,38 @@ grow_drv_ev_state(int min_ix)
 }
 #endif /* ERTS_SYS_CONTINOUS_FD_NUMBERS */
 
+/*
+ * Choose pollset for an fd about to be added by port id. An fd that
+ * still is in a pollset, or that a poller of one may still report,
+ * keeps its pollset.
+ */
+static ERTS_INLINE void
+assign_pollset(ErtsDrvEventState *state, Eterm id)
+{
+    if (no_pollsets > 1 && !state->events && state->remove_cnt == 0)
+	state->pollset_ix = (unsigned short) (first_fd_pollset
+					      + (internal_port_index(id)
+						 % erts_no_pollsets));
+}
+
+/*
+ * Change events of an fd in its pollset. Returns the events selected
+ * on the fd, including events paused by a poll thread (see pause_events()).
+ * Paused events that are changed are no longer paused.
+ */
+static ERTS_INLINE ErtsPollEvents
+cio_poll_ctl(ErtsDrvEventState *state, ErtsPollEvents events, int on,
+	     int *do_wake)
+{
+    ErtsPollEvents res = ERTS_CIO_POLL_CTL(PSI(state->pollset_ix)->ps,
+					   state->fd, events, on, do_wake);
+    if (state->paused) {
+	state->paused &= ~events;
+	if (!(res & (ERTS_POLL_EV_ERR|ERTS_POLL_EV_NVAL)))
+	    res |= state->paused;
+    }
+    return res;
+}
 
 static ERTS_INLINE void
 abort_task(Eterm id, ErtsPortTaskHandle *pthp, EventStateType type)
@@ -439,7 +502,7 @@ deselect(ErtsDrvEventState *state, int mode)
 	}
     }
 
-    state->events = ERTS_CIO_POLL_CTL(pollset.ps, state->fd, rm_events, 0, &do_wake);
+    state->events = cio_poll_ctl(state, rm_events, 0, &do_wake);
 
     if (!(state->events)) {
 	switch (state->type) {
@@ -466,7 +529,7 @@ deselect(ErtsDrvEventState *state, int mode)
 	state->driver.select = NULL;
 	state->type = ERTS_EV_TYPE_NONE;
 	state->flags = 0;
-	remember_removed(state, &pollset);
+	remember_removed(state);
     }
 }
 
@@ -578,7 +641,10 @@ ERTS_CIO_EXPORT(driver_select)(ErlDrvPort ix,
 	wake_poller = 1;
     }
 
-    new_events = ERTS_CIO_POLL_CTL(pollset.ps, state->fd, ctl_events, on, &wake_poller);
+    if (on)
+	assign_pollset(state, id);
+
+    new_events = cio_poll_ctl(state, ctl_events, on, &wake_poller);
 
     if (new_events & (ERTS_POLL_EV_ERR|ERTS_POLL_EV_NVAL)) {
 	if (state->type == ERTS_EV_TYPE_DRV_SEL && !state->events) {
@@ -638,7 +704,7 @@ ERTS_CIO_EXPORT(driver_select)(ErlDrvPort ix,
 		    ASSERT(!erts_port_task_is_scheduled(&state->driver.select->intask));
 		    ASSERT(!erts_port_task_is_scheduled(&state->driver.select->outtask));
 		    if (old_events != 0) {
-			remember_removed(state, &pollset);
+			remember_removed(state);
 		    }		    
 		    if ((mode & ERL_DRV_USE) || !(state->flags & ERTS_EV_FLAG_USED)) {
 			state->type = ERTS_EV_TYPE_NONE;
@@ -762,14 +828,15 @@ ERTS_CIO_EXPORT(driver_event)(ErlDrvPort ix,
     }
 
     if (add_events) {
-	events = ERTS_CIO_POLL_CTL(pollset.ps, state->fd, add_events, 1, &do_wake);
+	assign_pollset(state, id);
+	events = cio_poll_ctl(state, add_events, 1, &do_wake);
 	if (events & (ERTS_POLL_EV_ERR|ERTS_POLL_EV_NVAL)) {
 	    ret = -1;
 	    goto done;
 	}
     }
     if (remove_events) {
-	events = ERTS_CIO_POLL_CTL(pollset.ps, state->fd, remove_events, 0, &do_wake);
+	events = cio_poll_ctl(state, remove_events, 0, &do_wake);
 	if (events & (ERTS_POLL_EV_ERR|ERTS_POLL_EV_NVAL)) {
 	    ret = -1;
 	    goto done;
@@ -799,7 +866,7 @@ ERTS_CIO_EXPORT(driver_event)(ErlDrvPort ix,
 	}
 	state->driver.select = NULL;
 	state->type = ERTS_EV_TYPE_NONE;
-	remember_removed(state, &pollset);
+	remember_removed(state);
     }
     state->events = events;
     ASSERT(event_data ? events == event_data->events : events == 0); 
@@ -1075,6 +1142,28 @@ event_large_fd_error(ErlDrvPort ix, ErtsSysFdType fd, ErlDrvEventData event_data
 #endif
 #endif
 
+/*
+ * A poll thread would report a level triggered event over and over
+ * again until the port task it triggered has executed. It therefore
+ * takes the event out of the pollset until then; see
+ * erts_check_io_task_executed().
+ */
+static ERTS_INLINE void
+pause_events(ErtsDrvEventState *state, ErtsPollEvents events)
+{
+#ifdef ERTS_SMP
+    if (state->pollset_ix != 0) {
+	int do_wake = 0;
+	events &= state->events & ~state->paused;
+	if (events) {
+	    (void) ERTS_CIO_POLL_CTL(PSI(state->pollset_ix)->ps, state->fd,
+				     events, 0, &do_wake);
+	    state->paused |= events;
+	}
+    }
+#endif
+}
+
 static ERTS_INLINE void
 iready(Eterm id, ErtsDrvEventState *state)
 {
@@ -1085,6 +1174,8 @@ iready(Eterm id, ErtsDrvEventState *state)
 				NULL) != 0) {
 	stale_drv_select(id, state, ERL_DRV_READ);
     }
+    else
+	pause_events(state, ERTS_POLL_EV_IN);
 }
 
 static ERTS_INLINE void
@@ -1097,6 +1188,8 @@ oready(Eterm id, ErtsDrvEventState *state)
 				NULL) != 0) {
 	stale_drv_select(id, state, ERL_DRV_WRITE);
     }
+    else
+	pause_events(state, ERTS_POLL_EV_OUT);
 }
 
 #if ERTS_CIO_HAVE_DRV_EVENT
@@ -1110,83 +1203,106 @@ eready(Eterm id, ErtsDrvEventState *state, ErlDrvEventData event_data)
 				event_data) != 0) {
 	stale_drv_select(id, state, 0);
     }
+    else
+	pause_events(state, state->events);
 }
 #endif
 
 static void bad_fd_in_pollset( ErtsDrvEventState *, Eterm, Eterm, ErtsPollEvents);
 
+/*
+ * Called after an I/O port task of port id has executed. Puts events
+ * paused when the task was scheduled back into the pollset.
+ */
 void
-ERTS_CIO_EXPORT(erts_check_io_interrupt)(int set)
-{
-    ERTS_CIO_POLL_INTR(pollset.ps, set);
-}
-
-void
-ERTS_CIO_EXPORT(erts_check_io_interrupt_timed)(int set, long msec)
+ERTS_CIO_EXPORT(erts_check_io_task_executed)(Eterm id, ErlDrvEvent e, int mode)
 {
-    ERTS_CIO_POLL_INTR_TMD(pollset.ps, set, msec);
-}
-
-void
-ERTS_CIO_EXPORT(erts_check_io)(int do_wait)
-{
-    ErtsPollResFd pollres[256];
-    int pollres_len;
-    SysTimeval wait_time;
-    int poll_ret, i;
+#ifdef ERTS_SMP
+    ErtsSysFdType fd = (ErtsSysFdType) e;
+    ErtsDrvEventState *state;
+    ErtsPollEvents events;
+    int do_wake = 0;
 
- restart:
+#ifdef ERTS_SYS_CONTINOUS_FD_NUMBERS
+    if ((unsigned)fd >= (unsigned)erts_smp_atomic_read(&drv_ev_state_len))
+	return;
+#endif
 
-    /* Figure out timeout value */
-    if (do_wait) {
-	erts_time_remaining(&wait_time);
-    } else {			/* poll only */
-	wait_time.tv_sec = 0;
-	wait_time.tv_usec = 0;
-    }
+    erts_smp_mtx_lock(fd_mtx(fd));
 
-#ifdef ERTS_ENABLE_LOCK_CHECK
-    erts_lc_check_exact(NULL, 0); /* No locks should be locked */
+#ifdef ERTS_SYS_CONTINOUS_FD_NUMBERS
+    state = &drv_ev_state[(int) fd];
+#else
+    state = hash_get_drv_ev_state(fd);
+    if (!state)
+	goto done;
 #endif
-    erts_smp_activity_begin(ERTS_ACTIVITY_WAIT, NULL, NULL, NULL);
-    pollres_len = sizeof(pollres)/sizeof(ErtsPollResFd);
-
-    erts_smp_atomic_set(&pollset.in_poll_wait, 1);
 
-    poll_ret = ERTS_CIO_POLL_WAIT(pollset.ps, pollres, &pollres_len, &wait_time);
+    events = state->paused;
+    if (!events)
+	goto done;
 
-#ifdef ERTS_ENABLE_LOCK_CHECK
-    erts_lc_check_exact(NULL, 0); /* No locks should be locked */
+    switch (state->type) {
+    case ERTS_EV_TYPE_DRV_SEL:
+	if (!(mode & ERL_DRV_READ) || state->driver.select->inport != id)
+	    events &= ~ERTS_POLL_EV_IN;
+	if (!(mode & ERL_DRV_WRITE) || state->driver.select->outport != id)
+	    events &= ~ERTS_POLL_EV_OUT;
+	break;
+#if ERTS_CIO_HAVE_DRV_EVENT
+    case ERTS_EV_TYPE_DRV_EV:
+	if (state->driver.event->port != id)
+	    events = 0;
+	break;
 #endif
-    erts_smp_activity_end(ERTS_ACTIVITY_WAIT, NULL, NULL, NULL);
+    default:
+	events = 0;
+	break;
+    }
 
-    erts_deliver_time(); /* sync the machine's idea of time */
+    if (events) {
+	state->paused &= ~events;
+	(void) ERTS_CIO_POLL_CTL(PSI(state->pollset_ix)->ps, fd, events, 1,
+				 &do_wake);
+    }
 
-#ifdef ERTS_BREAK_REQUESTED
-    if (ERTS_BREAK_REQUESTED)
-	erts_do_break_handling();
+ done:
+    erts_smp_mtx_unlock(fd_mtx(fd));
 #endif
+}
 
-    if (poll_ret != 0) {
-	erts_smp_atomic_set(&pollset.in_poll_wait, 0);
-	forget_removed(&pollset);
-	if (poll_ret == EAGAIN) {
-	    goto restart;
-	}
+void
+ERTS_CIO_EXPORT(erts_check_io_interrupt)(int set)
+{
+    ERTS_CIO_POLL_INTR(PSI(0)->ps, set);
+}
+
+void
+ERTS_CIO_EXPORT(erts_check_io_interrupt_timed)(int set, long msec)
+{
+    ERTS_CIO_POLL_INTR_TMD(PSI(0)->ps, set, msec);
+}
 
-	if (poll_ret != ETIMEDOUT
-	    && poll_ret != EINTR
+static void
+report_poll_error(int poll_ret)
+{
+    if (poll_ret != ETIMEDOUT
+	&& poll_ret != EINTR
 #ifdef ERRNO_BLOCK
-	    && poll_ret != ERRNO_BLOCK
+	&& poll_ret != ERRNO_BLOCK
 #endif
-	    ) {
-	    erts_dsprintf_buf_t *dsbufp = erts_create_logger_dsbuf();
-	    erts_dsprintf(dsbufp, "erts_poll_wait() failed: %s (%d)\n",
-			  erl_errno_id(poll_ret), poll_ret);
-	    erts_send_error_to_logger_nogl(dsbufp);
-	}
-	return;
+	) {
+	erts_dsprintf_buf_t *dsbufp = erts_create_logger_dsbuf();
+	erts_dsprintf(dsbufp, "erts_poll_wait() failed: %s (%d)\n",
+		      erl_errno_id(poll_ret), poll_ret);
+	erts_send_error_to_logger_nogl(dsbufp);
     }
+}
+
+static void
+handle_poll_result(ErtsPollResFd pollres[], int pollres_len)
+{
+    int i;
 
     for (i = 0; i < pollres_len; i++) {
 
@@ -1299,10 +1415,114 @@ ERTS_CIO_EXPORT(erts_check_io)(int do_wait)
 #endif
     }
 
-    erts_smp_atomic_set(&pollset.in_poll_wait, 0);
-    forget_removed(&pollset);
 }
 
+void
+ERTS_CIO_EXPORT(erts_check_io)(int do_wait)
+{
+    struct pollset_info *psi = PSI(0);
+    ErtsPollResFd pollres[256];
+    int pollres_len;
+    SysTimeval wait_time;
+    int poll_ret;
+
+ restart:
+
+    /* Figure out timeout value */
+    if (do_wait) {
+	erts_time_remaining(&wait_time);
+    } else {			/* poll only */
+	wait_time.tv_sec = 0;
+	wait_time.tv_usec = 0;
+    }
+
+#ifdef ERTS_ENABLE_LOCK_CHECK
+    erts_lc_check_exact(NULL, 0); /* No locks should be locked */
+#endif
+    erts_smp_activity_begin(ERTS_ACTIVITY_WAIT, NULL, NULL, NULL);
+    pollres_len = sizeof(pollres)/sizeof(ErtsPollResFd);
+
+    erts_smp_atomic_set(&psi->in_poll_wait, 1);
+
+    poll_ret = ERTS_CIO_POLL_WAIT(psi->ps, pollres, &pollres_len, &wait_time);
+
+#ifdef ERTS_ENABLE_LOCK_CHECK
+    erts_lc_check_exact(NULL, 0); /* No locks should be locked */
+#endif
+    erts_smp_activity_end(ERTS_ACTIVITY_WAIT, NULL, NULL, NULL);
+
+    erts_deliver_time(); /* sync the machine's idea of time */
+
+#ifdef ERTS_BREAK_REQUESTED
+    if (ERTS_BREAK_REQUESTED)
+	erts_do_break_handling();
+#endif
+
+    if (poll_ret != 0) {
+	erts_smp_atomic_set(&psi->in_poll_wait, 0);
+	forget_removed(psi);
+	if (poll_ret == EAGAIN) {
+	    goto restart;
+	}
+	report_poll_error(poll_ret);
+	return;
+    }
+
+    handle_poll_result(pollres, pollres_len);
+
+    erts_smp_atomic_set(&psi->in_poll_wait, 0);
+    forget_removed(psi);
+}
+
+#ifdef ERTS_SMP
+/*
+ * A poll thread only handles I/O; timers and break requests are left
+ * to the schedulers polling pollsets[0].
+ */
+static void *
+poll_thread_func(void *vpsix)
+{
+    struct pollset_info *psi = PSI((int) (long) vpsix);
+    ErtsPollResFd pollres[256];
+    int pollres_len;
+    SysTimeval wait_time;
+    int poll_ret;
+
+#ifdef ERTS_ENABLE_LOCK_CHECK
+    {
+	char buf[27];
+	erts_snprintf(&buf[0], 27, "poll thread %d", (int) (long) vpsix);
+	erts_lc_set_thread_name(&buf[0]);
+    }
+#endif
+
+    while (1) {
+	wait_time.tv_sec = ERTS_POLL_THREAD_TIMEOUT_SEC;
+	wait_time.tv_usec = 0;
+	pollres_len = sizeof(pollres)/sizeof(ErtsPollResFd);
+
+	erts_smp_atomic_set(&psi->in_poll_wait, 1);
+
+	poll_ret = ERTS_CIO_POLL_WAIT(psi->ps, pollres, &pollres_len,
+				      &wait_time);
+
+#ifdef ERTS_ENABLE_LOCK_CHECK
+	erts_lc_check_exact(NULL, 0); /* No locks should be locked */
+#endif
+
+	if (poll_ret == 0)
+	    handle_poll_result(pollres, pollres_len);
+
+	erts_smp_atomic_set(&psi->in_poll_wait, 0);
+	forget_removed(psi);
+
+	if (poll_ret != 0 && poll_ret != EAGAIN)
+	    report_poll_error(poll_ret);
+    }
+    return NULL;
+}
+#endif
+
 static void
 bad_fd_in_pollset(ErtsDrvEventState *state, Eterm inport, 
 		  Eterm outport, ErtsPollEvents events)
@@ -1414,17 +1634,37 @@ static void drv_ev_state_free(void *des)
 void
 ERTS_CIO_EXPORT(erts_init_check_io)(void)
 {
-    erts_smp_atomic_init(&pollset.in_poll_wait, 0);
+    int i;
+
+#ifndef ERTS_SMP
+    erts_no_pollsets = 1;
+    erts_use_poll_threads = 0;
+    erts_use_oneshot_poll = 0;
+#endif
+    if (erts_no_pollsets < 1)
+	erts_no_pollsets = 1;
+    first_fd_pollset = erts_use_poll_threads ? 1 : 0;
+    no_pollsets = first_fd_pollset + erts_no_pollsets;
+
     ERTS_CIO_POLL_INIT();
-    pollset.ps = ERTS_CIO_NEW_POLLSET();
+    pollsets = erts_alloc(ERTS_ALC_T_POLLSET_INFO,
+			  no_pollsets * sizeof(*pollsets));
+    for (i = 0; i < no_pollsets; i++) {
+	erts_smp_atomic_init(&PSI(i)->in_poll_wait, 0);
+	PSI(i)->ps = ERTS_CIO_NEW_POLLSET();
+	/* Poll threads pause events as they trigger anyway */
+	if (i > 0 || erts_use_oneshot_poll)
+	    ERTS_CIO_POLL_ONESHOT(PSI(i)->ps);
+#ifdef ERTS_SMP
+	PSI(i)->removed_list = NULL;
+	erts_smp_spinlock_init(&PSI(i)->removed_list_lock,
+			       "pollset_rm_list");
+#endif
+    }
 
 #ifdef ERTS_SMP
     init_removed_fd_alloc();
-    pollset.removed_list = NULL;
-    erts_smp_spinlock_init(&pollset.removed_list_lock,
-			   "pollset_rm_list");
     {
-	int i;
 	for (i=0; i<DRV_EV_STATE_LOCK_CNT; i++) {
 #ifdef ERTS_ENABLE_LOCK_COUNT
 	    erts_smp_mtx_init_x(&drv_ev_state_locks[i].lck, "drv_ev_state", make_small(i));
@@ -1454,6 +1694,38 @@ ERTS_CIO_EXPORT(erts_init_check_io)(void)
 		       DRV_EV_STATE_HTAB_SIZE, hf);
     }
 #endif
+
+#ifdef ERTS_SMP
+    if (no_pollsets > 1) {
+	erts_thr_opts_t thr_opts = ERTS_THR_OPTS_DEFAULT_INITER;
+	erts_tid_t tid;
+	thr_opts.detached = 1;
+	for (i = 1; i < no_pollsets; i++)
+	    erts_thr_create(&tid, poll_thread_func, (void *) (long) i,
+			    &thr_opts);
+    }
+#endif
+}
+
+/* Poll info summed up over all pollsets */
+static void
+get_poll_info(ErtsPollInfo *pip)
+{
+    int i;
+    ERTS_CIO_POLL_INFO(PSI(0)->ps, pip);
+    for (i = 1; i < no_pollsets; i++) {
+	ErtsPollInfo pi;
+	ERTS_CIO_POLL_INFO(PSI(i)->ps, &pi);
+	pip->memory_size += pi.memory_size;
+	pip->poll_set_size += pi.poll_set_size;
+	pip->fallback_poll_set_size += pi.fallback_poll_set_size;
+	pip->pending_updates += pi.pending_updates;
+#ifdef ERTS_POLL_COUNT_AVOIDED_WAKEUPS
+	pip->no_avoided_wakeups += pi.no_avoided_wakeups;
+	pip->no_avoided_interrupts += pi.no_avoided_interrupts;
+	pip->no_interrupt_timed += pi.no_interrupt_timed;
+#endif
+    }
 }
 
 int
@@ -1471,8 +1743,8 @@ ERTS_CIO_EXPORT(erts_check_io_size)(void)
 {
     Uint res;
     ErtsPollInfo pi;
-    ERTS_CIO_POLL_INFO(pollset.ps, &pi);
-    res = pi.memory_size;
+    get_poll_info(&pi);
+    res = pi.memory_size + no_pollsets * sizeof(*pollsets);
 #ifdef ERTS_SYS_CONTINOUS_FD_NUMBERS
     res += sizeof(ErtsDrvEventState) * erts_smp_atomic_read(&drv_ev_state_len);
 #else
@@ -1493,13 +1765,13 @@ Eterm
 ERTS_CIO_EXPORT(erts_check_io_info)(void *proc)
 {
     Process *p = (Process *) proc;
-    Eterm tags[15], values[15], res;
+    Eterm tags[17], values[17], res;
     Uint sz, *szp, *hp, **hpp, memory_size;
     Sint i;
     ErtsPollInfo pi;
     
-    ERTS_CIO_POLL_INFO(pollset.ps, &pi);
-    memory_size = pi.memory_size;
+    get_poll_info(&pi);
+    memory_size = pi.memory_size + no_pollsets * sizeof(*pollsets);
 #ifdef ERTS_SYS_CONTINOUS_FD_NUMBERS
     memory_size += sizeof(ErtsDrvEventState) * erts_smp_atomic_read(&drv_ev_state_len);
 #else
@@ -1534,6 +1806,12 @@ ERTS_CIO_EXPORT(erts_check_io_info)(void *proc)
     values[i++] = erts_bld_atom(hpp, szp,
 				pi.kernel_poll ? pi.kernel_poll : "false");
 
+    tags[i] = erts_bld_atom(hpp, szp, "poll_sets");
+    values[i++] = make_small(no_pollsets);
+
+    tags[i] = erts_bld_atom(hpp, szp, "poll_threads");
+    values[i++] = make_small(no_pollsets - 1);
+
     tags[i] = erts_bld_atom(hpp, szp, "memory_size");
     values[i++] = erts_bld_uint(hpp, szp, memory_size);
 
@@ -1860,7 +2138,9 @@ ERTS_CIO_EXPORT(erts_check_io_debug)(void)
 
     null_des.driver.select = NULL;
     null_des.events = 0;
+    null_des.paused = 0;
     null_des.remove_cnt = 0;
+    null_des.pollset_ix = 0;
     null_des.type = ERTS_EV_TYPE_NONE;
 
     erts_printf("--- fds in pollset --------------------------------------\n");
@@ -1874,7 +2154,18 @@ ERTS_CIO_EXPORT(erts_check_io_debug)(void)
 
 #ifdef ERTS_SYS_CONTINOUS_FD_NUMBERS
     counters.epep = erts_alloc(ERTS_ALC_T_TMP, sizeof(ErtsPollEvents)*max_fds);
-    ERTS_POLL_EXPORT(erts_poll_get_selected_events)(pollset.ps, counters.epep, max_fds);
+    ERTS_POLL_EXPORT(erts_poll_get_selected_events)(PSI(0)->ps, counters.epep, max_fds);
+    if (no_pollsets > 1) {
+	ErtsPollEvents *ev = erts_alloc(ERTS_ALC_T_TMP,
+					sizeof(ErtsPollEvents)*max_fds);
+	int ix;
+	for (ix = 1; ix < no_pollsets; ix++) {
+	    ERTS_POLL_EXPORT(erts_poll_get_selected_events)(PSI(ix)->ps, ev, max_fds);
+	    for (fd = 0; fd < max_fds; fd++)
+		counters.epep[fd] |= ev[fd];
+	}
+	erts_free(ERTS_ALC_T_TMP, (void *) ev);
+    }
     counters.internal_fds = 0;
 #endif
     counters.used_fds = 0;
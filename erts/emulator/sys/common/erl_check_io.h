@@ -28,6 +28,22 @@
 
 #include "erl_sys_driver.h"
 
+#define ERTS_MAX_NO_OF_POLLSETS 1024
+
+/*
+ * Number of pollsets that fds are spread over (+IOp). The first pollset
+ * is polled by the schedulers; each of the others by a thread of its own.
+ * With erts_use_poll_threads (+IOt) all of them are polled by threads of
+ * their own, and the schedulers poll a pollset without fds.
+ */
+extern int erts_no_pollsets;
+extern int erts_use_poll_threads;
+/*
+ * Let kernel poll disarm fds as they trigger also in the pollset polled
+ * by the schedulers (+IOo); pollsets polled by poll threads always do.
+ */
+extern int erts_use_oneshot_poll;
+
 #ifdef ERTS_ENABLE_KERNEL_POLL
 
 int driver_select_kp(ErlDrvPort, ErlDrvEvent, int, int);
@@ -50,6 +66,8 @@ void erts_init_check_io_kp(void);
 void erts_init_check_io_nkp(void);
 int erts_check_io_debug_kp(void);
 int erts_check_io_debug_nkp(void);
+void erts_check_io_task_executed_kp(Eterm, ErlDrvEvent, int);
+void erts_check_io_task_executed_nkp(Eterm, ErlDrvEvent, int);
 
 #else /* !ERTS_ENABLE_KERNEL_POLL */
 
@@ -60,6 +78,7 @@ void erts_check_io_interrupt(int);
 void erts_check_io_interrupt_timed(int, long);
 void erts_check_io(int);
 void erts_init_check_io(void);
+void erts_check_io_task_executed(Eterm, ErlDrvEvent, int);
 
 #endif
 
@@ -107,6 +107,15 @@ static int mmap_fd;
 #define CAN_PARTLY_DESTROY 0
 #endif
 
+#if HAVE_MMAP && !defined(ERTS_MSEG_FAKE_SEGMENTS)
+#  define HAVE_SUPER_CARRIER 1
+#  ifndef MAP_NORESERVE
+#    define MAP_NORESERVE 0
+#  endif
+#else
+#  define HAVE_SUPER_CARRIER 0
+#endif
+
 static const ErtsMsegOpt_t default_opt = ERTS_MSEG_DEFAULT_OPT_INITIALIZER;
 
 typedef struct cache_desc_t_ {
@@ -155,6 +164,44 @@ static Uint rel_max_cache_bad_fit;
 static Uint min_seg_size;
 #endif
 
+/*
+ * The super carrier (+MMscs) is one large range of virtual memory
+ * reserved at init. When present, segments are carved out of it
+ * instead of being mapped one at a time, and destroyed segments are
+ * returned to it with madvise() instead of being unmapped. This keeps
+ * mmap()/munmap() (and the kernel locks they take) out of the
+ * allocation path.
+ *
+ * Free ranges are kept in an address ordered list and are coalesced
+ * with their neighbours when segments are destroyed. Range descriptors
+ * are placed in the beginning of the super carrier; since all ranges
+ * are page aligned there can never be more than PAGES(size)/2 + 1 free
+ * ranges, and descriptor pages are not touched until needed.
+ */
+
+typedef struct sc_range_t_ {
+    char *start;
+    char *end;
+    struct sc_range_t_ *next;
+    struct sc_range_t_ *prev;
+} sc_range_t;
+
+static struct {
+    char *start;
+    char *end;
+    int only;
+    sc_range_t *free;
+    sc_range_t *free_descs;
+    sc_range_t *unused_descs;
+    sc_range_t *unused_descs_end;
+    Uint size;
+    Uint used;
+    Uint free_ranges;
+} sc;
+
+#define IS_SC_SEG(SEG) \
+    (sc.start <= ((char *) (SEG)) && ((char *) (SEG)) < sc.end)
+
 struct {
     struct {
 	Uint watermark;
@@ -351,6 +398,193 @@ mseg_shutdown(void)
 
 #endif  /* #if defined(USE_THREADS) && !defined(ERTS_SMP) */
 
+#if HAVE_SUPER_CARRIER
+
+static ERTS_INLINE sc_range_t *
+sc_alloc_desc(void)
+{
+    sc_range_t *rp = sc.free_descs;
+    if (rp)
+	sc.free_descs = rp->next;
+    else {
+	ASSERT(sc.unused_descs < sc.unused_descs_end);
+	rp = sc.unused_descs++;
+    }
+    sc.free_ranges++;
+    return rp;
+}
+
+static ERTS_INLINE void
+sc_free_desc(sc_range_t *rp)
+{
+    ASSERT(sc.free_ranges > 0);
+    sc.free_ranges--;
+    rp->next = sc.free_descs;
+    sc.free_descs = rp;
+}
+
+static ERTS_INLINE void
+sc_unlink_range(sc_range_t *rp)
+{
+    if (rp->prev)
+	rp->prev->next = rp->next;
+    else
+	sc.free = rp->next;
+    if (rp->next)
+	rp->next->prev = rp->prev;
+    sc_free_desc(rp);
+}
+
+static void *
+sc_create(Uint size)
+{
+    sc_range_t *rp;
+
+    /* Address ordered first fit */
+    for (rp = sc.free; rp; rp = rp->next) {
+	if (((Uint) (rp->end - rp->start)) >= size) {
+	    char *seg = rp->start;
+	    rp->start += size;
+	    if (rp->start == rp->end)
+		sc_unlink_range(rp);
+	    sc.used += size;
+	    return (void *) seg;
+	}
+    }
+    return NULL;
+}
+
+static void
+sc_destroy(void *seg, Uint size)
+{
+    char *start = (char *) seg;
+    char *end = start + size;
+    sc_range_t *prev, *next;
+
+    ASSERT(IS_SC_SEG(start) && end <= sc.end);
+    ASSERT(sc.used >= size);
+
+#if defined(MADV_DONTNEED)
+    madvise((void *) start, (size_t) size, MADV_DONTNEED);
+#endif
+
+    sc.used -= size;
+
+    prev = NULL;
+    for (next = sc.free; next && next->start < start; next = next->next)
+	prev = next;
+
+    ASSERT(!prev || prev->end <= start);
+    ASSERT(!next || end <= next->start);
+
+    if (prev && prev->end == start) {
+	prev->end = end;
+	if (next && next->start == end) {
+	    prev->end = next->end;
+	    sc_unlink_range(next);
+	}
+    }
+    else if (next && next->start == end)
+	next->start = start;
+    else {
+	sc_range_t *rp = sc_alloc_desc();
+	rp->start = start;
+	rp->end = end;
+	rp->prev = prev;
+	rp->next = next;
+	if (prev)
+	    prev->next = rp;
+	else
+	    sc.free = rp;
+	if (next)
+	    next->prev = rp;
+    }
+}
+
+static void *
+sc_recreate(void *old_seg, Uint old_size, Uint new_size)
+{
+    char *old_end = ((char *) old_seg) + old_size;
+    sc_range_t *rp;
+    void *new_seg;
+
+    ASSERT(new_size > old_size);
+
+    /* Try to grow in place into an adjacent free range */
+    for (rp = sc.free; rp && rp->start < old_end; rp = rp->next);
+    if (rp && rp->start == old_end
+	&& ((Uint) (rp->end - rp->start)) >= new_size - old_size) {
+	rp->start += new_size - old_size;
+	if (rp->start == rp->end)
+	    sc_unlink_range(rp);
+	sc.used += new_size - old_size;
+	return old_seg;
+    }
+
+    new_seg = sc_create(new_size);
+    if (!new_seg && !sc.only) {
+	new_seg = (void *) mmap((void *) 0, (size_t) new_size,
+				MMAP_PROT, MMAP_FLAGS, MMAP_FD, 0);
+	if (new_seg == (void *) MAP_FAILED)
+	    new_seg = NULL;
+    }
+    if (new_seg) {
+	sys_memcpy(new_seg, old_seg, old_size);
+	sc_destroy(old_seg, old_size);
+    }
+    return new_seg;
+}
+
+static void
+sc_init(Uint size, int only)
+{
+    char *base;
+    Uint descs_size;
+
+    sys_memzero((void *) &sc, sizeof(sc));
+
+    if (!size)
+	return;
+
+    size = PAGE_CEILING(size);
+    descs_size = PAGE_CEILING((PAGES(size)/2 + 1)*sizeof(sc_range_t));
+    if (descs_size >= size)
+	erl_exit(ERTS_ABORT_EXIT,
+		 "erts_mseg: super carrier size %bpu too small\n", size);
+
+    base = (char *) mmap((void *) 0, (size_t) size, MMAP_PROT,
+			 MMAP_FLAGS|MAP_NORESERVE, MMAP_FD, 0);
+    if (base == (char *) MAP_FAILED)
+	erl_exit(ERTS_ABORT_EXIT,
+		 "erts_mseg: unable to reserve super carrier of %bpu bytes\n",
+		 size);
+
+    sc.size = size;
+    sc.only = only;
+    sc.unused_descs = (sc_range_t *) base;
+    sc.unused_descs_end = (sc_range_t *) (base + descs_size);
+    sc.start = base + descs_size;
+    sc.end = base + size;
+
+    sc.free = sc_alloc_desc();
+    sc.free->start = sc.start;
+    sc.free->end = sc.end;
+    sc.free->next = NULL;
+    sc.free->prev = NULL;
+}
+
+#else /* #if HAVE_SUPER_CARRIER */
+
+#define sc_create(SZ) NULL
+
+static void
+sc_init(Uint size, int only)
+{
+    sys_memzero((void *) &sc, sizeof(sc));
+}
+
+#endif /* #if HAVE_SUPER_CARRIER */
+
 static ERTS_INLINE void *
 mseg_create(Uint size)
 {
@@ -361,10 +595,13 @@ mseg_create(Uint size)
 #if defined(ERTS_MSEG_FAKE_SEGMENTS)
     seg = erts_sys_alloc(ERTS_ALC_N_INVALID, NULL, size);
 #elif HAVE_MMAP
-    seg = (void *) mmap((void *) 0, (size_t) size,
-			MMAP_PROT, MMAP_FLAGS, MMAP_FD, 0);
-    if (seg == (void *) MAP_FAILED)
-	seg = NULL;
+    seg = sc_create(size);
+    if (!seg && !sc.only) {
+	seg = (void *) mmap((void *) 0, (size_t) size,
+			    MMAP_PROT, MMAP_FLAGS, MMAP_FD, 0);
+	if (seg == (void *) MAP_FAILED)
+	    seg = NULL;
+    }
 #else
 #error "Missing mseg_create() implementation"
 #endif
@@ -381,14 +618,18 @@ mseg_destroy(void *seg, Uint size)
     erts_sys_free(ERTS_ALC_N_INVALID, NULL, seg);
 #elif HAVE_MMAP
 
+    if (IS_SC_SEG(seg))
+	sc_destroy(seg, size);
+    else {
 #ifdef DEBUG
-    int res =
+	int res =
 #endif
 
-	munmap((void *) seg, size);
+	    munmap((void *) seg, size);
 
+	ASSERT(res == 0);
+    }
     ASSERT(size % page_size == 0);
-    ASSERT(res == 0);
 #else
 #error "Missing mseg_destroy() implementation"
 #endif
@@ -410,12 +651,16 @@ mseg_recreate(void *old_seg, Uint old_size, Uint new_size)
 #if defined(ERTS_MSEG_FAKE_SEGMENTS)
     new_seg = erts_sys_realloc(ERTS_ALC_N_INVALID, NULL, old_seg, new_size);
 #elif HAVE_MREMAP
-    new_seg = (void *) mremap((void *) old_seg,
-			      (size_t) old_size,
-			      (size_t) new_size,
-			      MREMAP_MAYMOVE);
-    if (new_seg == (void *) MAP_FAILED)
-	new_seg = NULL;
+    if (IS_SC_SEG(old_seg))
+	new_seg = sc_recreate(old_seg, old_size, new_size);
+    else {
+	new_seg = (void *) mremap((void *) old_seg,
+				  (size_t) old_size,
+				  (size_t) new_size,
+				  MREMAP_MAYMOVE);
+	if (new_seg == (void *) MAP_FAILED)
+	    new_seg = NULL;
+    }
 #else
 #error "Missing mseg_recreate() implementation"
 #endif
@@ -891,6 +1136,8 @@ static struct {
     Eterm rmcbf;
     Eterm mcs;
     Eterm cci;
+    Eterm scs;
+    Eterm sco;
 
     Eterm status;
     Eterm cached_segments;
@@ -898,7 +1145,8 @@ static struct {
     Eterm segments;
     Eterm segments_size;
     Eterm segments_watermark;
-
+    Eterm sc_used;
+    Eterm sc_free_ranges;
 
     Eterm calls;
     Eterm mseg_alloc;
@@ -947,6 +1195,8 @@ init_atoms(void)
 	AM_INIT(rmcbf);
 	AM_INIT(mcs);
 	AM_INIT(cci);
+	AM_INIT(scs);
+	AM_INIT(sco);
 
 	AM_INIT(status);
 	AM_INIT(cached_segments);
@@ -954,6 +1204,8 @@ init_atoms(void)
 	AM_INIT(segments);
 	AM_INIT(segments_size);
 	AM_INIT(segments_watermark);
+	AM_INIT(sc_used);
+	AM_INIT(sc_free_ranges);
 
 	AM_INIT(calls);
 	AM_INIT(mseg_alloc);
@@ -1046,6 +1298,8 @@ info_options(char *prefix,
 	erts_print(to, arg, "%srmcbf: %bpu\n", prefix, rel_max_cache_bad_fit);
 	erts_print(to, arg, "%smcs: %bpu\n", prefix, max_cache_size);
 	erts_print(to, arg, "%scci: %bpu\n", prefix, cache_check_interval);
+	erts_print(to, arg, "%sscs: %bpu\n", prefix, sc.size);
+	erts_print(to, arg, "%ssco: %s\n", prefix, sc.only ? "true" : "false");
     }
 
     if (hpp || szp) {
@@ -1054,6 +1308,12 @@ info_options(char *prefix,
 	    init_atoms();
 
 	res = NIL;
+	add_2tup(hpp, szp, &res,
+		 am.sco,
+		 sc.only ? am_true : am_false);
+	add_2tup(hpp, szp, &res,
+		 am.scs,
+		 bld_uint(hpp, szp, sc.size));
 	add_2tup(hpp, szp, &res,
 		 am.cci,
 		 bld_uint(hpp, szp, cache_check_interval));
@@ -1176,10 +1436,18 @@ info_status(int *print_to_p,
 		   segments.current.sz, segments.max.sz, segments.max_ever.sz);
 	erts_print(to, arg, "segments_watermark: %bpu\n",
 		   segments.current.watermark);
+	erts_print(to, arg, "sc_used: %bpu\n", sc.used);
+	erts_print(to, arg, "sc_free_ranges: %bpu\n", sc.free_ranges);
     }
 
     if (hpp || szp) {
 	res = NIL;
+	add_2tup(hpp, szp, &res,
+		 am.sc_free_ranges,
+		 bld_unstable_uint(hpp, szp, sc.free_ranges));
+	add_2tup(hpp, szp, &res,
+		 am.sc_used,
+		 bld_unstable_uint(hpp, szp, sc.used));
 	add_2tup(hpp, szp, &res,
 		 am.segments_watermark,
 		 bld_unstable_uint(hpp, szp, segments.current.watermark));
@@ -1395,6 +1663,8 @@ erts_mseg_init(ErtsMsegInit_t *init)
 
     sys_memzero((void *) &calls, sizeof(calls));
 
+    sc_init(init->scs, init->sco);
+
 #if CAN_PARTLY_DESTROY
     min_seg_size = ~((Uint) 0);
 #endif
@@ -45,6 +45,8 @@ typedef struct {
     Uint rmcbf;
     Uint mcs;
     Uint cci;
+    Uint scs;
+    int  sco;
 } ErtsMsegInit_t;
 
 #define ERTS_MSEG_INIT_DEFAULT_INITIALIZER				\
@@ -52,7 +54,9 @@ typedef struct {
     4*1024*1024,	/* amcbf: Absolute max cache bad fit	*/	\
     20,			/* rmcbf: Relative max cache bad fit	*/	\
     5,			/* mcs:   Max cache size		*/	\
-    1000		/* cci:   Cache check interval		*/	\
+    1000,		/* cci:   Cache check interval		*/	\
+    0,			/* scs:   Super carrier size		*/	\
+    0			/* sco:   Super carrier only		*/	\
 }
 
 typedef struct {
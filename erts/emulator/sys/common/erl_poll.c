@@ -239,6 +239,10 @@ struct ErtsPollSetUpdateRequestsBlock_ {
 #if ERTS_POLL_USE_KERNEL_POLL || defined(ERTS_SMP)
 #  define ERTS_POLL_FD_FLG_RST		(((unsigned short) 1) << 3)
 #endif
+#if ERTS_POLL_USE_EPOLL
+/* One-shot event has triggered; fd still in epoll set but disarmed */
+#  define ERTS_POLL_FD_FLG_DISARMED	(((unsigned short) 1) << 4)
+#endif
 typedef struct {
 #if ERTS_POLL_USE_POLL
     int pix;
@@ -283,6 +287,7 @@ struct ErtsPollSet_ {
     int res_events_len;
 #if ERTS_POLL_USE_EPOLL
     struct epoll_event *res_events;
+    int oneshot;
 #elif ERTS_POLL_USE_KQUEUE
     struct kevent *res_events;
 #elif ERTS_POLL_USE_DEVPOLL
@@ -1036,13 +1041,23 @@ update_pollset(ErtsPollSet ps, int fd)
 
     epe_templ.events = ERTS_POLL_EV_E2N(ps->fds_status[fd].events);
     epe_templ.data.fd = fd;
+    if (ps->oneshot && epe_templ.events)
+	epe_templ.events |= EPOLLONESHOT;
 
 #ifdef VALGRIND
     /* Silence invalid valgrind warning ... */
     memset((void *) &epe.data, 0, sizeof(epoll_data_t));
 #endif
 
-    if (epe_templ.events && ps->fds_status[fd].flags & ERTS_POLL_FD_FLG_RST) {
+    /*
+     * A disarmed fd has already been taken off no_of_user_fds when the
+     * kernel reported it. It is not deleted here; it is re-armed with
+     * EPOLL_CTL_MOD below, which also copes with a reset fd (ENOENT).
+     */
+    if (epe_templ.events
+	&& (ps->fds_status[fd].flags & (ERTS_POLL_FD_FLG_RST
+					| ERTS_POLL_FD_FLG_DISARMED))
+	   == ERTS_POLL_FD_FLG_RST) {
 	do {
 	    /* We init 'epe' every time since epoll_ctl() may modify it
 	       (not declared const and not documented as const). */
@@ -1054,12 +1069,29 @@ update_pollset(ErtsPollSet ps, int fd)
 	ps->fds_status[fd].used_events = 0;
     }
 
+    if (!epe_templ.events
+	&& (ps->fds_status[fd].flags & ERTS_POLL_FD_FLG_DISARMED)) {
+	/*
+	 * Deselected while disarmed. The fd stays in the epoll set,
+	 * where it cannot trigger, and keeps its flag so that a later
+	 * select re-arms it with EPOLL_CTL_MOD.
+	 */
+	ps->fds_status[fd].used_events = 0;
+	ps->fds_status[fd].flags &= ~ERTS_POLL_FD_FLG_RST;
+	return 0;
+    }
+
     if (!epe_templ.events) {
 	/* A note on EPOLL_CTL_DEL: linux kernel versions before 2.6.9
 	   need a non-NULL event pointer even though it is ignored... */
 	op = EPOLL_CTL_DEL;
 	ps->no_of_user_fds--;
     }
+    else if (ps->fds_status[fd].flags & ERTS_POLL_FD_FLG_DISARMED) {
+	/* Re-arm; disarmed fds are not counted as user fds */
+	op = EPOLL_CTL_MOD;
+	ps->no_of_user_fds++;
+    }
     else if (!ps->fds_status[fd].used_events) {
 	op = EPOLL_CTL_ADD;
 	ps->no_of_user_fds++;
@@ -1076,6 +1108,23 @@ update_pollset(ErtsPollSet ps, int fd)
 	res = epoll_ctl(ps->kp_fd, op, fd, &epe);
     } while (res != 0 && errno == EINTR);
 
+    if (res != 0
+	&& errno == ENOENT
+	&& (ps->fds_status[fd].flags & ERTS_POLL_FD_FLG_DISARMED)) {
+	/*
+	 * The disarmed fd has been closed, and automatically removed
+	 * from the epoll set, since it triggered (the fd may since have
+	 * been reused for another file). Add it again...
+	 */
+	op = EPOLL_CTL_ADD;
+	do {
+	    epe.events = epe_templ.events;
+	    epe.data.fd = epe_templ.data.fd;
+	    res = epoll_ctl(ps->kp_fd, op, fd, &epe);
+	} while (res != 0 && errno == EINTR);
+    }
+    ps->fds_status[fd].flags &= ~ERTS_POLL_FD_FLG_DISARMED;
+
 #if defined(ERTS_POLL_DEBUG_PRINT) && 1
     {
 	int saved_errno = errno;
@@ -1565,6 +1614,20 @@ save_kp_result(ErtsPollSet ps, ErtsPollResFd pr[], int max_res, int chk_fds_res)
 		    ps->fds_status[fd].res_ev_ix = (unsigned short) ix;
 		    res++;
 		}
+		if (ps->oneshot && ps->fds_status[fd].used_events) {
+		    /*
+		     * The kernel disarmed the fd when reporting it. If the
+		     * events are still selected when we poll next time, it
+		     * is re-armed by handle_update_requests() before the
+		     * epoll_wait(). An fd deselected before that, e.g. by
+		     * an {active, once} socket, costs no epoll_ctl() at all.
+		     */
+		    ps->fds_status[fd].used_events = 0;
+		    ps->fds_status[fd].flags |= ERTS_POLL_FD_FLG_DISARMED;
+		    ps->no_of_user_fds--;
+		    if (ps->fds_status[fd].events)
+			enqueue_update_request(ps, fd);
+		}
 	    }
 	}
 
@@ -2210,6 +2273,7 @@ ERTS_POLL_EXPORT(erts_poll_create_pollset)(void)
     kp_fd = epoll_create(256);
     ps->res_events_len = 0;
     ps->res_events = NULL;
+    ps->oneshot = 0;
 #elif ERTS_POLL_USE_DEVPOLL
     kp_fd = open("/dev/poll", O_RDWR);
     ps->res_events_len = 0;
@@ -2311,6 +2375,20 @@ ERTS_POLL_EXPORT(erts_poll_create_pollset)(void)
     return ps;
 }
 
+/*
+ * Let the kernel disarm fds as they trigger (EPOLLONESHOT), and re-arm
+ * them lazily. Has to be called before any fds are selected in the
+ * pollset. Only has effect with epoll.
+ */
+void
+ERTS_POLL_EXPORT(erts_poll_use_oneshot)(ErtsPollSet ps)
+{
+#if ERTS_POLL_USE_EPOLL
+    ASSERT(ps->no_of_user_fds == 0);
+    ps->oneshot = 1;
+#endif
+}
+
 void
 ERTS_POLL_EXPORT(erts_poll_destroy_pollset)(ErtsPollSet ps)
 {
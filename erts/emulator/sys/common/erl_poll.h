@@ -237,6 +237,7 @@ int		ERTS_POLL_EXPORT(erts_poll_max_fds)(void);
 void		ERTS_POLL_EXPORT(erts_poll_info)(ErtsPollSet,
 						 ErtsPollInfo *);
 ErtsPollSet	ERTS_POLL_EXPORT(erts_poll_create_pollset)(void);
+void		ERTS_POLL_EXPORT(erts_poll_use_oneshot)(ErtsPollSet);
 void		ERTS_POLL_EXPORT(erts_poll_destroy_pollset)(ErtsPollSet);
 void		ERTS_POLL_EXPORT(erts_poll_init)(void);
 void		ERTS_POLL_EXPORT(erts_poll_get_selected_events)(ErtsPollSet,
@@ -252,6 +252,10 @@ static int replace_intr = 0;
 /* assume yes initially, ttsl_init will clear it */
 int using_oldshell = 1; 
 
+int erts_no_pollsets = 1;
+int erts_use_poll_threads = 0;
+int erts_use_oneshot_poll = 0;
+
 #ifdef ERTS_ENABLE_KERNEL_POLL
 
 int erts_use_kernel_poll = 0;
@@ -265,6 +269,7 @@ struct {
     Uint (*size)(void);
     Eterm (*info)(void *);
     int (*check_io_debug)(void);
+    void (*task_executed)(Eterm, ErlDrvEvent, int);
 } io_func = {0};
 
 
@@ -304,6 +309,7 @@ init_check_io(void)
 	io_func.size			= erts_check_io_size_kp;
 	io_func.info			= erts_check_io_info_kp;
 	io_func.check_io_debug		= erts_check_io_debug_kp;
+	io_func.task_executed		= erts_check_io_task_executed_kp;
 	erts_init_check_io_kp();
 	max_files = erts_check_io_max_files_kp();
     }
@@ -316,6 +322,7 @@ init_check_io(void)
 	io_func.size			= erts_check_io_size_nkp;
 	io_func.info			= erts_check_io_info_nkp;
 	io_func.check_io_debug		= erts_check_io_debug_nkp;
+	io_func.task_executed		= erts_check_io_task_executed_nkp;
 	erts_init_check_io_nkp();
 	max_files = erts_check_io_max_files_nkp();
     }
@@ -325,6 +332,7 @@ init_check_io(void)
 #define ERTS_CHK_IO_INTR_TMD	(*io_func.check_io_interrupt_tmd)
 #define ERTS_CHK_IO		(*io_func.check_io)
 #define ERTS_CHK_IO_SZ		(*io_func.size)
+#define ERTS_CHK_IO_TASK_EXECUTED (*io_func.task_executed)
 
 #else /* !ERTS_ENABLE_KERNEL_POLL */
 
@@ -339,6 +347,7 @@ init_check_io(void)
 #define ERTS_CHK_IO_INTR_TMD	erts_check_io_interrupt_timed
 #define ERTS_CHK_IO		erts_check_io
 #define ERTS_CHK_IO_SZ		erts_check_io_size
+#define ERTS_CHK_IO_TASK_EXECUTED erts_check_io_task_executed
 
 #endif
 
@@ -354,6 +363,14 @@ erts_sys_schedule_interrupt_timed(int set, long msec)
 {
     ERTS_CHK_IO_INTR_TMD(set, msec);
 }
+
+void
+erts_sys_io_task_executed(Eterm id, ErlDrvEvent event, int mode)
+{
+    /* Only fds in pollsets of poll threads need to know */
+    if (erts_no_pollsets > 1 || erts_use_poll_threads)
+	ERTS_CHK_IO_TASK_EXECUTED(id, event, mode);
+}
 #endif
 
 Uint
@@ -3026,9 +3043,6 @@ erts_sys_main_thread(void)
 
 #endif /* ERTS_SMP */
 
-#ifdef ERTS_ENABLE_KERNEL_POLL /* get_value() is currently only used when
-				  kernel-poll is enabled */
-
 /* Get arg marks argument as handled by
    putting NULL in argv */
 static char *
@@ -3051,8 +3065,6 @@ get_value(char* rest, char** argv, int* ip)
     return rest;
 }
 
-#endif /* ERTS_ENABLE_KERNEL_POLL */
-
 void
 erl_sys_args(int* argc, char** argv)
 {
@@ -3081,6 +3093,39 @@ erl_sys_args(int* argc, char** argv)
 		break;
 	    }
 #endif
+	    case 'I':
+		if (strncmp(argv[i]+2, "Op", 2) == 0) {
+		    char *arg = get_value(argv[i] + 4, argv, &i);
+		    erts_no_pollsets = atoi(arg);
+		    if (erts_no_pollsets < 1
+			|| erts_no_pollsets > ERTS_MAX_NO_OF_POLLSETS) {
+			erts_fprintf(stderr, "bad \"IOp\" value: %s\n", arg);
+			erts_usage();
+		    }
+		}
+		else if (strncmp(argv[i]+2, "Ot", 2) == 0) {
+		    char *arg = get_value(argv[i] + 4, argv, &i);
+		    if (strcmp("true", arg) == 0)
+			erts_use_poll_threads = 1;
+		    else if (strcmp("false", arg) == 0)
+			erts_use_poll_threads = 0;
+		    else {
+			erts_fprintf(stderr, "bad \"IOt\" value: %s\n", arg);
+			erts_usage();
+		    }
+		}
+		else if (strncmp(argv[i]+2, "Oo", 2) == 0) {
+		    char *arg = get_value(argv[i] + 4, argv, &i);
+		    if (strcmp("true", arg) == 0)
+			erts_use_oneshot_poll = 1;
+		    else if (strcmp("false", arg) == 0)
+			erts_use_oneshot_poll = 0;
+		    else {
+			erts_fprintf(stderr, "bad \"IOo\" value: %s\n", arg);
+			erts_usage();
+		    }
+		}
+		break;
 	    case '-':
 		goto done_parsing;
 	    default:
@@ -142,6 +142,7 @@ WDD_TYPEDEF(void, erl_drv_thread_exit, (void *resp));
 WDD_TYPEDEF(int, erl_drv_thread_join, (ErlDrvTid, void **respp));
 WDD_TYPEDEF(int, erl_drv_putenv, (char *key, char *value));
 WDD_TYPEDEF(int, erl_drv_getenv, (char *key, char *value, size_t *value_size));
+WDD_TYPEDEF(ErlDrvBinary *, driver_alloc_extern_binary, (char *, ErlDrvUInt, void (*)(char *, ErlDrvUInt)));
 
 typedef struct {
     WDD_FTYPE(null_func) *null_func;
@@ -243,6 +244,7 @@ typedef struct {
     WDD_FTYPE(erl_drv_thread_join) *erl_drv_thread_join;
     WDD_FTYPE(erl_drv_putenv) *erl_drv_putenv;
     WDD_FTYPE(erl_drv_getenv) *erl_drv_getenv;
+    WDD_FTYPE(driver_alloc_extern_binary) *driver_alloc_extern_binary;
   /* Add new calls here */
 } TWinDynDriverCallbacks;   
 
@@ -357,6 +359,8 @@ extern TWinDynDriverCallbacks WinDynDriverCallbacks;
 #define erl_drv_thread_join (WinDynDriverCallbacks.erl_drv_thread_join)
 #define erl_drv_putenv (WinDynDriverCallbacks.erl_drv_putenv)
 #define erl_drv_getenv (WinDynDriverCallbacks.erl_drv_getenv)
+#define driver_alloc_extern_binary \
+(WinDynDriverCallbacks.driver_alloc_extern_binary)
 
 /* The only variable in the interface... */
 #define driver_term_nil (driver_mk_term_nil())
@@ -481,6 +485,7 @@ do {				                        \
 ((W).erl_drv_thread_join) = erl_drv_thread_join;	\
 ((W).erl_drv_putenv) = erl_drv_putenv;			\
 ((W).erl_drv_getenv) = erl_drv_getenv;			\
+((W).driver_alloc_extern_binary) = driver_alloc_extern_binary;\
 } while (0)
 
 
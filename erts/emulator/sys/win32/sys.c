@@ -3007,6 +3007,12 @@ erts_sys_schedule_interrupt_timed(int set, long msec)
 {
     erts_check_io_interrupt_timed(set, msec);
 }
+
+void
+erts_sys_io_task_executed(Eterm id, ErlDrvEvent event, int mode)
+{
+    /* Nothing to do; events are only polled by the schedulers */
+}
 #endif
 
 /*
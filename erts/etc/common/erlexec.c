@@ -108,6 +108,8 @@ static char *plusM_other_switches[] = {
     "Mrmcbf",
     "Mmcs",
     "Mcci",
+    "Mscs",
+    "Msco",
     "Fe",
     "Ye",
     "Ym",
@@ -116,10 +118,28 @@ static char *plusM_other_switches[] = {
     NULL
 };
 
+/* +h arguments with values */
+static char *plush_val_switches[] = {
+    "",
+    "mbs",
+    "pgc",
+    "pred",
+    NULL
+};
+
+/* +I arguments with values */
+static char *plusI_val_switches[] = {
+    "Oo",
+    "Op",
+    "Ot",
+    NULL
+};
+
 /* +s arguments with values */
 static char *pluss_val_switches[] = {
     "bt",
     "ct",
+    "pp",
     "ss",
     NULL
 };
@@ -781,7 +801,6 @@ int main(int argc, char **argv)
 		  case 'a':
 		  case 'A':
 		  case 'b':
-		  case 'h':
 		  case 'i':
 		  case 'P':
 		  case 'S':
@@ -848,6 +867,36 @@ int main(int argc, char **argv)
 			  goto the_default;
 		      break;
 		  }
+		  case 'h':
+		      if (!is_one_of_strings(&argv[i][2],
+					     plush_val_switches))
+			  goto the_default;
+		      else {
+			  if (i+1 >= argc
+			      || argv[i+1][0] == '-'
+			      || argv[i+1][0] == '+')
+			      usage(argv[i]);
+			  argv[i][0] = '-';
+			  add_Eargs(argv[i]);
+			  add_Eargs(argv[i+1]);
+			  i++;
+		      }
+		      break;
+		  case 'I':
+		      if (!is_one_of_strings(&argv[i][2],
+					     plusI_val_switches))
+			  goto the_default;
+		      else {
+			  if (i+1 >= argc
+			      || argv[i+1][0] == '-'
+			      || argv[i+1][0] == '+')
+			      usage(argv[i]);
+			  argv[i][0] = '-';
+			  add_Eargs(argv[i]);
+			  add_Eargs(argv[i+1]);
+			  i++;
+		      }
+		      break;
 		  case 's':
 		      if (!is_one_of_strings(&argv[i][2],
 					     pluss_val_switches))
@@ -26,7 +26,8 @@
 
 %% Generic file contents operations
 -export([open/2, close/1, sync/1, position/2, truncate/1,
-	 write/2, pwrite/2, pwrite/3, read/2, read_line/1, pread/2, pread/3, copy/3]).
+	 write/2, pwrite/2, pwrite/3, read/2, read_line/1, pread/2, pread/3, copy/3,
+	 sendfile/4, cache_info/1]).
 
 %% Specialized file operations
 -export([open/1, open/3]).
@@ -96,6 +97,7 @@
 -define(FILE_IPREAD,           27).
 -define(FILE_ALTNAME,          28).
 -define(FILE_READ_LINE,        29).
+-define(FILE_CACHE_INFO,       30).
 
 %% Driver responses
 -define(FILE_RESP_OK,          0).
@@ -126,6 +128,7 @@
 %% Options
 -define(FILE_OPT_DELAYED_WRITE, 0).
 -define(FILE_OPT_READ_AHEAD,    1).
+-define(FILE_OPT_MMAP,          2).
 
 %% IPREAD variants
 -define(IPREAD_S32BU_P32BU, 0).
@@ -424,6 +427,35 @@ copy(#file_descriptor{module = ?MODULE} = Source,
 
 
 
+%% Sends Length bytes (0 = until end of file) from offset Offset in the
+%% file on the connected TCP socket Socket, without reading them into
+%% the emulator.
+%% Returns {error, Reason} | {ok, BytesSent}
+sendfile(#file_descriptor{module = ?MODULE, data = {_, Fd}},
+	 Socket, Offset, Length) ->
+    prim_inet:sendfile(Socket, Fd, Offset, Length).
+
+
+
+%% Returns the read-ahead and delayed write counters of the file,
+%% showing how well they suit the access pattern.
+%% Returns {ok, [{Counter, Value}]} | {error, Reason}
+cache_info(#file_descriptor{module = ?MODULE, data = {Port, _}}) ->
+    case drv_command(Port, <<?FILE_CACHE_INFO>>) of
+	{ok, {_Size, Data}} ->
+	    <<Hits:64, Misses:64, ReadAhead:64, Dropped:64,
+	     Delayed:64, Flushes:64>> = iolist_to_binary(Data),
+	    {ok, [{read_hits, Hits},
+		  {read_misses, Misses},
+		  {read_ahead, ReadAhead},
+		  {read_ahead_dropped, Dropped},
+		  {writes_delayed, Delayed},
+		  {write_flushes, Flushes}]};
+	Error ->
+	    Error
+    end.
+
+
 ipread_s32bu_p32bu(#file_descriptor{module = ?MODULE,
 				    data = {_, _}} = Handle,
 		   Offs,
@@ -945,6 +977,11 @@ open_mode([{read_ahead, Size}|Rest], Mode, Portopts, Setopts)
 	true ->
 	    einval
     end;
+%% Reading a mapped file that another process truncates crashes the
+%% emulator, so the mode has to be asked for as unsafe.
+open_mode([{mmap, unsafe}|Rest], Mode, Portopts, Setopts) ->
+    open_mode(Rest, Mode, Portopts,
+	      [<<?FILE_SETOPT, ?FILE_OPT_MMAP>> | Setopts]);
 open_mode([], Mode, Portopts, Setopts) ->
     {Mode, reverse(Portopts), reverse(Setopts)};
 open_mode(_, _Mode, _Portopts, _Setopts) ->
@@ -30,7 +30,7 @@
 -export([connect/3, connect/4, async_connect/4]).
 -export([accept/1, accept/2, async_accept/2]).
 -export([shutdown/2]).
--export([send/2, sendto/4, sendmsg/3]).
+-export([send/2, sendto/4, sendmany/2, sendmsg/3, sendfile/4]).
 -export([recv/2, recv/3, async_recv/3]).
 -export([unrecv/2]).
 -export([recvfrom/2, recvfrom/3]).
@@ -372,6 +372,35 @@ send(S, Data) when is_port(S) ->
 	     {error,einval}
     end.
 
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%%
+%% SENDFILE(insock(), Fd, Offset, Length) -> {ok, BytesSent} | {error, Reason}
+%%
+%% send Length bytes (0 = until end of file) from offset Offset of the
+%% open file with os file descriptor Fd on a connected TCP socket, after
+%% any data already queued on it. The data is not copied through the
+%% emulator. The driver sends from a duplicate of Fd, so closing Fd
+%% while the call is in progress does not affect what is sent.
+%%
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+sendfile(S, Fd, Offset, Length)
+  when is_port(S), is_integer(Fd), Fd >= 0,
+       is_integer(Offset), Offset >= 0, Offset < (1 bsl 63),
+       is_integer(Length), Length >= 0, Length < (1 bsl 63) ->
+    case ctl_cmd(S, ?TCP_REQ_SENDFILE, <<Fd:32,Offset:64,Length:64>>) of
+	{ok, []} ->
+	    receive
+		{sendfile,S,{ok,SentHi,SentLo}} ->
+		    {ok,(SentHi bsl 32) bor SentLo};
+		{sendfile,S,{error,_}=Error} ->
+		    Error
+	    end;
+	Error -> Error
+    end;
+sendfile(_, _, _, _) ->
+    {error,einval}.
+
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %%
 %% SENDTO(insock(), IP, Port, Data) -> ok | {error, Reason}
@@ -397,6 +426,30 @@ sendto(S, IP, Port, Data) when is_port(S), Port >= 0, Port =< 65535 ->
 	     {error,einval}
     end.
 
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+%%
+%% SENDMANY(insock(), [{IP, Port, Data}]) -> {ok, Count} | {error, Reason}
+%%
+%% send several Datagrams in one request. Count is the number of datagrams
+%% (from the head of the list) that were sent before the socket would block.
+%%
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+sendmany(S, Packets) when is_port(S), is_list(Packets) ->
+    try [[?int16(Port),ip_to_bytes(IP),?int32(iolist_size(Data)),Data] ||
+	    {IP,Port,Data} <- Packets, Port >= 0, Port =< 65535] of
+	Buf when length(Buf) =:= length(Packets) ->
+	    case ctl_cmd(S, ?UDP_REQ_SENDMANY, Buf) of
+		{ok,[C3,C2,C1,C0]} -> {ok,?u32(C3,C2,C1,C0)};
+		Error -> Error
+	    end;
+	_ -> {error,einval}
+    catch
+	error:_ -> {error,einval}
+    end;
+sendmany(_, _) ->
+    {error,einval}.
+
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %%
 %% SENDMSG(insock(), IP, Port, InitMsg, Data)   or
@@ -923,6 +976,8 @@ attach(S) when is_port(S) ->
 %%
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+is_sockopt_val(active, N) when is_integer(N) ->
+    N >= -?INET_ACTIVE_N_MAX andalso N =< ?INET_ACTIVE_N_MAX;
 is_sockopt_val(Opt, Val) ->
     Type = type_opt(set, Opt),
     try type_value(set, Type, Val)
@@ -934,6 +989,7 @@ is_sockopt_val(Opt, Val) ->
 %% Socket options processing: Encoding option NAMES:
 %%
 enc_opt(reuseaddr)       -> ?INET_OPT_REUSEADDR;
+enc_opt(reuseport)       -> ?INET_OPT_REUSEPORT;
 enc_opt(keepalive)       -> ?INET_OPT_KEEPALIVE;
 enc_opt(dontroute)       -> ?INET_OPT_DONTROUTE;
 enc_opt(linger)          -> ?INET_OPT_LINGER;
@@ -943,6 +999,7 @@ enc_opt(recbuf)          -> ?INET_OPT_RCVBUF;
 enc_opt(priority)        -> ?INET_OPT_PRIORITY;
 enc_opt(tos)             -> ?INET_OPT_TOS;
 enc_opt(nodelay)         -> ?TCP_OPT_NODELAY;
+enc_opt(nopush)          -> ?TCP_OPT_NOPUSH;
 enc_opt(multicast_if)    -> ?UDP_OPT_MULTICAST_IF;
 enc_opt(multicast_ttl)   -> ?UDP_OPT_MULTICAST_TTL;
 enc_opt(multicast_loop)  -> ?UDP_OPT_MULTICAST_LOOP;
@@ -961,8 +1018,10 @@ enc_opt(bit8)            -> ?INET_LOPT_BIT8;
 enc_opt(send_timeout)    -> ?INET_LOPT_TCP_SEND_TIMEOUT;
 enc_opt(send_timeout_close) -> ?INET_LOPT_TCP_SEND_TIMEOUT_CLOSE;
 enc_opt(delay_send)      -> ?INET_LOPT_TCP_DELAY_SEND;
+enc_opt(delay_send_limit) -> ?INET_LOPT_TCP_DELAY_SEND_LIMIT;
 enc_opt(packet_size)     -> ?INET_LOPT_PACKET_SIZE;
 enc_opt(read_packets)    -> ?INET_LOPT_READ_PACKETS;
+enc_opt(batch_packets)   -> ?INET_LOPT_UDP_BATCH_PACKETS;
 enc_opt(raw)             -> ?INET_OPT_RAW;
 % Names of SCTP opts:
 enc_opt(sctp_rtoinfo)	 	   -> ?SCTP_OPT_RTOINFO;
@@ -988,6 +1047,7 @@ enc_opt(sctp_get_peer_addr_info)   -> ?SCTP_OPT_GET_PEER_ADDR_INFO.
 %% Decoding option NAMES:
 %%
 dec_opt(?INET_OPT_REUSEADDR)      -> reuseaddr;
+dec_opt(?INET_OPT_REUSEPORT)      -> reuseport;
 dec_opt(?INET_OPT_KEEPALIVE)      -> keepalive;
 dec_opt(?INET_OPT_DONTROUTE)      -> dontroute;
 dec_opt(?INET_OPT_LINGER)         -> linger;
@@ -997,6 +1057,7 @@ dec_opt(?INET_OPT_RCVBUF)         -> recbuf;
 dec_opt(?INET_OPT_PRIORITY)       -> priority;
 dec_opt(?INET_OPT_TOS)            -> tos;
 dec_opt(?TCP_OPT_NODELAY)         -> nodelay;
+dec_opt(?TCP_OPT_NOPUSH)          -> nopush;
 dec_opt(?UDP_OPT_MULTICAST_IF)    -> multicast_if;
 dec_opt(?UDP_OPT_MULTICAST_TTL)   -> multicast_ttl;
 dec_opt(?UDP_OPT_MULTICAST_LOOP)  -> multicast_loop;
@@ -1015,8 +1076,10 @@ dec_opt(?INET_LOPT_BIT8)          -> bit8;
 dec_opt(?INET_LOPT_TCP_SEND_TIMEOUT) -> send_timeout;
 dec_opt(?INET_LOPT_TCP_SEND_TIMEOUT_CLOSE) -> send_timeout_close;
 dec_opt(?INET_LOPT_TCP_DELAY_SEND)   -> delay_send;
+dec_opt(?INET_LOPT_TCP_DELAY_SEND_LIMIT) -> delay_send_limit;
 dec_opt(?INET_LOPT_PACKET_SIZE)      -> packet_size;
 dec_opt(?INET_LOPT_READ_PACKETS)     -> read_packets;
+dec_opt(?INET_LOPT_UDP_BATCH_PACKETS) -> batch_packets;
 dec_opt(?INET_OPT_RAW)              -> raw;
 dec_opt(I) when is_integer(I)     -> undefined.
 
@@ -1057,6 +1120,7 @@ type_opt(_,   Opt) ->
 %% Types of option values, by option name:
 %%
 type_opt_1(reuseaddr)       -> bool;
+type_opt_1(reuseport)       -> bool;
 type_opt_1(keepalive)       -> bool;
 type_opt_1(dontroute)       -> bool;
 type_opt_1(linger)          -> {bool,int};
@@ -1066,6 +1130,7 @@ type_opt_1(recbuf)          -> int;
 type_opt_1(priority)        -> int;
 type_opt_1(tos)             -> int;
 type_opt_1(nodelay)         -> bool;
+type_opt_1(nopush)          -> bool;
 %% multicast
 type_opt_1(multicast_ttl)   -> int;
 type_opt_1(multicast_loop)  -> bool;
@@ -1114,8 +1179,10 @@ type_opt_1(bit8) ->
 type_opt_1(send_timeout)    -> time;
 type_opt_1(send_timeout_close) -> bool;
 type_opt_1(delay_send)      -> bool;
+type_opt_1(delay_send_limit) -> uint;
 type_opt_1(packet_size)     -> uint;
 type_opt_1(read_packets)    -> uint;
+type_opt_1(batch_packets)   -> bool;
 %% 
 %% SCTP options (to be set). If the type is a record type, the corresponding
 %% record signature is returned, otherwise, an "elementary" type tag 
@@ -1537,6 +1604,11 @@ enc_opt_val([{active,once}|Opts], Acc) ->
     %% every packet, not only once when initializing the socket.
     %% Measurements show that this optimization is worthwhile.
     enc_opt_val(Opts, [<<?INET_LOPT_ACTIVE:8,?INET_ONCE:32>>|Acc]);
+enc_opt_val([{active,N}|Opts], Acc)
+  when is_integer(N), N >= -?INET_ACTIVE_N_MAX, N =< ?INET_ACTIVE_N_MAX ->
+    %% {active,N} adds N to the number of messages to deliver before
+    %% the socket turns passive and sends {tcp_passive|udp_passive, S}.
+    enc_opt_val(Opts, [<<?INET_LOPT_ACTIVE_N:8,N:32>>|Acc]);
 enc_opt_val([{raw,P,O,B}|Opts], Acc) ->
     enc_opt_val(Opts, Acc, raw, {P,O,B});
 enc_opt_val([{Opt,Val}|Opts], Acc) ->
@@ -1613,6 +1685,10 @@ decode_opt_val(Buf) ->
 	Error  -> {error,Error}
     end.
 
+dec_opt_val([?INET_LOPT_ACTIVE_N|Buf]) ->
+    %% {active,N} is reported with the number of messages left
+    {N,T} = dec_value(int, Buf),
+    [{active,N}|dec_opt_val(T)];
 dec_opt_val([B|Buf]=BBuf) ->
     case dec_opt(B) of
 	undefined ->
@@ -26,6 +26,7 @@
 
 %%-compile(export_all).
 -export([handshake_we_started/1, handshake_other_started/1,
+	 stripe_we_started/2,
 	 start_timer/1, setup_timer/2, 
 	 reset_timer/1, cancel_timer/1,
 	 shutdown/3, shutdown/4]).
@@ -115,11 +116,28 @@ make_this_flags(RequestType, OtherNode) ->
 	 ?DFLAG_NEW_FLOATS bor
 	 ?DFLAG_UNICODE_IO bor
 	 ?DFLAG_DIST_HDR_ATOM_CACHE bor
-	 ?DFLAG_SMALL_ATOM_TAGS).
+	 ?DFLAG_SMALL_ATOM_TAGS bor
+	 ?DFLAG_FRAGMENTS).
 
-handshake_other_started(#hs_data{request_type=ReqType}=HSData0) ->
-    {PreOtherFlags,Node,Version} = recv_name(HSData0),
-    PreThisFlags = make_this_flags(ReqType, Node),
+stripes_flag(#hs_data{stripes = 0}) ->
+    0;
+stripes_flag(_) ->
+    ?DFLAG_STRIPES.
+
+handshake_other_started(HSData0) ->
+    case recv_name(HSData0) of
+	{stripe,OtherFlags,Node,Version} ->
+	    stripe_other_started(HSData0#hs_data{other_flags=OtherFlags,
+						 other_version=Version,
+						 other_node=Node,
+						 other_started=true});
+	{PreOtherFlags,Node,Version} ->
+	    connection_other_started(HSData0, PreOtherFlags, Node, Version)
+    end.
+
+connection_other_started(#hs_data{request_type=ReqType}=HSData0,
+			 PreOtherFlags, Node, Version) ->
+    PreThisFlags = make_this_flags(ReqType, Node) bor stripes_flag(HSData0),
     {ThisFlags, OtherFlags} = adjust_flags(PreThisFlags,
 					   PreOtherFlags),
     HSData = HSData0#hs_data{this_flags=ThisFlags,
@@ -310,7 +328,7 @@ flush_down() ->
 
 handshake_we_started(#hs_data{request_type=ReqType,
 			      other_node=Node}=PreHSData) ->
-    PreThisFlags = make_this_flags(ReqType, Node),
+    PreThisFlags = make_this_flags(ReqType, Node) bor stripes_flag(PreHSData),
     HSData = PreHSData#hs_data{this_flags=PreThisFlags},
     send_name(HSData),
     recv_status(HSData),
@@ -337,13 +355,16 @@ connection(#hs_data{other_node = Node,
 		    f_address = FAddress,
 		    f_setopts_pre_nodeup = FPreNodeup,
 		    f_setopts_post_nodeup = FPostNodeup}= HSData) ->
+    Stripes = setup_stripes(HSData),
     cancel_timer(HSData#hs_data.timer),
     PType = publish_type(HSData#hs_data.other_flags), 
     case FPreNodeup(Socket) of
 	ok -> 
-	    do_setnode(HSData), % Succeeds or exits the process.
+	    do_setnode(HSData, Stripes), % Succeeds or exits the process.
 	    Address = FAddress(Socket,Node),
 	    mark_nodeup(HSData,Address),
+	    lists:foreach(fun({Pid,_}) -> Pid ! {self(), stripe_up} end,
+			  Stripes),
 	    case FPostNodeup(Socket) of
 		ok ->
 		    con_loop(HSData#hs_data.kernel_pid, 
@@ -354,7 +375,144 @@ connection(#hs_data{other_node = Node,
 			     PType,
 			     #tick{},
 			     HSData#hs_data.mf_tick,
-			     HSData#hs_data.mf_getstat);
+			     HSData#hs_data.mf_getstat,
+			     [Pid || {Pid,_} <- Stripes]);
+		_ ->
+		    ?shutdown2(Node, connection_setup_failed)
+	    end;
+	_ ->
+	    ?shutdown(Node)
+    end.
+
+%% --------------------------------------------------------------
+%% Extra connections (stripes) to the node, set up when both want
+%% them. A process that sends signals to the node always uses the
+%% same connection, so the signals of it stay in order. The owner of
+%% the connection passes each tick on to the stripe processes, which
+%% tick and check their own connection the same way; any of the
+%% connections going down or not responding takes the node down.
+%% --------------------------------------------------------------
+
+%% Returns [{StripePid, LowLevelPort}] once all of them are up.
+setup_stripes(#hs_data{this_flags = ThisFlags,
+		       other_flags = OtherFlags} = HSData)
+  when ThisFlags band OtherFlags band ?DFLAG_STRIPES =/= 0 ->
+    N = negotiate_stripes(HSData),
+    case HSData#hs_data.other_started of
+	false ->
+	    lists:foreach(fun(_) ->
+				  spawn_link(?MODULE, stripe_we_started,
+					     [HSData, self()])
+			  end, lists:seq(1, N));
+	true ->
+	    ok
+    end,
+    wait_stripes(HSData, N, []);
+setup_stripes(_) ->
+    [].
+
+%% The one that started asks for the number of stripes it wants, and
+%% the other side answers with how many of them it will take.
+negotiate_stripes(#hs_data{other_node = Node, socket = Socket,
+			   f_send = FSend, f_recv = FRecv,
+			   stripes = Stripes, other_started = false}) ->
+    send_stripes(FSend, Socket, Stripes),
+    case FRecv(Socket, 0, infinity) of
+	{ok, [$S, N1, N0]} ->
+	    ?u16(N1, N0);
+	_ ->
+	    ?shutdown(Node)
+    end;
+negotiate_stripes(#hs_data{other_node = Node, socket = Socket,
+			   f_send = FSend, f_recv = FRecv,
+			   stripes = Stripes, other_started = true}) ->
+    case FRecv(Socket, 0, infinity) of
+	{ok, [$S, N1, N0]} ->
+	    N = lists:min([?u16(N1, N0), Stripes]),
+	    send_stripes(FSend, Socket, N),
+	    N;
+	_ ->
+	    ?shutdown(Node)
+    end.
+
+send_stripes(FSend, Socket, N) ->
+    ?to_port(FSend, Socket, [$S, ?int16(N)]).
+
+wait_stripes(_HSData, 0, Stripes) ->
+    Stripes;
+wait_stripes(HSData, N, Stripes) ->
+    receive
+	{Pid, {stripe, Port}} when is_pid(Pid), is_port(Port) ->
+	    reset_timer(HSData#hs_data.timer),
+	    wait_stripes(HSData, N-1, [{Pid, Port} | Stripes])
+    end.
+
+%% Runs in a process of its own, linked to Owner.
+stripe_we_started(#hs_data{other_node = Node,
+			   f_stripe = FStripe} = HSData0, Owner) ->
+    Timer = start_timer(net_kernel:connecttime()),
+    case FStripe() of
+	{ok, Socket} ->
+	    HSData = HSData0#hs_data{socket = Socket, timer = Timer},
+	    send_stripe_name(HSData),
+	    recv_status(HSData),
+	    {_OtherFlags,ChallengeA} = recv_challenge(HSData),
+	    MyChallenge = gen_challenge(),
+	    {MyCookie,HisCookie} = get_cookies(Node),
+	    send_challenge_reply(HSData, MyChallenge,
+				 gen_digest(ChallengeA, HisCookie)),
+	    reset_timer(Timer),
+	    recv_challenge_ack(HSData, MyChallenge, MyCookie),
+	    stripe_connection(HSData, Owner);
+	_ ->
+	    ?shutdown(Node)
+    end.
+
+stripe_other_started(#hs_data{other_node = Node} = HSData) ->
+    is_allowed(HSData),
+    Owner = stripe_owner(HSData),
+    {MyCookie,HisCookie} = get_cookies(Node),
+    ChallengeA = gen_challenge(),
+    send_challenge(HSData, ChallengeA),
+    reset_timer(HSData#hs_data.timer),
+    ChallengeB = recv_challenge_reply(HSData, ChallengeA, MyCookie),
+    send_challenge_ack(HSData, gen_digest(ChallengeB, HisCookie)),
+    stripe_connection(HSData, Owner).
+
+%% The process setting up the connection to the node that the stripe
+%% belongs to.
+stripe_owner(#hs_data{kernel_pid = Kernel, other_node = Node} = HSData) ->
+    Kernel ! {self(), {stripe_pending, Node}},
+    receive
+	{Kernel, {stripe_pending, Owner}} when is_pid(Owner) ->
+	    send_status(HSData, ok),
+	    reset_timer(HSData#hs_data.timer),
+	    Owner;
+	{Kernel, {stripe_pending, _}} ->
+	    send_status(HSData, not_allowed),
+	    ?shutdown(Node)
+    end.
+
+stripe_connection(#hs_data{other_node = Node, socket = Socket,
+			   other_flags = OtherFlags,
+			   f_setopts_pre_nodeup = FPreNodeup,
+			   f_setopts_post_nodeup = FPostNodeup,
+			   f_getll = GetLL,
+			   mf_tick = MFTick,
+			   mf_getstat = MFGetstat} = HSData, Owner) ->
+    link(Owner),
+    cancel_timer(HSData#hs_data.timer),
+    case {FPreNodeup(Socket), GetLL(Socket)} of
+	{ok, {ok, Port}} ->
+	    Owner ! {self(), {stripe, Port}},
+	    receive
+		{Owner, stripe_up} ->
+		    ok
+	    end,
+	    case FPostNodeup(Socket) of
+		ok ->
+		    stripe_loop(Node, Socket, Owner, publish_type(OtherFlags),
+				#tick{}, MFTick, MFGetstat);
 		_ ->
 		    ?shutdown2(Node, connection_setup_failed)
 	    end;
@@ -362,6 +520,25 @@ connection(#hs_data{other_node = Node,
 	    ?shutdown(Node)
     end.
 
+stripe_loop(Node, Socket, Owner, Type, Tick, MFTick, MFGetstat) ->
+    receive
+	{tcp_closed, Socket} ->
+	    ?shutdown2(Node, connection_closed);
+	{Owner, tick} ->
+	    case send_tick(Socket, Tick, Type, MFTick, MFGetstat) of
+		{ok, NewTick} ->
+		    stripe_loop(Node, Socket, Owner, Type, NewTick,
+				MFTick, MFGetstat);
+		{error, not_responding} ->
+		    error_msg("** Node ~p not responding on a stripe **~n"
+			      "** Removing (timedout) connection **~n",
+			      [Node]),
+		    ?shutdown2(Node, net_tick_timeout);
+		_Other ->
+		    ?shutdown2(Node, send_net_tick_failed)
+	    end
+    end.
+
 %% Generate a message digest from Challenge number and Cookie	
 gen_digest(Challenge, Cookie) when is_integer(Challenge), is_atom(Cookie) ->
     erlang:md5([atom_to_list(Cookie)|integer_to_list(Challenge)]).
@@ -398,16 +575,21 @@ get_cookies(Node) ->
 %% No error return; either succeeds or terminates the process.
 do_setnode(#hs_data{other_node = Node, socket = Socket, 
 		    other_flags = Flags, other_version = Version,
-		    f_getll = GetLL}) ->
+		    f_getll = GetLL}, Stripes) ->
     case GetLL(Socket) of
 	{ok,Port} ->
 	    ?trace("setnode(md5,~p ~p ~p)~n", 
 		   [Node, Port, {publish_type(Flags), 
 				 '(', Flags, ')', 
 				 Version}]),
-	    case (catch 
-		  erlang:setnode(Node, Port, 
-				 {Flags, Version, '', ''})) of
+	    Info = case Stripes of
+		       [] ->
+			   {Flags, Version, '', ''};
+		       _ ->
+			   {Flags, Version, '', '',
+			    [StripePort || {_,StripePort} <- Stripes]}
+		   end,
+	    case (catch erlang:setnode(Node, Port, Info)) of
 		{'EXIT', {system_limit, _}} ->
 		    error_msg("** Distribution system limit reached, "
 			      "no table space left for node ~w ** ~n",
@@ -449,7 +631,7 @@ mark_nodeup(#hs_data{kernel_pid = Kernel,
     end.
 
 con_loop(Kernel, Node, Socket, TcpAddress,
-	 MyNode, Type, Tick, MFTick, MFGetstat) ->
+	 MyNode, Type, Tick, MFTick, MFGetstat, Stripes) ->
     receive
 	{tcp_closed, Socket} ->
 	    ?shutdown2(Node, connection_closed);
@@ -463,14 +645,15 @@ con_loop(Kernel, Node, Socket, TcpAddress,
 		    ignore_it
 	    end,
 	    con_loop(Kernel, Node, Socket, TcpAddress, MyNode, Type,
-		     Tick, MFTick, MFGetstat);
+		     Tick, MFTick, MFGetstat, Stripes);
 	{Kernel, tick} ->
+	    lists:foreach(fun(Pid) -> Pid ! {self(), tick} end, Stripes),
 	    case send_tick(Socket, Tick, Type, 
 			   MFTick, MFGetstat) of
 		{ok, NewTick} ->
 		    con_loop(Kernel, Node, Socket, TcpAddress,
 			     MyNode, Type, NewTick, MFTick,  
-			     MFGetstat);
+			     MFGetstat, Stripes);
 		{error, not_responding} ->
  		    error_msg("** Node ~p not responding **~n"
  			      "** Removing (timedout) connection **~n",
@@ -486,7 +669,7 @@ con_loop(Kernel, Node, Socket, TcpAddress,
 		    con_loop(Kernel, Node, Socket, TcpAddress, 
 			     MyNode, 
 			     Type, Tick, 
-			     MFTick, MFGetstat);
+			     MFTick, MFGetstat, Stripes);
 		_ ->
 		    ?shutdown2(Node, get_status_failed)
 	    end
@@ -506,6 +689,15 @@ send_name(#hs_data{socket = Socket, this_node = Node,
     ?to_port(FSend, Socket, 
 	     [$n, ?int16(Version), ?int32(Flags), atom_to_list(Node)]).
 
+send_stripe_name(#hs_data{socket = Socket, this_node = Node, 
+			  f_send = FSend, 
+			  this_flags = Flags,
+			  other_version = Version}) ->
+    ?trace("send_stripe_name: node=~w, version=~w\n",
+	   [Node,Version]),
+    ?to_port(FSend, Socket, 
+	     [$N, ?int16(Version), ?int32(Flags), atom_to_list(Node)]).
+
 send_challenge(#hs_data{socket = Socket, this_node = Node, 
 			other_version = Version, 
 			this_flags = Flags,
@@ -547,6 +739,9 @@ recv_name(#hs_data{socket = Socket, f_recv = Recv}) ->
 get_name([$n,VersionA, VersionB, Flag1, Flag2, Flag3, Flag4 | OtherNode]) ->
     {?u32(Flag1, Flag2, Flag3, Flag4), list_to_atom(OtherNode), 
      ?u16(VersionA,VersionB)};
+get_name([$N,VersionA, VersionB, Flag1, Flag2, Flag3, Flag4 | OtherNode]) ->
+    {stripe, ?u32(Flag1, Flag2, Flag3, Flag4), list_to_atom(OtherNode), 
+     ?u16(VersionA,VersionB)};
 get_name(Data) ->
     ?shutdown(Data).
 
@@ -79,7 +79,7 @@
 -type filemodes() :: ['read' | 'write' | 'append' | 'raw' | 'binary' | 
 		      {'delayed_write', non_neg_integer(), non_neg_integer()} | 
 		      'delayed_write' | {'read_ahead', pos_integer()} | 
-		      'read_ahead' | 'compressed'].
+		      'read_ahead' | 'compressed' | {'mmap', 'unsafe'}].
 -type bindings()  :: any().
 
 %%%-----------------------------------------------------------------
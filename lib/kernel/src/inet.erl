@@ -82,6 +82,7 @@
       {'raw', non_neg_integer(), non_neg_integer(), binary()} |
       %% TCP/UDP options
       {'reuseaddr',       boolean()} |
+      {'reuseport',       boolean()} |
       {'keepalive',       boolean()} |
       {'dontroute',       boolean()} |
       {'linger',          {boolean(), non_neg_integer()}} |
@@ -91,6 +92,7 @@
       {'priority',        non_neg_integer()} |
       {'tos',             non_neg_integer()} |
       {'nodelay',         boolean()} |
+      {'nopush',          boolean()} |
       {'multicast_ttl',   non_neg_integer()} |
       {'multicast_loop',  boolean()} |
       {'multicast_if',    ip_address()} |
@@ -98,7 +100,7 @@
       {'drop_membership', {ip_address(), ip_address()}} |
       {'header',          non_neg_integer()} |
       {'buffer',          non_neg_integer()} |
-      {'active',          boolean() | 'once'} |
+      {'active',          boolean() | 'once' | integer()} |
       {'packet',        
        0 | 1 | 2 | 4 | 'raw' | 'sunrm' |  'asn1' |
        'cdr' | 'fcgi' | 'line' | 'tpkt' | 'http' | 'httph' | 'http_bin' | 'httph_bin' } |
@@ -111,8 +113,10 @@
       {'send_timeout',    non_neg_integer() | 'infinity'} |
       {'send_timeout_close', boolean()} |
       {'delay_send',      boolean()} |
+      {'delay_send_limit', non_neg_integer()} |
       {'packet_size',     non_neg_integer()} |
       {'read_packets',    non_neg_integer()} |
+      {'batch_packets',   boolean()} |
       %% SCTP options
       {'sctp_rtoinfo',               #sctp_rtoinfo{}} |
       {'sctp_associnfo',             #sctp_assocparams{}} |
@@ -134,14 +138,16 @@
       {'raw',
        non_neg_integer(), non_neg_integer(), binary()|non_neg_integer()} |
       %% TCP/UDP options
-      'reuseaddr' | 'keepalive' | 'dontroute' | 'linger' |
+      'reuseaddr' | 'reuseport' | 'keepalive' | 'dontroute' | 'linger' |
       'broadcast' | 'sndbuf' | 'recbuf' | 'priority' | 'tos' | 'nodelay' | 
+      'nopush' |
       'multicast_ttl' | 'multicast_loop' | 'multicast_if' | 
       'add_membership' | 'drop_membership' | 
       'header' | 'buffer' | 'active' | 'packet' | 'mode' | 'port' | 
       'exit_on_close' | 'low_watermark' | 'high_watermark' | 'bit8' | 
       'send_timeout' | 'send_timeout_close' |
-      'delay_send' | 'packet_size' | 'read_packets' | 
+      'delay_send' | 'delay_send_limit' |
+      'packet_size' | 'read_packets' | 'batch_packets' |
       %% SCTP options
       {'sctp_status',                #sctp_status{}} |
       'sctp_get_peer_addr_info' |
@@ -536,8 +542,8 @@ getservbyname(Name, Protocol) when is_atom(Name) ->
 %% Return a list of available options
 options() ->
     [
-     tos, priority, reuseaddr, keepalive, dontroute, linger,
-     broadcast, sndbuf, recbuf, nodelay,
+     tos, priority, reuseaddr, reuseport, keepalive, dontroute, linger,
+     broadcast, sndbuf, recbuf, nodelay, nopush,
      buffer, header, active, packet, deliver, mode,
      multicast_if, multicast_ttl, multicast_loop,
      exit_on_close, high_watermark, low_watermark,
@@ -556,10 +562,10 @@ stats() ->
 %% Available options for tcp:connect
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 connect_options() ->
-    [tos, priority, reuseaddr, keepalive, linger, sndbuf, recbuf, nodelay,
-     header, active, packet, packet_size, buffer, mode, deliver,
-     exit_on_close, high_watermark, low_watermark, bit8, send_timeout,
-     send_timeout_close, delay_send,raw].
+    [tos, priority, reuseaddr, reuseport, keepalive, linger, sndbuf, recbuf,
+     nodelay, nopush, header, active, packet, packet_size, buffer, mode,
+     deliver, exit_on_close, high_watermark, low_watermark, bit8,
+     send_timeout, send_timeout_close, delay_send, delay_send_limit,raw].
     
 connect_options(Opts, Family) ->
     BaseOpts = 
@@ -612,10 +618,10 @@ con_add(Name, Val, R, Opts, AllOpts) ->
 %% Available options for tcp:listen
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 listen_options() ->
-    [tos, priority, reuseaddr, keepalive, linger, sndbuf, recbuf, nodelay,
-     header, active, packet, buffer, mode, deliver, backlog,
+    [tos, priority, reuseaddr, reuseport, keepalive, linger, sndbuf, recbuf,
+     nodelay, nopush, header, active, packet, buffer, mode, deliver, backlog,
      exit_on_close, high_watermark, low_watermark, bit8, send_timeout,
-     send_timeout_close, delay_send, packet_size,raw].
+     send_timeout_close, delay_send, delay_send_limit, packet_size,raw].
 
 listen_options(Opts, Family) ->
     BaseOpts = 
@@ -669,10 +675,10 @@ list_add(Name, Val, R, Opts, As) ->
 %% Available options for udp:open
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 udp_options() ->
-    [tos, priority, reuseaddr, sndbuf, recbuf, header, active, buffer, mode, 
-     deliver,
+    [tos, priority, reuseaddr, reuseport, sndbuf, recbuf, header, active,
+     buffer, mode, deliver,
      broadcast, dontroute, multicast_if, multicast_ttl, multicast_loop,
-     add_membership, drop_membership, read_packets,raw].
+     add_membership, drop_membership, read_packets, batch_packets, raw].
 
 
 udp_options(Opts, Family) ->
@@ -715,7 +721,7 @@ udp_add(Name, Val, R, Opts, As) ->
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 %  Currently supported options include:
 %  (*) {mode,   list|binary}	 or just list|binary
-%  (*) {active, true|false|once}
+%  (*) {active, true|false|once|N}
 %  (*) {sctp_module, inet_sctp|inet6_sctp} or just inet|inet6
 %  (*) options set via setsockopt.
 %      The full list is below in sctp_options/0 .
@@ -155,6 +155,7 @@ do_accept(Kernel, AcceptPid, Socket, MyNode, Allowed, SetupTime) ->
                               inet:setopts(S, 
                                            [{active, true},
                                             {deliver, port},
+                                            {mode, binary},
                                             {packet, 4},
                                             nodelay()])
                       end,
@@ -252,6 +253,7 @@ do_setup(Kernel, Node, Type, MyNode, LongOrShortNames,SetupTime) ->
                                         (S, 
                                          [{active, true},
                                           {deliver, port},
+                                          {mode, binary},
                                           {packet, 4},
                                           nodelay()])
                               end,
@@ -182,6 +182,7 @@ do_accept(Kernel, AcceptPid, Socket, MyNode, Allowed, SetupTime) ->
 			      inet:setopts(S, 
 					   [{active, true},
 					    {deliver, port},
+					    {mode, binary},
 					    {packet, 4},
 					    nodelay()])
 		      end,
@@ -190,7 +191,8 @@ do_accept(Kernel, AcceptPid, Socket, MyNode, Allowed, SetupTime) ->
 				end,
 		      f_address = fun get_remote_id/2,
 		      mf_tick = fun ?MODULE:tick/1,
-		      mf_getstat = fun ?MODULE:getstat/1
+		      mf_getstat = fun ?MODULE:getstat/1,
+		      stripes = stripes()
 		     },
 		    dist_util:handshake_other_started(HSData);
 		{false,IP} ->
@@ -215,6 +217,17 @@ nodelay() ->
 	_ ->
 	    {nodelay, true}
     end.
+
+%% The number of extra connections to set up to each node, besides
+%% the one of the connection owner.
+
+stripes() ->
+    case application:get_env(kernel, dist_stripes) of
+	{ok, N} when is_integer(N), N > 1 ->
+	    lists:min([N - 1, 16#ffff]);
+	_ ->
+	    0
+    end.
 	    
 
 %% ------------------------------------------------------------
@@ -284,6 +297,7 @@ do_setup(Kernel, Node, Type, MyNode, LongOrShortNames,SetupTime) ->
 					(S, 
 					 [{active, true},
 					  {deliver, port},
+					  {mode, binary},
 					  {packet, 4},
 					  nodelay()])
 			      end,
@@ -298,7 +312,14 @@ do_setup(Kernel, Node, Type, MyNode, LongOrShortNames,SetupTime) ->
 			      end,
 			      mf_tick = fun ?MODULE:tick/1,
 			      mf_getstat = fun ?MODULE:getstat/1,
-			      request_type = Type
+			      request_type = Type,
+			      stripes = stripes(),
+			      f_stripe =
+			      fun() ->
+				      inet_tcp:connect(Ip, TcpPort,
+						       [{active, false},
+							{packet,2}])
+			      end
 			     },
 			    dist_util:handshake_we_started(HSData);
 			_ ->
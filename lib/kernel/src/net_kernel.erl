@@ -636,6 +636,20 @@ handle_info({AcceptPid, {accept_pending,MyNode,Node,Address,Type}}, State) ->
 	    {noreply, State#state{conn_owners = Owners}}
     end;
 
+%%
+%% An extra connection (stripe) to a node asks for the pending
+%% connection that it should join.
+%%
+handle_info({StripePid, {stripe_pending, Node}}, State) ->
+    Reply = case ets:lookup(sys_dist, Node) of
+		[#connection{state = pending, owner = Owner}] ->
+		    Owner;
+		_ ->
+		    false
+	    end,
+    StripePid ! {self(), {stripe_pending, Reply}},
+    {noreply, State};
+
 handle_info({SetupPid, {is_pending, Node}}, State) ->
     Reply = lists:member({SetupPid,Node},State#state.conn_owners),
     SetupPid ! {self(), {is_pending, Reply}},